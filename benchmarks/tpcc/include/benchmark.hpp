@@ -0,0 +1,216 @@
+#pragma once
+
+#include <inttypes.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/tpcc/include/config.hpp"
+#include "benchmarks/tpcc/include/placement.hpp"
+#include "benchmarks/tpcc/include/tx_runner.hpp"
+#include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "protocols/common/memory_allocator.hpp"
+#include "utils/backoff.hpp"
+#include "utils/numa.hpp"
+#include "utils/options.hpp"
+#include "utils/profiler.hpp"
+#include "utils/utils.hpp"
+
+/**
+ * Setup, worker threads and report shared by the TPC-C executables, which only differ in the
+ * Index and Protocol they instantiate and in the loop their workers run:
+ *
+ *     Benchmark bench(argc, argv, "[batch=<transactions per epoch>] ", Benchmark::NO_RETRY);
+ *     ... load the tables ...
+ *     EpochManager<Protocol> em(bench.num_threads, 40);
+ *     bench.run(em, [&](uint32_t worker_id, ThreadLocalData& t_data) {
+ *         ... while (bench.is_running()) run transactions ...
+ *     });
+ *     bench.report();
+ */
+class Benchmark {
+public:
+    // Protocols that retry aborted transactions take the backoff options and report retries
+    enum RetryPolicy { RETRY, NO_RETRY };
+
+    uint16_t num_warehouses;
+    int num_threads;
+    int seconds;
+
+    // Parses "num_warehouses num_threads seconds [key=value ...]" and sets up the thread pinning,
+    // pages, arenas, workload and backoff. extra_usage lists the options of the executable.
+    Benchmark(int argc, const char* argv[], const char* extra_usage, RetryPolicy retry = RETRY)
+        : retry(retry)
+        , opts(argc, argv, argc < 4 ? argc : 4) {
+        if (argc < 4) {
+            printf(
+                "num_warehouses num_threads seconds [pin=none|compact|scatter|<cpu list>] "
+                "[arena=<MiB per node>] [hugepages=none|2m|1g] [huge_gib=<1GiB pages>] "
+                "[remote=<%% of remote NewOrder>] [remote_payment=<%% of remote Payment>] "
+                "[home=<home warehouses per thread>] [home_theta=<zipf theta over them>] "
+                "[point_index=masstree|hash|btree|art] [range_index=masstree|btree|art] %s%s\n",
+                extra_usage,
+                retry == RETRY
+                    ? "[backoff=none|exp|random|count] [backoff_base=<cycles>] "
+                      "[backoff_max=<cycles>]"
+                    : "");
+            exit(1);
+        }
+
+        num_warehouses = static_cast<uint16_t>(std::stoi(argv[1], nullptr, 10));
+        num_threads = std::stoi(argv[2], nullptr, 10);
+        seconds = std::stoi(argv[3], nullptr, 10);
+
+        assert(seconds > 0);
+
+        ThreadPinning& pinning = get_thread_pinning();
+        pinning.configure(opts.get("pin", "none"), num_threads);
+        pinning.print();
+
+        MemoryAllocator::configure_pages(
+            opts.get("hugepages", "none"), opts.get_int("huge_gib", 0));
+
+        size_t arena_mib = opts.get_int("arena", 0);
+        if (arena_mib > 0) {
+            const CpuTopology& topo = CpuTopology::get();
+            for (size_t node = 0; node < topo.get_num_nodes(); node++) {
+                MemoryAllocator::reserve_node_arena(topo.get_node_id(node), arena_mib << 20);
+            }
+        }
+
+        Config& c = get_mutable_config();
+        c.set_num_warehouses(num_warehouses);
+        c.set_num_threads(num_threads);
+        c.enable_fixed_warehouse_per_thread();
+        c.set_workload_options(opts);
+        printf(
+            "Remote NewOrder %u%%, remote Payment %u%%, %u home warehouse(s) per thread "
+            "(theta %.2f)\n",
+            c.get_remote_neworder_percent(), c.get_remote_payment_percent(),
+            c.get_home_warehouses(), c.get_warehouse_theta());
+
+        if (retry == RETRY) {
+            Backoff::configure(
+                opts.get("backoff", "none"), opts.get_int("backoff_base", 1000),
+                opts.get_int("backoff_max", 1000000));
+            printf("Backoff before retries: %s\n", Backoff::get_policy_name().c_str());
+        }
+    }
+
+    const Options& get_options() const { return opts; }
+
+    bool is_running() const { return __atomic_load_n(&flag, __ATOMIC_ACQUIRE); }
+
+    /**
+     * Runs worker(worker_id, t_data) on num_threads threads while manager.start(seconds) runs.
+     * Each thread is pinned before its ThreadLocalData is allocated so that it is placed on the
+     * local NUMA node. The worker is expected to return once is_running() turns false.
+     */
+    template <typename Manager, typename WorkerFunc>
+    void run(Manager& manager, WorkerFunc&& worker) {
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads);
+        t_data.resize(num_threads);
+
+        for (int i = 0; i < num_threads; i++) {
+            threads.emplace_back([this, i, &worker] {
+                uint32_t worker_id = i;
+                get_thread_pinning().pin(worker_id);
+                t_data[i] = std::make_unique<ThreadLocalData>();
+                worker(worker_id, *t_data[i]);
+            });
+        }
+
+        manager.start(seconds);
+
+        __atomic_store_n(&flag, 0, __ATOMIC_RELEASE);
+
+        for (int i = 0; i < num_threads; i++) {
+            threads[i].join();
+        }
+    }
+
+    // Prints the statistics of all workers. print_summary prints additional lines of the summary.
+    template <typename PrintSummary>
+    void report(PrintSummary&& print_summary) const {
+        Stat stat;
+        for (int i = 0; i < num_threads; i++) {
+            stat.add(t_data[i]->stat);
+        }
+        Stat::PerTxType total = stat.aggregate_perf();
+
+        printf(
+            "%d warehouse(s), %d thread(s), %d second(s)\n", num_warehouses, num_threads,
+            seconds);
+        printf("    commits: %lu\n", total.num_commits);
+        printf("    usr_aborts: %lu\n", total.num_usr_aborts);
+        printf("    sys_aborts: %lu\n", total.num_sys_aborts);
+        if (retry == RETRY) {
+            printf("    retries/commit: %.3f\n", total.num_sys_aborts / (double)total.num_commits);
+            printf(
+                "    backoff/commit: %.0f cycles\n",
+                total.total_backoff / (double)total.num_commits);
+        }
+        printf("Throughput: %lu txns/s\n", total.num_commits / seconds);
+        print_summary();
+
+        printf("\nDetails:\n");
+        constexpr_for<TxProfileID::MAX>([&](auto i) {
+            constexpr auto p = static_cast<TxProfileID>(i.value);
+            using Profile = TxProfile<p>;
+            double tries = stat[p].num_commits + stat[p].num_usr_aborts + stat[p].num_sys_aborts;
+            printf(
+                "    %-11s c[%.2f%%]:%10lu(%.2f%%)   ua:%10lu(%.2f%%)  sa:%10lu(%.2f%%)  "
+                "avgl:%10.0lf  minl:%10" PRIu64 "  maxl:%10" PRIu64 "\n",
+                Profile::name, stat[p].num_commits / (double)total.num_commits,
+                stat[p].num_commits, stat[p].num_commits / tries, stat[p].num_usr_aborts,
+                stat[p].num_usr_aborts / tries, stat[p].num_sys_aborts,
+                stat[p].num_sys_aborts / tries,
+                stat[p].total_latency / (double)stat[p].num_commits, stat[p].min_latency,
+                stat[p].max_latency);
+        });
+
+        if (is_warehouse_placement_enabled()) {
+            printf("\nRemote Warehouse Accesses:\n");
+            constexpr_for<TxProfileID::MAX>([&](auto i) {
+                constexpr auto p = static_cast<TxProfileID>(i.value);
+                using Profile = TxProfile<p>;
+                size_t local = stat[p].num_local_accesses;
+                size_t remote = stat[p].num_remote_accesses;
+                printf(
+                    "    %-11s local:%10lu  remote:%10lu(%.2f%%)\n", Profile::name, local,
+                    remote, local + remote ? 100.0 * remote / (local + remote) : 0.0);
+            });
+        }
+
+        printf("\nSystem Abort Details:\n");
+        constexpr_for<TxProfileID::MAX>([&](auto i) {
+            constexpr auto p = static_cast<TxProfileID>(i.value);
+            using Profile = TxProfile<p>;
+            printf("    %-11s\n", Profile::name);
+            constexpr_for<Profile::AbortID::MAX>([&](auto j) {
+                constexpr auto a = static_cast<typename Profile::AbortID>(j.value);
+                printf(
+                    "        %-45s: %lu\n", Profile::template abort_reason<a>(),
+                    stat[p].abort_details[a]);
+            });
+        });
+
+        PROFILE_PRINT();
+    }
+
+    void report() const {
+        report([] {});
+    }
+
+private:
+    RetryPolicy retry;
+    Options opts;
+    alignas(64) int flag = 1;
+    std::vector<std::unique_ptr<ThreadLocalData>> t_data;
+};
@@ -2,6 +2,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "indexes/index_interface.hpp"
+#include "utils/options.hpp"
 
 class Config {
 public:
@@ -15,14 +20,79 @@ public:
     void enable_random_abort() { does_random_abort = true; }
     bool get_random_abort_flag() const { return does_random_abort; }
 
+    // Each thread runs transactions on its home warehouses (see set_home_warehouses()) instead
+    // of picking one of all warehouses uniformly
     void enable_fixed_warehouse_per_thread() { fixed_ware = true; }
     bool get_fixed_warehouse_flag() const { return fixed_ware; }
 
+    // Thread t has the n warehouses following warehouse t * n (wrapping around) as home
+    // warehouses, and picks one of them with zipfian skew theta (0: uniform) per transaction.
+    // The first warehouse of the set is the most frequent one.
+    void set_home_warehouses(long n, double theta) {
+        if (n <= 0 || n > num_warehouses) throw std::runtime_error("invalid home warehouses");
+        if (theta < 0 || theta >= 1) throw std::runtime_error("warehouse theta must be in [0, 1)");
+        home_warehouses = n;
+        warehouse_theta = theta;
+    }
+    uint16_t get_home_warehouses() const { return home_warehouses; }
+    double get_warehouse_theta() const { return warehouse_theta; }
+
+    // Percentage of NewOrder transactions with items supplied by remote warehouses
+    void set_remote_neworder_percent(long p) {
+        if (p < 0 || p > 100) throw std::runtime_error("invalid remote NewOrder percentage");
+        remote_neworder_percent = p;
+    }
+    uint8_t get_remote_neworder_percent() const { return remote_neworder_percent; }
+
+    // Percentage of Payment transactions paid by customers of remote warehouses
+    void set_remote_payment_percent(long p) {
+        if (p < 0 || p > 100) throw std::runtime_error("invalid remote Payment percentage");
+        remote_payment_percent = p;
+    }
+    uint8_t get_remote_payment_percent() const { return remote_payment_percent; }
+
+    // Index of Item, Warehouse, District, Customer and Stock, which are only accessed by exact
+    // key and can thus also be stored in hash indexes (see select_table_indexes())
+    void set_point_index(const std::string& name) { point_index = parse_index_backend(name); }
+    IndexBackend get_point_index() const { return point_index; }
+
+    // Index of the other tables, which are scanned
+    void set_range_index(const std::string& name) {
+        IndexBackend backend = parse_index_backend(name);
+        if (backend == IndexBackend::HASH) throw std::runtime_error("range_index cannot be hash");
+        range_index = backend;
+    }
+    IndexBackend get_range_index() const { return range_index; }
+
+    // Workload options of the executables:
+    //   remote=<%>          remote NewOrder transactions (default 1)
+    //   remote_payment=<%>  remote Payment transactions (default 15)
+    //   home=<n>            home warehouses per thread (default 1)
+    //   home_theta=<theta>  zipfian skew among the home warehouses (default 0)
+    //   point_index=<kind>  index of the exact-key tables: masstree, hash, btree or art
+    //                       (default masstree)
+    //   range_index=<kind>  index of the scanned tables: masstree, btree or art (default
+    //                       masstree); art keeps the leaves of removed keys until exit
+    void set_workload_options(const Options& opts) {
+        set_remote_neworder_percent(opts.get_int("remote", remote_neworder_percent));
+        set_remote_payment_percent(opts.get_int("remote_payment", remote_payment_percent));
+        set_home_warehouses(
+            opts.get_int("home", home_warehouses), opts.get_double("home_theta", warehouse_theta));
+        if (opts.has("point_index")) set_point_index(opts.get("point_index", ""));
+        if (opts.has("range_index")) set_range_index(opts.get("range_index", ""));
+    }
+
 private:
     size_t num_threads = 1;
     uint16_t num_warehouses = 1;
     bool does_random_abort = false;
     bool fixed_ware = false;
+    uint16_t home_warehouses = 1;
+    double warehouse_theta = 0;
+    uint8_t remote_neworder_percent = 1;
+    uint8_t remote_payment_percent = 15;
+    IndexBackend point_index = IndexBackend::MASSTREE;
+    IndexBackend range_index = IndexBackend::MASSTREE;
 };
 
 inline Config& get_mutable_config() {
@@ -7,6 +7,7 @@
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 #include "utils/tsc.hpp"
 
@@ -77,7 +78,7 @@ public:
     }
 
     template <typename Transaction>
-    Status run(Transaction& tx, Stat& stat, Output& out) {
+    MaybeTask<Status> run(Transaction& tx, Stat& stat, Output& out) {
         uint64_t start, end;
         start = rdtscp();
         typename Transaction::Result res;
@@ -94,24 +95,24 @@ public:
             res = tx.get_neworder_with_smallest_key_no_less_than(no, no_low);
             if (res == Transaction::Result::FAIL) continue;
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, GET_NEWORDER_WITH_SMALLEST_KEY);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_NEWORDER_WITH_SMALLEST_KEY);
             res =
                 tx.template prepare_record_for_delete<NewOrder>(no, NewOrder::Key::create_key(*no));
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, DELETE_NEWORDER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, DELETE_NEWORDER);
             res = tx.finish_delete(no);
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, FINISH_DELETE_NEWORDER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_DELETE_NEWORDER);
 
-            Order* o;
+            Order* o = nullptr;
             Order::Key o_key = Order::Key::create_key(w_id, d_id, no->no_o_id);
-            res = tx.prepare_record_for_update(o, o_key);
+            res = CO_AWAIT(tx.prepare_record_for_update(o, o_key));
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_ORDER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_UPDATE_ORDER);
             o->o_carrier_id = o_carrier_id;
             res = tx.finish_update(o);
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_ORDER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_ORDER);
 
             double total_ol_amount = 0.0;
             OrderLine::Key o_low = OrderLine::Key::create_key(o->o_w_id, o->o_d_id, o->o_id, 1);
@@ -122,22 +123,22 @@ public:
                     total_ol_amount += ol.ol_amount;
                 });
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, RANGE_UPDATE_ORDERLINE);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, RANGE_UPDATE_ORDERLINE);
 
-            Customer* c;
+            Customer* c = nullptr;
             Customer::Key c_key = Customer::Key::create_key(w_id, d_id, o->o_c_id);
-            res = tx.prepare_record_for_update(c, c_key);
+            res = CO_AWAIT(tx.prepare_record_for_update(c, c_key));
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_CUSTOMER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_UPDATE_CUSTOMER);
             c->c_balance += total_ol_amount;
             c->c_delivery_cnt += 1;
             res = tx.finish_update(c);
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_CUSTOMER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_CUSTOMER);
 
             out << d_id << o->o_id;
         }
         end = rdtscp();
-        return helper.commit(PRECOMMIT, end - start);
+        CO_RETURN helper.commit(PRECOMMIT, end - start);
     };
 };
@@ -7,6 +7,7 @@
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 #include "utils/tsc.hpp"
 
@@ -44,7 +45,7 @@ public:
             ol_cnt = urand_int(OrderLine::MIN_ORDLINES_PER_ORD, OrderLine::MAX_ORDLINES_PER_ORD);
             o_entry_d = get_timestamp();
             rbk = (urand_int(1, 100) == 1 ? 1 : 0);
-            is_remote = (urand_int(1, 100) == 1 ? 1 : 0);
+            is_remote = (urand_int(1, 100) <= c.get_remote_neworder_percent() ? 1 : 0);
             for (int i = 1; i <= ol_cnt; i++) {
                 if (i == ol_cnt && rbk) {
                     items[i - 1].ol_i_id = Item::UNUSED_ID; /* set to an unused value */
@@ -90,10 +91,11 @@ public:
         GET_ITEM = 8,
         PREPARE_UPDATE_STOCK = 9,
         FINISH_UPDATE_STOCK = 10,
-        PREPARE_INSERT_ORDERLINE = 11,
-        FINISH_INSERT_ORDERLINE = 12,
-        PRECOMMIT = 13,
-        MAX = 14,
+        GET_STOCK_DATA = 11,
+        PREPARE_INSERT_ORDERLINE = 12,
+        FINISH_INSERT_ORDERLINE = 13,
+        PRECOMMIT = 14,
+        MAX = 15,
     };
 
     template <AbortID a>
@@ -120,6 +122,8 @@ public:
             return "PREPARE_UPDATE_STOCK";
         else if constexpr (a == AbortID::FINISH_UPDATE_STOCK)
             return "FINISH_UPDATE_STOCK";
+        else if constexpr (a == AbortID::GET_STOCK_DATA)
+            return "GET_STOCK_DATA";
         else if constexpr (a == AbortID::PREPARE_INSERT_ORDERLINE)
             return "PREPARE_INSERT_ORDERLINE";
         else if constexpr (a == AbortID::FINISH_INSERT_ORDERLINE)
@@ -131,7 +135,7 @@ public:
     }
 
     template <typename Transaction>
-    Status run(Transaction& tx, Stat& stat, Output& out) {
+    MaybeTask<Status> run(Transaction& tx, Stat& stat, Output& out) {
         uint64_t start, end;
         start = rdtscp();
         typename Transaction::Result res;
@@ -148,26 +152,27 @@ public:
 
         const Warehouse* w = nullptr;
         Warehouse::Key w_key = Warehouse::Key::create_key(w_id);
-        res = tx.get_record(w, w_key);
+        // Only w_tax is used, so concurrent adds to w_ytd by Payment do not matter
+        res = CO_AWAIT(tx.get_record_ignoring_adds(w, w_key));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, GET_WAREHOUSE);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_WAREHOUSE);
 
         District* d = nullptr;
         District::Key d_key = District::Key::create_key(w_id, d_id);
-        res = tx.prepare_record_for_update(d, d_key);
+        res = CO_AWAIT(tx.prepare_record_for_update(d, d_key));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_DISTRICT);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_UPDATE_DISTRICT);
         uint32_t o_id = d->d_next_o_id;
         d->d_next_o_id++;
         res = tx.finish_update(d);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_DISTRICT);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_DISTRICT);
 
         const Customer* c = nullptr;
         Customer::Key c_key = Customer::Key::create_key(w_id, d_id, c_id);
-        res = tx.get_record(c, c_key);
+        res = CO_AWAIT(tx.get_record(c, c_key));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, GET_CUSTOMER);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_CUSTOMER);
 
         out << c->c_last << c->c_credit << c->c_discount << w->w_tax << d->d_tax << ol_cnt
             << d->d_next_o_id << o_entry_d;
@@ -176,44 +181,66 @@ public:
         NewOrder::Key no_key = NewOrder::Key::create_key(w_id, d_id, o_id);
         res = tx.prepare_record_for_insert(no, no_key);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_INSERT_NEWORDER);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_INSERT_NEWORDER);
         create_neworder(*no, w_id, d_id, o_id);
         res = tx.finish_insert(no);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_INSERT_NEWORDER);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_INSERT_NEWORDER);
 
         Order* o = nullptr;
         Order::Key o_key = Order::Key::create_key(w_id, d_id, o_id);
         res = tx.prepare_record_for_insert(o, o_key);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_INSERT_ORDER);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_INSERT_ORDER);
         create_order(*o, w_id, d_id, c_id, o_id, ol_cnt, is_remote);
         res = tx.finish_insert(o);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_INSERT_ORDER);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_INSERT_ORDER);
 
         double total = 0;
 
+        // Items and stocks are looked up in batches so that their index lookups overlap
+        Item::Key i_keys[OrderLine::MAX_ORDLINES_PER_ORD];
+        Stock::Key s_keys[OrderLine::MAX_ORDLINES_PER_ORD];
         for (uint8_t ol_num = 1; ol_num <= ol_cnt; ol_num++) {
-            uint16_t ol_supply_w_id = input.items[ol_num - 1].ol_supply_w_id;
             uint32_t ol_i_id = input.items[ol_num - 1].ol_i_id;
-            uint8_t ol_quantity = input.items[ol_num - 1].ol_quantity;
+            if (ol_i_id == Item::UNUSED_ID) CO_RETURN helper.usr_abort();
+            i_keys[ol_num - 1] = Item::Key::create_key(ol_i_id);
+            s_keys[ol_num - 1] =
+                Stock::Key::create_key(input.items[ol_num - 1].ol_supply_w_id, ol_i_id);
+        }
 
-            if (ol_i_id == Item::UNUSED_ID) return helper.usr_abort();
+        const Item* items[OrderLine::MAX_ORDLINES_PER_ORD];
+        res = CO_AWAIT(tx.get_records_batch(ol_cnt, i_keys, items));
+        LOG_TRACE("res: %d", static_cast<int>(res));
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_ITEM);
 
-            const Item* i = nullptr;
-            Item::Key i_key = Item::Key::create_key(ol_i_id);
-            res = tx.get_record(i, i_key);
-            LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, GET_ITEM);
+        // An item ordered twice gets the same stock copy, which is modified once per order line
+        Stock* stocks[OrderLine::MAX_ORDLINES_PER_ORD];
+        res = CO_AWAIT(tx.prepare_records_for_update_batch(ol_cnt, s_keys, stocks));
+        LOG_TRACE("res: %d", static_cast<int>(res));
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_UPDATE_STOCK);
+
+#if TPCC_HOT_COLD_SPLIT
+        // s_dist and s_data are read-only and live in a separate table
+        const StockData* stock_data[OrderLine::MAX_ORDLINES_PER_ORD];
+        res = CO_AWAIT(tx.get_records_batch(ol_cnt, s_keys, stock_data));
+        LOG_TRACE("res: %d", static_cast<int>(res));
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_STOCK_DATA);
+#else
+        Stock** stock_data = stocks;
+#endif
+
+        for (uint8_t ol_num = 1; ol_num <= ol_cnt; ol_num++) {
+            uint16_t ol_supply_w_id = input.items[ol_num - 1].ol_supply_w_id;
+            uint32_t ol_i_id = input.items[ol_num - 1].ol_i_id;
+            uint8_t ol_quantity = input.items[ol_num - 1].ol_quantity;
+            const Item* i = items[ol_num - 1];
+            Stock* s = stocks[ol_num - 1];
+            const auto* sd = stock_data[ol_num - 1];
 
-            Stock* s;
-            Stock::Key s_key = Stock::Key::create_key(ol_supply_w_id, ol_i_id);
-            res = tx.prepare_record_for_update(s, s_key);
-            LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_STOCK);
             char brand_generic;
-            if (strstr(i->i_data, "ORIGINAL") && strstr(s->s_data, "ORIGINAL")) {
+            if (strstr(i->i_data, "ORIGINAL") && strstr(sd->s_data, "ORIGINAL")) {
                 brand_generic = 'B';
             } else {
                 brand_generic = 'G';
@@ -221,7 +248,7 @@ public:
             modify_stock(*s, ol_quantity, is_remote);
             res = tx.finish_update(s);
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_STOCK);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_STOCK);
 
             double ol_amount = ol_quantity * i->i_price;
             total += ol_amount;
@@ -230,12 +257,13 @@ public:
             OrderLine::Key ol_key = OrderLine::Key::create_key(w_id, d_id, o_id, ol_num);
             res = tx.prepare_record_for_insert(ol, ol_key);
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_INSERT_ORDERLINE);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_INSERT_ORDERLINE);
             create_orderline(
-                *ol, w_id, d_id, o_id, ol_num, ol_i_id, ol_supply_w_id, ol_quantity, ol_amount, *s);
+                *ol, w_id, d_id, o_id, ol_num, ol_i_id, ol_supply_w_id, ol_quantity, ol_amount,
+                sd->s_dist[d_id - 1]);
             res = tx.finish_insert(ol);
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, FINISH_INSERT_ORDERLINE);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_INSERT_ORDERLINE);
 
             out << ol_supply_w_id << ol_i_id << i->i_name << ol_quantity << s->s_quantity
                 << brand_generic << i->i_price << ol_amount;
@@ -244,7 +272,7 @@ public:
         total *= (1 - c->c_discount) * (1 + w->w_tax + d->d_tax);
         out << total;
         end = rdtscp();
-        return helper.commit(PRECOMMIT, end - start);
+        CO_RETURN helper.commit(PRECOMMIT, end - start);
     }
 
 private:
@@ -269,7 +297,7 @@ private:
 
     void create_orderline(
         OrderLine& ol, uint16_t w_id, uint8_t d_id, uint32_t o_id, uint8_t ol_num, uint32_t ol_i_id,
-        uint16_t ol_supply_w_id, uint8_t ol_quantity, double ol_amount, const Stock& s) {
+        uint16_t ol_supply_w_id, uint8_t ol_quantity, double ol_amount, const char* dist_info) {
         ol.ol_w_id = w_id;
         ol.ol_d_id = d_id;
         ol.ol_o_id = o_id;
@@ -279,7 +307,7 @@ private:
         ol.ol_delivery_d = 0;
         ol.ol_quantity = ol_quantity;
         ol.ol_amount = ol_amount;
-        copy_cstr(ol.ol_dist_info, s.s_dist[d_id - 1], sizeof(ol.ol_dist_info));
+        copy_cstr(ol.ol_dist_info, dist_info, sizeof(ol.ol_dist_info));
     }
 
     void modify_stock(Stock& s, uint8_t ol_quantity, bool is_remote) {
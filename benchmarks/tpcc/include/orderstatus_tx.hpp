@@ -8,6 +8,7 @@
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 #include "utils/tsc.hpp"
 
@@ -80,7 +81,7 @@ public:
     }
 
     template <typename Transaction>
-    Status run(Transaction& tx, Stat& stat, Output& out) {
+    MaybeTask<Status> run(Transaction& tx, Stat& stat, Output& out) {
         uint64_t start, end;
         start = rdtscp();
         typename Transaction::Result res;
@@ -99,23 +100,23 @@ public:
         if (by_last_name) {
             LOG_TRACE("c_last: %s", c_last);
             assert(c_id == Customer::UNUSED_ID);
-            res = tx.get_customer_by_last_name(c, c_w_id, c_d_id, c_last);
+            res = CO_AWAIT(tx.get_customer_by_last_name(c, c_w_id, c_d_id, c_last));
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, GET_CUSTOMER_BY_LAST_NAME);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_CUSTOMER_BY_LAST_NAME);
         } else {
             assert(c_id != Customer::UNUSED_ID);
-            res = tx.get_record(c, Customer::Key::create_key(c_w_id, c_d_id, c_id));
+            res = CO_AWAIT(tx.get_record(c, Customer::Key::create_key(c_w_id, c_d_id, c_id)));
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, GET_CUSTOMER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_CUSTOMER);
         }
 
         c_id = c->c_id;
         out << c->c_first << c->c_middle << c->c_last << c->c_balance;
 
         const Order* o = nullptr;
-        res = tx.get_order_by_customer_id(o, c_w_id, c_d_id, c_id);
+        res = CO_AWAIT(tx.get_order_by_customer_id(o, c_w_id, c_d_id, c_id));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, GET_ORDER_BY_CUSTOMER_ID);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_ORDER_BY_CUSTOMER_ID);
 
         out << o->o_id << o->o_entry_d << o->o_carrier_id;
 
@@ -128,9 +129,9 @@ public:
         });
 
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, RANGE_GET_ORDERLINE);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, RANGE_GET_ORDERLINE);
 
         end = rdtscp();
-        return helper.commit(PRECOMMIT, end - start);
+        CO_RETURN helper.commit(PRECOMMIT, end - start);
     }
 };
@@ -3,11 +3,13 @@
 #include <inttypes.h>
 
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 #include "utils/tsc.hpp"
 
@@ -39,7 +41,7 @@ public:
             d_id = urand_int(1, District::DISTS_PER_WARE);
             h_amount = urand_double(100, 500000, 100);
             h_date = get_timestamp();
-            if (num_warehouses == 1 || urand_int(1, 100) <= 85) {
+            if (num_warehouses == 1 || urand_int(1, 100) > c.get_remote_payment_percent()) {
                 c_w_id = w_id;
                 c_d_id = d_id;
             } else {
@@ -74,31 +76,33 @@ public:
     } input;
 
     enum AbortID : uint8_t {
-        PREPARE_UPDATE_WAREHOUSE = 0,
-        FINISH_UPDATE_WAREHOUSE = 1,
-        PREPARE_UPDATE_DISTRICT = 2,
-        FINISH_UPDATE_DISTRICT = 3,
+        ADD_WAREHOUSE_YTD = 0,
+        GET_WAREHOUSE = 1,
+        ADD_DISTRICT_YTD = 2,
+        GET_DISTRICT = 3,
         PREPARE_UPDATE_CUSTOMER_BY_LAST_NAME = 4,
         PREPARE_UPDATE_CUSTOMER = 5,
         FINISH_UPDATE_CUSTOMER = 6,
         PREPARE_INSERT_HISTORY = 7,
         FINISH_INSERT_HISTORY = 8,
         PRECOMMIT = 9,
-        MAX = 10
+        PREPARE_UPDATE_CUSTOMER_DATA = 10,
+        FINISH_UPDATE_CUSTOMER_DATA = 11,
+        MAX = 12
     };
 
     template <AbortID a>
     static constexpr const char* abort_reason() {
         if constexpr (a == AbortID::PRECOMMIT)
             return "PRECOMMIT";
-        else if constexpr (a == AbortID::PREPARE_UPDATE_WAREHOUSE)
-            return "PREPARE_UPDATE_WAREHOUSE";
-        else if constexpr (a == AbortID::FINISH_UPDATE_WAREHOUSE)
-            return "FINISH_UPDATE_WAREHOUSE";
-        else if constexpr (a == AbortID::PREPARE_UPDATE_DISTRICT)
-            return "PREPARE_UPDATE_DISTRICT";
-        else if constexpr (a == AbortID::FINISH_UPDATE_DISTRICT)
-            return "FINISH_UPDATE_DISTRICT";
+        else if constexpr (a == AbortID::ADD_WAREHOUSE_YTD)
+            return "ADD_WAREHOUSE_YTD";
+        else if constexpr (a == AbortID::GET_WAREHOUSE)
+            return "GET_WAREHOUSE";
+        else if constexpr (a == AbortID::ADD_DISTRICT_YTD)
+            return "ADD_DISTRICT_YTD";
+        else if constexpr (a == AbortID::GET_DISTRICT)
+            return "GET_DISTRICT";
         else if constexpr (a == AbortID::PREPARE_UPDATE_CUSTOMER_BY_LAST_NAME)
             return "PREPARE_UPDATE_CUSTOMER_BY_LAST_NAME";
         else if constexpr (a == AbortID::PREPARE_UPDATE_CUSTOMER)
@@ -109,12 +113,16 @@ public:
             return "PREPARE_INSERT_HISTORY";
         else if constexpr (a == AbortID::FINISH_INSERT_HISTORY)
             return "FINISH_INSERT_HISTORY";
+        else if constexpr (a == AbortID::PREPARE_UPDATE_CUSTOMER_DATA)
+            return "PREPARE_UPDATE_CUSTOMER_DATA";
+        else if constexpr (a == AbortID::FINISH_UPDATE_CUSTOMER_DATA)
+            return "FINISH_UPDATE_CUSTOMER_DATA";
         else
             static_assert(false_v<a>, "undefined abort reason");
     }
 
     template <typename Transaction>
-    Status run(Transaction& tx, Stat& stat, Output& out) {
+    MaybeTask<Status> run(Transaction& tx, Stat& stat, Output& out) {
         uint64_t start, end;
         start = rdtscp();
         typename Transaction::Result res;
@@ -132,40 +140,42 @@ public:
 
         out << w_id << d_id;
 
-        Warehouse* w;
+        // w_ytd and d_ytd are commutative adds, so concurrent Payments to the same warehouse and
+        // district do not conflict. Only their name and address are read.
         Warehouse::Key w_key = Warehouse::Key::create_key(w_id);
-        res = tx.prepare_record_for_update(w, w_key);
+        res = tx.template add_to_field<Warehouse>(w_key, offsetof(Warehouse, w_ytd), h_amount);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_WAREHOUSE);
-        w->w_ytd += h_amount;
-        res = tx.finish_update(w);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, ADD_WAREHOUSE_YTD);
+        const Warehouse* w = nullptr;
+        res = CO_AWAIT(tx.get_record_ignoring_adds(w, w_key));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_WAREHOUSE);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_WAREHOUSE);
 
-        District* d;
         District::Key d_key = District::Key::create_key(w_id, d_id);
-        res = tx.prepare_record_for_update(d, d_key);
+        res = tx.template add_to_field<District>(d_key, offsetof(District, d_ytd), h_amount);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_DISTRICT);
-        d->d_ytd += h_amount;
-        res = tx.finish_update(d);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, ADD_DISTRICT_YTD);
+        const District* d = nullptr;
+        res = CO_AWAIT(tx.get_record_ignoring_adds(d, d_key));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_DISTRICT);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_DISTRICT);
 
         Customer* c = nullptr;
         LOG_TRACE("by_last_name %s", by_last_name ? "true" : "false");
         if (by_last_name) {
             LOG_TRACE("c_last: %s", c_last);
             assert(c_id == Customer::UNUSED_ID);
-            res = tx.get_customer_by_last_name_and_prepare_for_update(c, c_w_id, c_d_id, c_last);
+            res = CO_AWAIT(
+                tx.get_customer_by_last_name_and_prepare_for_update(c, c_w_id, c_d_id, c_last));
             LOG_TRACE("res: %d", static_cast<int>(res));
             if (not_succeeded(tx, res))
-                return helper.kill(res, PREPARE_UPDATE_CUSTOMER_BY_LAST_NAME);
+                CO_RETURN helper.kill(res, PREPARE_UPDATE_CUSTOMER_BY_LAST_NAME);
         } else {
             assert(c_id != Customer::UNUSED_ID);
-            res = tx.prepare_record_for_update(c, Customer::Key::create_key(c_w_id, c_d_id, c_id));
+            res = CO_AWAIT(tx.prepare_record_for_update(
+                c, Customer::Key::create_key(c_w_id, c_d_id, c_id)));
             LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_UPDATE_CUSTOMER);
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_UPDATE_CUSTOMER);
         }
         c_id = c->c_id;
 
@@ -179,39 +189,61 @@ public:
         c->c_ytd_payment += h_amount;
         c->c_payment_cnt += 1;
 
-        if (c->c_credit[0] == 'B' && c->c_credit[1] == 'C') {
+        bool bad_credit = c->c_credit[0] == 'B' && c->c_credit[1] == 'C';
+#if TPCC_HOT_COLD_SPLIT
+        res = tx.finish_update(c);
+        LOG_TRACE("res: %d", static_cast<int>(res));
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_CUSTOMER);
+
+        // c_data lives in a separate table and is only touched for customers with bad credit
+        if (bad_credit) {
+            CustomerData* cd = nullptr;
+            res = CO_AWAIT(tx.prepare_record_for_update(
+                cd, CustomerData::Key::create_key(c_w_id, c_d_id, c_id)));
+            LOG_TRACE("res: %d", static_cast<int>(res));
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_UPDATE_CUSTOMER_DATA);
+            out << cd->c_data;
+            modify_customer_data(cd->c_data, c_id, w_id, d_id, c_w_id, c_d_id, h_amount);
+            res = tx.finish_update(cd);
+            LOG_TRACE("res: %d", static_cast<int>(res));
+            if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_CUSTOMER_DATA);
+        }
+#else
+        if (bad_credit) {
             out << c->c_data;
-            modify_customer_data(*c, w_id, d_id, c_w_id, c_d_id, h_amount);
+            modify_customer_data(c->c_data, c_id, w_id, d_id, c_w_id, c_d_id, h_amount);
         }
         res = tx.finish_update(c);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_UPDATE_CUSTOMER);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_UPDATE_CUSTOMER);
+#endif
 
         History* h = nullptr;
         res = tx.prepare_record_for_insert(h);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, PREPARE_INSERT_HISTORY);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, PREPARE_INSERT_HISTORY);
         create_history(*h, w_id, d_id, c_id, c_w_id, c_d_id, h_amount, w->w_name, d->d_name);
         res = tx.finish_insert(h);
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, FINISH_INSERT_HISTORY);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, FINISH_INSERT_HISTORY);
 
         end = rdtscp();
-        return helper.commit(PRECOMMIT, end - start);
+        CO_RETURN helper.commit(PRECOMMIT, end - start);
     }
 
 private:
+    // c_data holds Customer::MAX_DATA + 1 bytes
     void modify_customer_data(
-        Customer& c, uint16_t w_id, uint8_t d_id, uint16_t c_w_id, uint8_t c_d_id,
+        char* c_data, uint32_t c_id, uint16_t w_id, uint8_t d_id, uint16_t c_w_id, uint8_t c_d_id,
         double h_amount) {
         char new_data[Customer::MAX_DATA + 1];
         size_t len = snprintf(
             &new_data[0], Customer::MAX_DATA + 1,
-            "| %4" PRIu32 " %2" PRIu8 " %4" PRIu16 " %2" PRIu16 " %4" PRIu16 " $%7.2f", c.c_id,
+            "| %4" PRIu32 " %2" PRIu8 " %4" PRIu16 " %2" PRIu16 " %4" PRIu16 " $%7.2f", c_id,
             c_d_id, c_w_id, d_id, w_id, h_amount);
         assert(len <= Customer::MAX_DATA);
-        copy_cstr(&new_data[len], &c.c_data[0], sizeof(new_data) - len);
-        copy_cstr(c.c_data, new_data, sizeof(c.c_data));
+        copy_cstr(&new_data[len], c_data, sizeof(new_data) - len);
+        copy_cstr(c_data, new_data, Customer::MAX_DATA + 1);
     }
 
     void create_history(
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmarks/tpcc/include/config.hpp"
+#include "utils/numa.hpp"
+#include "utils/utils.hpp"
+
+// Home warehouse of the next transaction of worker thread_id (see Config::set_home_warehouses())
+inline uint16_t get_home_warehouse(uint32_t thread_id) {
+    const Config& c = get_config();
+    uint16_t num_warehouses = c.get_num_warehouses();
+    if (!c.get_fixed_warehouse_flag()) return urand_int(1, num_warehouses);
+    size_t n = c.get_home_warehouses();
+    size_t i = 0;
+    if (n > 1 && c.get_warehouse_theta() == 0) {
+        i = urand_int(0, n - 1);
+    } else if (n > 1) {
+        thread_local FastZipf zipf(get_rand(), c.get_warehouse_theta(), n);
+        i = std::min(zipf(), n - 1);
+    }
+    return (thread_id * n + i) % num_warehouses + 1;
+}
+
+/**
+ * NUMA placement of warehouses.
+ * When workers are pinned and each works on fixed home warehouses, warehouse w_id is loaded
+ * by loader ((w_id - 1) / home_warehouses) % num_loaders, which runs on the cpu of the worker
+ * with the same id, so that its warehouse-local records (stock, district, customer, order,
+ * ...) are placed on the node of the worker using it as home warehouse. The item table is
+ * shared and not partitioned.
+ */
+inline bool is_warehouse_placement_enabled() {
+    return get_thread_pinning().is_enabled() && get_config().get_fixed_warehouse_flag();
+}
+
+inline size_t get_num_warehouse_loaders() {
+    const Config& c = get_config();
+    size_t n = c.get_home_warehouses();
+    return std::min<size_t>((c.get_num_warehouses() + n - 1) / n, c.get_num_threads());
+}
+
+inline size_t get_warehouse_loader(uint16_t w_id) {
+    return (w_id - 1) / get_config().get_home_warehouses() % get_num_warehouse_loaders();
+}
+
+// -1 if warehouses are not placed
+inline int get_warehouse_node(uint16_t w_id) {
+    if (!is_warehouse_placement_enabled()) return -1;
+    return get_thread_pinning().get_node(get_warehouse_loader(w_id));
+}
@@ -4,11 +4,22 @@
 #include <cstdint>
 #include <cstring>
 #include <ctime>
+#include <stdexcept>
 #include <string_view>
 #include <type_traits>
 
 #include "utils/utils.hpp"
 
+/**
+ * With -DTPCC_HOT_COLD_SPLIT=1 (cmake -DTPCC_HOT_COLD_SPLIT=ON), the rarely written columns of
+ * Stock and Customer are moved into StockData and CustomerData, which are stored in tables of
+ * their own under the same keys. Updating the frequently written columns then copies only the
+ * hot part. Not supported by NAIVE.
+ */
+#ifndef TPCC_HOT_COLD_SPLIT
+#    define TPCC_HOT_COLD_SPLIT 0
+#endif
+
 using Timestamp = int64_t;
 inline Timestamp get_timestamp() {
     thread_local Timestamp i = 0;
@@ -88,13 +99,28 @@ struct Stock {
     uint32_t s_ytd;         // numeric(8)
     uint16_t s_order_cnt;   // numeric(4)
     uint16_t s_remote_cnt;  // numeric(4)
+#if !TPCC_HOT_COLD_SPLIT
     char s_dist[10][DIST + 1];
     char s_data[MAX_DATA + 1];
+#endif
     void deep_copy_from(const Stock& src);
     void generate(uint16_t s_w_id_, uint32_t s_i_id_);
     void print();
 };
 
+// Read-only columns of Stock (TPCC_HOT_COLD_SPLIT)
+// Primary Key (s_w_id, s_i_id)
+struct StockData {
+    using Key = StockKey;
+    uint16_t s_w_id;
+    uint32_t s_i_id;
+    char s_dist[10][Stock::DIST + 1];
+    char s_data[Stock::MAX_DATA + 1];
+    void deep_copy_from(const StockData& src);
+    void generate(uint16_t s_w_id_, uint32_t s_i_id_);
+    void print();
+};
+
 
 // Primary Key (d_w_id, d_id)
 // Foreign Key d_w_id references w_id
@@ -146,13 +172,28 @@ struct Customer {
     char c_last[MAX_LAST + 1];
     char c_phone[PHONE + 1];
     char c_credit[CREDIT + 1];  // "GC"=good, "BC"=bad
+#if !TPCC_HOT_COLD_SPLIT
     char c_data[MAX_DATA + 1];  // miscellaneous information
+#endif
     Address c_address;
     void deep_copy_from(const Customer& src);
     void generate(uint16_t c_w_id_, uint8_t c_d_id_, uint32_t c_id_, Timestamp t_);
     void print();
 };
 
+// Columns of Customer only written by Payment of bad credit customers (TPCC_HOT_COLD_SPLIT)
+// Primary Key (c_w_id, c_d_id, c_id)
+struct CustomerData {
+    using Key = CustomerKey;
+    uint16_t c_w_id;
+    uint8_t c_d_id;
+    uint32_t c_id;
+    char c_data[Customer::MAX_DATA + 1];  // miscellaneous information
+    void deep_copy_from(const CustomerData& src);
+    void generate(uint16_t c_w_id_, uint8_t c_d_id_, uint32_t c_id_);
+    void print();
+};
+
 // Primary Key None
 // Foreign Key (h_c_w_id, h_c_d_id, h_c_id) references (c_w_id, c_d_id, c_id)
 // Foreign Key (h_w_id, h_d_id) references (d_w_id, d_id)
@@ -271,20 +312,36 @@ inline void make_original(char* out) {
 }
 
 // c_last
+inline constexpr const char* CLAST_SYLLABLES[] = {"BAR", "OUGHT", "ABLE",  "PRI",   "PRES",
+                                                  "ESE", "ANTI",  "CALLY", "ATION", "EING"};
+
 inline size_t make_clast(char* out, size_t num) {
-    const char* candidates[] = {"BAR", "OUGHT", "ABLE",  "PRI",   "PRES",
-                                "ESE", "ANTI",  "CALLY", "ATION", "EING"};
     assert(num < 1000);
     constexpr size_t buf_size = Customer::MAX_LAST + 1;
     int len = 0;
     for (size_t i: {num / 100, (num % 100) / 10, num % 10}) {
-        len += copy_cstr(&out[len], candidates[i], buf_size - len);
+        len += copy_cstr(&out[len], CLAST_SYLLABLES[i], buf_size - len);
     }
     assert(len < Customer::MAX_LAST);
     out[len] = '\0';
     return len;
 }
 
+// Inverse of make_clast(). No syllable is a prefix of another, so the first match is the one.
+inline size_t get_clast_number(const char* c_last) {
+    size_t num = 0;
+    for (int i = 0; i < 3; i++) {
+        size_t s = 0;
+        while (s < 10 && ::strncmp(c_last, CLAST_SYLLABLES[s], strlen(CLAST_SYLLABLES[s])) != 0)
+            s++;
+        if (s == 10) throw std::runtime_error("c_last not made by make_clast()");
+        num = num * 10 + s;
+        c_last += strlen(CLAST_SYLLABLES[s]);
+    }
+    if (*c_last != '\0') throw std::runtime_error("c_last not made by make_clast()");
+    return num;
+}
+
 // zip
 inline void make_random_zip(char* out) {
     make_random_nstring(&out[0], 4, 4);
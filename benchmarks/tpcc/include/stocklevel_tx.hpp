@@ -2,15 +2,56 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstdint>
-#include <set>
+#include <vector>
 
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 #include "utils/tsc.hpp"
 
+/**
+ * Distinct item ids of the order lines scanned by StockLevel. A bitmap over all item ids
+ * removes duplicates without allocating, and the ids set are listed so that they can be
+ * returned in ascending order and their bits cleared without scanning the whole bitmap.
+ * Each worker reuses one instance.
+ */
+class DistinctItemIds {
+public:
+    void clear() {
+        for (uint32_t i_id: ids) bits[i_id / 64] = 0;
+        ids.clear();
+    }
+
+    void insert(uint32_t i_id) {
+        assert(i_id <= Item::ITEMS);
+        uint64_t& word = bits[i_id / 64];
+        uint64_t mask = 1ULL << (i_id % 64);
+        if (word & mask) return;
+        word |= mask;
+        ids.push_back(i_id);
+    }
+
+    const std::vector<uint32_t>& get_sorted() {
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    static DistinctItemIds& get_thread_local() {
+        thread_local DistinctItemIds s;
+        return s;
+    }
+
+private:
+    std::array<uint64_t, Item::ITEMS / 64 + 1> bits{};
+    std::vector<uint32_t> ids;
+};
+
 class StockLevelTx {
 public:
     StockLevelTx(uint16_t w_id0) {
@@ -63,7 +104,7 @@ public:
     }
 
     template <typename Transaction>
-    Status run(Transaction& tx, Stat& stat, Output& out) {
+    MaybeTask<Status> run(Transaction& tx, Stat& stat, Output& out) {
         uint64_t start, end;
         start = rdtscp();
         typename Transaction::Result res;
@@ -76,34 +117,43 @@ public:
         out << w_id << d_id << threshold;
 
         const District* d = nullptr;
-        res = tx.get_record(d, District::Key::create_key(w_id, d_id));
+        res = CO_AWAIT(tx.get_record(d, District::Key::create_key(w_id, d_id)));
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, GET_DISTRICT);
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_DISTRICT);
 
-        std::set<uint32_t> s_i_ids;
+        DistinctItemIds& s_i_ids = DistinctItemIds::get_thread_local();
+        s_i_ids.clear();
         OrderLine::Key low = OrderLine::Key::create_key(w_id, d_id, d->d_next_o_id - 20, 1);
         OrderLine::Key up = OrderLine::Key::create_key(w_id, d_id, d->d_next_o_id, 1);
         res = tx.template range_query<OrderLine>(low, up, [&s_i_ids](const OrderLine& ol) {
             if (ol.ol_i_id != Item::UNUSED_ID) s_i_ids.insert(ol.ol_i_id);
         });
         LOG_TRACE("res: %d", static_cast<int>(res));
-        if (not_succeeded(tx, res)) return helper.kill(res, RANGE_GET_ORDERLINE);
-
-        auto it = s_i_ids.begin();
-        const Stock* s = nullptr;
-        while (it != s_i_ids.end()) {
-            res = tx.get_record(s, Stock::Key::create_key(w_id, *it));
-            LOG_TRACE("res: %d", static_cast<int>(res));
-            if (not_succeeded(tx, res)) return helper.kill(res, GET_STOCK);
-            if (s->s_quantity >= threshold) {
-                it = s_i_ids.erase(it);
-            } else {
-                ++it;
-            }
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, RANGE_GET_ORDERLINE);
+
+        // The distinct stock records are looked up in a batch in ascending key order, so that
+        // their index lookups overlap and walk neighbouring leaves one after another. The buffers
+        // are kept per TxSlot as the lookup may suspend in the coroutine mode.
+        thread_local std::vector<Stock::Key> s_keys_per_slot[TxSlot::MAX];
+        thread_local std::vector<const Stock*> stocks_per_slot[TxSlot::MAX];
+        std::vector<Stock::Key>& s_keys = s_keys_per_slot[TxSlot::get()];
+        std::vector<const Stock*>& stocks = stocks_per_slot[TxSlot::get()];
+        s_keys.clear();
+        for (uint32_t s_i_id: s_i_ids.get_sorted()) {
+            s_keys.push_back(Stock::Key::create_key(w_id, s_i_id));
+        }
+        stocks.resize(s_keys.size());
+        res = CO_AWAIT(tx.get_records_batch(s_keys.size(), s_keys.data(), stocks.data()));
+        LOG_TRACE("res: %d", static_cast<int>(res));
+        if (not_succeeded(tx, res)) CO_RETURN helper.kill(res, GET_STOCK);
+
+        size_t low_stock = 0;
+        for (const Stock* s: stocks) {
+            if (s->s_quantity < threshold) low_stock++;
         }
 
-        out << s_i_ids.size();
+        out << low_stock;
         end = rdtscp();
-        return helper.commit(PRECOMMIT, end - start);
+        CO_RETURN helper.commit(PRECOMMIT, end - start);
     }
 };
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "benchmarks/tpcc/include/delivery_tx.hpp"
+#include "benchmarks/tpcc/include/neworder_tx.hpp"
+#include "benchmarks/tpcc/include/orderstatus_tx.hpp"
+#include "benchmarks/tpcc/include/payment_tx.hpp"
+#include "benchmarks/tpcc/include/placement.hpp"
+#include "benchmarks/tpcc/include/record_layout.hpp"
+#include "benchmarks/tpcc/include/stocklevel_tx.hpp"
+#include "utils/utils.hpp"
+
+inline uint64_t get_district_conflict_key(uint16_t w_id, uint8_t d_id) {
+    return (1ULL << 40) | (static_cast<uint64_t>(w_id) << 8) | d_id;
+}
+
+// Keys of the records that concurrent transactions with the given input are likely to conflict
+// on: districts (d_next_o_id, new orders, d_ytd), the warehouse of a Payment (w_ytd) and the
+// stock records of a NewOrder. OrderStatus only reads records that are rarely updated.
+template <typename Input, typename F>
+inline void for_each_conflict_key(const Input& input, F&& f) {
+    f(get_district_conflict_key(input.w_id, input.d_id));
+}
+
+template <typename F>
+inline void for_each_conflict_key(const OrderStatusTx::Input&, F&&) {}
+
+template <typename F>
+inline void for_each_conflict_key(const NewOrderTx::Input& input, F&& f) {
+    f(get_district_conflict_key(input.w_id, input.d_id));
+    for (uint8_t i = 0; i < input.ol_cnt; i++) {
+        uint64_t w_id = input.items[i].ol_supply_w_id;
+        f((2ULL << 40) | (w_id << 20) | input.items[i].ol_i_id);
+    }
+}
+
+template <typename F>
+inline void for_each_conflict_key(const PaymentTx::Input& input, F&& f) {
+    f((3ULL << 40) | input.w_id);
+    f(get_district_conflict_key(input.w_id, input.d_id));
+}
+
+template <typename F>
+inline void for_each_conflict_key(const DeliveryTx::Input& input, F&& f) {
+    for (uint8_t d_id = 1; d_id <= District::DISTS_PER_WARE; d_id++) {
+        f(get_district_conflict_key(input.w_id, d_id));
+    }
+}
+
+// Delivery works on all districts
+template <typename Input>
+inline uint8_t get_district(const Input& input) {
+    return input.d_id;
+}
+
+inline uint8_t get_district(const DeliveryTx::Input&) {
+    return 0;
+}
+
+/**
+ * Transactions of the standard mix whose inputs are generated before they run, so that a
+ * worker can look at (CALVIN) or reorder (reorder()) a whole batch before executing it.
+ */
+class TxBatch {
+public:
+    using Entry = std::variant<
+        std::monostate, NewOrderTx, PaymentTx, OrderStatusTx, DeliveryTx, StockLevelTx>;
+
+    explicit TxBatch(size_t size)
+        : entries(size)
+        , keys(size) {}
+
+    size_t size() const { return entries.size(); }
+
+    Entry& operator[](size_t i) { return entries[i]; }
+
+    // Calls f with the transaction profile of e
+    template <typename F>
+    static void visit(Entry& e, F&& f) {
+        std::visit(
+            [&](auto& p) {
+                if constexpr (!std::is_same_v<std::decay_t<decltype(p)>, std::monostate>) f(p);
+            },
+            e);
+    }
+
+    void generate(uint32_t thread_id) {
+        for (Entry& e: entries) {
+            uint16_t w_id = get_home_warehouse(thread_id);
+            int x = urand_int(1, 100);
+            if (x <= 4) {
+                e.emplace<StockLevelTx>(w_id);
+            } else if (x <= 8) {
+                e.emplace<DeliveryTx>(w_id);
+            } else if (x <= 12) {
+                e.emplace<OrderStatusTx>(w_id);
+            } else if (x <= 12 + 43) {
+                e.emplace<PaymentTx>(w_id);
+            } else {
+                e.emplace<NewOrderTx>(w_id);
+            }
+        }
+    }
+
+    /**
+     * Spreads transactions that update the same district or stock record across the batch.
+     * Each position takes the transaction whose conflict keys were last used longest ago, and
+     * among equally good ones the transaction closest to the district preferred at that
+     * position. A transaction without conflict keys (OrderStatus) counts as if its keys were
+     * last used NEUTRAL_GAP positions ago, so that it fills the positions between conflicting
+     * transactions instead of always going first.
+     * The transactions of a batch run one after the other, so spreading them within the batch
+     * does not by itself avoid aborts. Only the preferred district acts across workers: it
+     * rotates starting from the worker id, so workers sharing a warehouse tend to work on
+     * different districts at the same time.
+     */
+    void reorder(uint32_t thread_id) {
+        size_t n = entries.size();
+        for (size_t i = 0; i < n; i++) {
+            keys[i].clear();
+            visit(entries[i], [&](auto& p) {
+                for_each_conflict_key(p.input, [&](uint64_t key) { keys[i].push_back(key); });
+            });
+        }
+        last_use.clear();
+        picked.assign(n, false);
+        order.clear();
+        for (size_t pos = 0; pos < n; pos++) {
+            uint8_t preferred = (thread_id + pos) % District::DISTS_PER_WARE + 1;
+            size_t best = n;
+            size_t best_gap = 0;
+            size_t best_dist = 0;
+            for (size_t i = 0; i < n; i++) {
+                if (picked[i]) continue;
+                size_t gap = keys[i].empty() ? NEUTRAL_GAP : SIZE_MAX;
+                for (uint64_t key: keys[i]) {
+                    auto it = last_use.find(key);
+                    if (it != last_use.end()) gap = std::min(gap, pos - it->second);
+                }
+                size_t dist = get_district_distance(entries[i], preferred);
+                if (best == n || gap > best_gap || (gap == best_gap && dist < best_dist)) {
+                    best = i;
+                    best_gap = gap;
+                    best_dist = dist;
+                }
+            }
+            picked[best] = true;
+            order.push_back(best);
+            for (uint64_t key: keys[best]) last_use[key] = pos;
+        }
+        reordered.clear();
+        for (size_t i: order) reordered.push_back(std::move(entries[i]));
+        entries.swap(reordered);
+    }
+
+private:
+    static constexpr size_t NEUTRAL_GAP = District::DISTS_PER_WARE;
+
+    std::vector<Entry> entries;
+    std::vector<Entry> reordered;
+    std::vector<std::vector<uint64_t>> keys;
+    std::vector<bool> picked;
+    std::vector<size_t> order;
+    std::unordered_map<uint64_t, size_t> last_use;
+
+    static size_t get_district_distance(Entry& e, uint8_t preferred) {
+        size_t dist = District::DISTS_PER_WARE;
+        visit(e, [&](auto& p) {
+            uint8_t d_id = get_district(p.input);
+            if (d_id == 0) return;
+            dist = (d_id + District::DISTS_PER_WARE - preferred) % District::DISTS_PER_WARE;
+        });
+        return dist;
+    }
+};
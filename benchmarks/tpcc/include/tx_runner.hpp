@@ -6,38 +6,121 @@
 #include "benchmarks/tpcc/include/neworder_tx.hpp"
 #include "benchmarks/tpcc/include/orderstatus_tx.hpp"
 #include "benchmarks/tpcc/include/payment_tx.hpp"
+#include "benchmarks/tpcc/include/placement.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "benchmarks/tpcc/include/stocklevel_tx.hpp"
 #include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "utils/backoff.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
+#include "utils/numa.hpp"
+#include "utils/profiler.hpp"
 #include "utils/utils.hpp"
 
+// Warehouses whose warehouse-local records are accessed by a transaction with the given input
+template <typename Input, typename F>
+inline void for_each_accessed_warehouse(const Input& input, F&& f) {
+    f(input.w_id);
+}
+
+template <typename F>
+inline void for_each_accessed_warehouse(const NewOrderTx::Input& input, F&& f) {
+    f(input.w_id);
+    for (uint8_t i = 0; i < input.ol_cnt; i++) f(input.items[i].ol_supply_w_id);
+}
+
+template <typename F>
+inline void for_each_accessed_warehouse(const PaymentTx::Input& input, F&& f) {
+    f(input.w_id);
+    f(input.c_w_id);
+}
+
+template <typename TxProfile>
+inline void count_node_accesses(const TxProfile& p, uint32_t thread_id, Stat& stat) {
+    if (!is_warehouse_placement_enabled()) return;
+    int node = get_thread_pinning().get_node(thread_id);
+    Stat::PerTxType& per_type = stat[TxProfile::id];
+    for_each_accessed_warehouse(p.input, [&](uint16_t w_id) {
+        if (get_warehouse_node(w_id) == node) {
+            per_type.num_local_accesses++;
+        } else {
+            per_type.num_remote_accesses++;
+        }
+    });
+}
+
 template <typename TxProfile, typename Transaction>
-inline Status run(Transaction& tx, Stat& stat, Output& out) {
-    uint16_t w_id;
-    const Config& c = get_config();
-    if (c.get_fixed_warehouse_flag()) {
-        w_id = tx.thread_id % c.get_num_warehouses() + 1;
-    } else {
-        w_id = urand_int(1, get_config().get_num_warehouses());
-    }
-    TxProfile p(w_id);
-    return p.run(tx, stat, out);
+inline MaybeTask<Status> run(TxProfile& p, Transaction& tx, Stat& stat, Output& out) {
+    PROFILE_TX_BEGIN(TxProfile::id, TxProfile::name);
+    Status res = CO_AWAIT(p.run(tx, stat, out));
+    PROFILE_TX_END(res == SUCCESS);
+    if (res == SUCCESS) count_node_accesses(p, tx.thread_id, stat);
+    CO_RETURN res;
 }
 
+/**
+ * Runs the transaction until it commits or is aborted by the user. A transaction aborted by the
+ * concurrency control is retried with the same input after the configured Backoff.
+ */
 template <typename TxProfile, typename Transaction>
-inline bool run_with_retry(Transaction& tx, Stat& stat, Output& out) {
+inline MaybeTask<bool> run_with_retry(TxProfile& p, Transaction& tx, Stat& stat, Output& out) {
+    uint32_t retries = 0;
     for (;;) {
-        Status res = run<TxProfile>(tx, stat, out);
+        Status res = CO_AWAIT(run(p, tx, stat, out));
         switch (res) {
-        case SUCCESS: LOG_TRACE("success"); return true;
+        case SUCCESS:
+            LOG_TRACE("success");
+            Backoff::finish(retries);
+            CO_RETURN true;
         case USER_ABORT:
             LOG_TRACE("user abort");
             tx.abort();
-            return false;                                        // aborted by the user
-        case SYSTEM_ABORT: LOG_TRACE("system abort"); continue;  // aborted by the tx engine
+            Backoff::finish(retries);
+            CO_RETURN false;  // aborted by the user
+        case SYSTEM_ABORT:  // aborted by the tx engine
+            LOG_TRACE("system abort");
+            stat[TxProfile::id].total_backoff += Backoff::wait(++retries);
+            continue;
         case BUG: assert(false);  // throw std::runtime_error("Unexpected Transaction Bug");
         default: assert(false);
         }
     }
 }
+
+template <typename TxProfile, typename Transaction>
+inline MaybeTask<bool> run_with_retry(Transaction& tx, Stat& stat, Output& out) {
+    TxProfile p(get_home_warehouse(tx.thread_id));
+    CO_RETURN CO_AWAIT(run_with_retry(p, tx, stat, out));
+}
+
+// For protocols that never abort a transaction by themselves (CALVIN), the input of the
+// transaction is generated beforehand and it runs exactly once
+template <typename TxProfile, typename Transaction>
+inline MaybeTask<bool> run_once(TxProfile& p, Transaction& tx, Stat& stat, Output& out) {
+    Status res = CO_AWAIT(run(p, tx, stat, out));
+    switch (res) {
+    case SUCCESS: LOG_TRACE("success"); CO_RETURN true;
+    case USER_ABORT:
+        LOG_TRACE("user abort");
+        tx.abort();
+        CO_RETURN false;
+    default: throw std::runtime_error("unexpected system abort");
+    }
+}
+
+// Runs one transaction of the standard mix: 45% NewOrder, 43% Payment and 4% of each other
+template <typename Transaction>
+inline MaybeTask<void> run_random_tx_with_retry(Transaction& tx, Stat& stat, Output& out) {
+    int x = urand_int(1, 100);
+    if (x <= 4) {
+        CO_AWAIT(run_with_retry<StockLevelTx>(tx, stat, out));
+    } else if (x <= 8) {
+        CO_AWAIT(run_with_retry<DeliveryTx>(tx, stat, out));
+    } else if (x <= 12) {
+        CO_AWAIT(run_with_retry<OrderStatusTx>(tx, stat, out));
+    } else if (x <= 12 + 43) {
+        CO_AWAIT(run_with_retry<PaymentTx>(tx, stat, out));
+    } else {
+        CO_AWAIT(run_with_retry<NewOrderTx>(tx, stat, out));
+    }
+}
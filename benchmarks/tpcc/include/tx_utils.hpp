@@ -97,6 +97,10 @@ struct Stat {
         uint64_t total_latency = 0;
         uint64_t min_latency = UINT64_MAX;
         uint64_t max_latency = 0;
+        // warehouses accessed by committed transactions, by node (see placement.hpp)
+        size_t num_local_accesses = 0;
+        size_t num_remote_accesses = 0;
+        uint64_t total_backoff = 0;  // cycles waited before retries (see Backoff)
 
         void add(const PerTxType& rhs, bool with_abort_details) {
             num_commits += rhs.num_commits;
@@ -112,6 +116,9 @@ struct Stat {
             total_latency += rhs.total_latency;
             min_latency = std::min(min_latency, rhs.min_latency);
             max_latency = std::max(max_latency, rhs.max_latency);
+            num_local_accesses += rhs.num_local_accesses;
+            num_remote_accesses += rhs.num_remote_accesses;
+            total_backoff += rhs.total_backoff;
         }
     };
 
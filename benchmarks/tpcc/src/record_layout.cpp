@@ -74,8 +74,10 @@ void Stock::deep_copy_from(const Stock& src) {
         s_ytd = src.s_ytd;
         s_order_cnt = src.s_order_cnt;
         s_remote_cnt = src.s_remote_cnt;
+#if !TPCC_HOT_COLD_SPLIT
         memcpy(s_dist[0], src.s_dist[0], sizeof(10 * (Stock::DIST + 1)));
         copy_cstr(s_data, src.s_data, sizeof(s_data));
+#endif
     }
 }
 
@@ -86,20 +88,56 @@ void Stock::generate(uint16_t s_w_id_, uint32_t s_i_id_) {
     s_ytd = 0;                        // numeric(8)
     s_order_cnt = 0;                  // numeric(4)
     s_remote_cnt = 0;                 // numeric(4)
+#if !TPCC_HOT_COLD_SPLIT
     for (size_t i = 0; i < 10; i++) {
         make_random_astring(s_dist[i], Stock::DIST, Stock::DIST);
     }
     make_random_astring(s_data, Stock::MIN_DATA, Stock::MAX_DATA);
     if (urand_int(0, 99) < 10) make_original(s_data);
+#endif
 }
 
 void Stock::print() {
+#if TPCC_HOT_COLD_SPLIT
+    LOG_TRACE(
+        "[STO] s_w_id:%" PRIu16 " s_i_id:%" PRIu32 " s_quantity:%" PRIu32 " s_ytd:%" PRIu32
+        " s_order_cnt:%" PRIu16 " s_remote:%" PRIu16,
+        s_w_id, s_i_id, s_quantity, s_ytd, s_order_cnt, s_remote_cnt);
+#else
     LOG_TRACE(
         "[STO] s_w_id:%" PRIu16 " s_i_id:%" PRIu32 " s_quantity:%" PRIu32 " s_ytd:%" PRIu32
         " s_order_cnt:%" PRIu16 " s_remote:%" PRIu16
         " s_dist_01:%s s_dist_02:%s s_dist_03:%s s_dist_04:%s s_dist_05:%s s_dist_06:%s s_dist_07:%s s_dist_08:%s s_dist_09:%s s_dist_10:%s",
         s_w_id, s_i_id, s_quantity, s_ytd, s_order_cnt, s_remote_cnt, s_dist[0], s_dist[1],
         s_dist[2], s_dist[3], s_dist[4], s_dist[5], s_dist[6], s_dist[7], s_dist[8], s_dist[9]);
+#endif
+}
+
+void StockData::deep_copy_from(const StockData& src) {
+    if (this != &src) {
+        s_i_id = src.s_i_id;
+        s_w_id = src.s_w_id;
+        memcpy(s_dist[0], src.s_dist[0], sizeof(s_dist));
+        copy_cstr(s_data, src.s_data, sizeof(s_data));
+    }
+}
+
+void StockData::generate(uint16_t s_w_id_, uint32_t s_i_id_) {
+    s_i_id = s_i_id_;
+    s_w_id = s_w_id_;
+    for (size_t i = 0; i < 10; i++) {
+        make_random_astring(s_dist[i], Stock::DIST, Stock::DIST);
+    }
+    make_random_astring(s_data, Stock::MIN_DATA, Stock::MAX_DATA);
+    if (urand_int(0, 99) < 10) make_original(s_data);
+}
+
+void StockData::print() {
+    LOG_TRACE(
+        "[STOD] s_w_id:%" PRIu16 " s_i_id:%" PRIu32
+        " s_dist_01:%s s_dist_02:%s s_dist_03:%s s_dist_04:%s s_dist_05:%s s_dist_06:%s s_dist_07:%s s_dist_08:%s s_dist_09:%s s_dist_10:%s s_data:%s",
+        s_w_id, s_i_id, s_dist[0], s_dist[1], s_dist[2], s_dist[3], s_dist[4], s_dist[5],
+        s_dist[6], s_dist[7], s_dist[8], s_dist[9], s_data);
 }
 
 void District::deep_copy_from(const District& src) {
@@ -149,7 +187,9 @@ void Customer::deep_copy_from(const Customer& src) {
         copy_cstr(c_last, src.c_last, sizeof(c_last));
         copy_cstr(c_phone, src.c_phone, sizeof(c_phone));
         copy_cstr(c_credit, src.c_credit, sizeof(c_credit));
+#if !TPCC_HOT_COLD_SPLIT
         copy_cstr(c_data, src.c_data, sizeof(c_data));
+#endif
         c_address.deep_copy_from(src.c_address);
     }
 }
@@ -172,11 +212,22 @@ void Customer::generate(uint16_t c_w_id_, uint8_t c_d_id_, uint32_t c_id_, Times
     (urand_int(0, 99) < 10 ? copy_cstr(c_credit, "BC", sizeof(c_credit))
                            : copy_cstr(c_credit, "GC", sizeof(c_credit)));
     ;
+#if !TPCC_HOT_COLD_SPLIT
     make_random_astring(c_data, Customer::MIN_DATA, Customer::MAX_DATA);
+#endif
     make_random_address(c_address);
 }
 
 void Customer::print() {
+#if TPCC_HOT_COLD_SPLIT
+    LOG_TRACE(
+        "[CUST] c_w_id:%" PRIu16 " c_d_id:%" PRIu8 " c_id:%" PRIu32 " c_payment_cnt:%" PRIu16
+        " c_delivery_cnt:%" PRIu16 " c_since:%" PRId64
+        " c_credit_lim:%lf c_discount:%lf c_balance:%lf c_ytd_payment:%lf c_first:%s c_middle:%s c_last:%s c_phone:%s c_credit:%s street_1:%s street_2:%s city:%s state:%s zip:%s",
+        c_w_id, c_d_id, c_id, c_payment_cnt, c_delivery_cnt, c_since, c_credit_lim, c_discount,
+        c_balance, c_ytd_payment, c_first, c_middle, c_last, c_phone, c_credit,
+        c_address.street_1, c_address.street_2, c_address.city, c_address.state, c_address.zip);
+#else
     LOG_TRACE(
         "[CUST] c_w_id:%" PRIu16 " c_d_id:%" PRIu8 " c_id:%" PRIu32 " c_payment_cnt:%" PRIu16
         " c_delivery_cnt:%" PRIu16 " c_since:%" PRId64
@@ -184,6 +235,29 @@ void Customer::print() {
         c_w_id, c_d_id, c_id, c_payment_cnt, c_delivery_cnt, c_since, c_credit_lim, c_discount,
         c_balance, c_ytd_payment, c_first, c_middle, c_last, c_phone, c_credit, c_data,
         c_address.street_1, c_address.street_2, c_address.city, c_address.state, c_address.zip);
+#endif
+}
+
+void CustomerData::deep_copy_from(const CustomerData& src) {
+    if (this != &src) {
+        c_id = src.c_id;
+        c_d_id = src.c_d_id;
+        c_w_id = src.c_w_id;
+        copy_cstr(c_data, src.c_data, sizeof(c_data));
+    }
+}
+
+void CustomerData::generate(uint16_t c_w_id_, uint8_t c_d_id_, uint32_t c_id_) {
+    c_id = c_id_;
+    c_d_id = c_d_id_;
+    c_w_id = c_w_id_;
+    make_random_astring(c_data, Customer::MIN_DATA, Customer::MAX_DATA);
+}
+
+void CustomerData::print() {
+    LOG_TRACE(
+        "[CUSTD] c_w_id:%" PRIu16 " c_d_id:%" PRIu8 " c_id:%" PRIu32 " c_data:%s", c_w_id, c_d_id,
+        c_id, c_data);
 }
 
 void History::deep_copy_from(const History& src) {
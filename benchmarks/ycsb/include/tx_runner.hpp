@@ -8,11 +8,15 @@
 #include "benchmarks/ycsb/include/tx_utils.hpp"
 #include "benchmarks/ycsb/include/update_tx.hpp"
 #include "utils/logger.hpp"
+#include "utils/profiler.hpp"
 
 template <typename TxProfile, typename Transaction>
 inline Status run(Transaction& tx, Stat& stat) {
     TxProfile p;
-    return p.run(tx, stat);
+    PROFILE_TX_BEGIN(TxProfile::id, TxProfile::name);
+    Status res = p.run(tx, stat);
+    PROFILE_TX_END(res == SUCCESS);
+    return res;
 }
 
 template <typename TxProfile, typename Transaction>
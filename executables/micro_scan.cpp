@@ -0,0 +1,413 @@
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmarks/tpcc/include/record_key.hpp"
+#include "indexes/composite_key.hpp"
+#include "indexes/index_interface.hpp"
+#include "indexes/masstree.hpp"
+#include "indexes/masstree_str.hpp"
+#include "utils/options.hpp"
+#include "utils/tsc.hpp"
+#include "utils/utils.hpp"
+
+volatile mrcu_epoch_type active_epoch = 1;
+volatile std::uint64_t globalepoch = 1;
+volatile bool recovering = false;
+
+/**
+ * Single-threaded microbenchmark of MasstreeIndexes range scans:
+ *   orderline: StockLevel scans over the order lines of the last 20 orders of a district
+ *   ycsb:      YCSB-E scans of a uniformly random length from a uniformly random key
+ * Each set of scans is run through the streaming interface (callbacks inlined into the
+ * scanner), through the reusable result list used by the protocols, and by collecting the
+ * results into a std::map as the protocols used to, for comparison. The orderline scans are
+ * repeated on a copy of the table keyed by composite keys (32-bit w_id and o_id, 10 bytes,
+ * which spans two Masstree layers) in a MasstreeStrIndex to compare with the bit-packed 64-bit
+ * keys. index= selects the backend of the tables of 64-bit keys (masstree, btree or art).
+ *
+ * check=<threads> checks the selected backend through the interface used by the protocols
+ * instead of measuring, with num_records keys and num_scans operations per thread:
+ *   sequential  random inserts, removes and finds, and forward and reverse scans with and
+ *               without a count across many leaves, compared with a std::map
+ *   versions    after a scan recorded its nodes (NodeMap), an insert or remove in the range
+ *               must change the version of one of them, and so must the insert of a key whose
+ *               lookup found nothing; the inserts split leaves (B+tree) and grow nodes (ART)
+ *   concurrent  each thread inserts and removes its own keys (key % threads == thread) while the
+ *               others do the same; scans in both directions must return sorted keys, including
+ *               exactly the keys the thread has in its std::map
+ */
+
+struct Row {
+    uint64_t data;
+};
+
+using Index = MasstreeIndexes<Row>;
+using StrIndex = MasstreeStrIndex<Row>;
+
+constexpr TableID ORDERLINE_TABLE = 0;
+constexpr TableID YCSB_TABLE = 1;
+constexpr TableID CHECK_TABLE = 2;
+constexpr TableID CHECK_CONCURRENT_TABLE = 3;
+constexpr uint32_t ORDERS_PER_DIST = 3000;
+
+struct Range {
+    uint64_t low;
+    uint64_t up;
+    int64_t count;
+};
+
+using OrderLineCompositeKey = CompositeKey<16>;
+
+OrderLineCompositeKey create_composite_key(uint64_t raw_key) {
+    OrderLine::Key k(raw_key);
+    OrderLineCompositeKey ck;
+    ck.append(static_cast<uint32_t>(k.w_id)).append(static_cast<uint8_t>(k.d_id));
+    ck.append(static_cast<uint32_t>(k.o_id)).append(static_cast<uint8_t>(k.ol_number));
+    return ck;
+}
+
+template <typename Scan>
+void measure(const char* name, const std::vector<Range>& ranges, Scan&& scan) {
+    uint64_t rows = 0;
+    uint64_t sum = 0;
+    uint64_t start = rdtscp();
+    for (const Range& r: ranges) scan(r, rows, sum);
+    uint64_t cycles = rdtscp() - start;
+    printf(
+        "  %-10s %8.0f cycles/scan %6.1f rows/scan %6.1f cycles/row (checksum %" PRIu64 ")\n", name,
+        cycles / static_cast<double>(ranges.size()), rows / static_cast<double>(ranges.size()),
+        cycles / static_cast<double>(rows ? rows : 1), sum);
+}
+
+void run(const char* name, TableID table_id, const std::vector<Range>& ranges) {
+    Index& idx = Index::get_index();
+    auto no_node = [](Index::LeafNode*, uint64_t, bool&) {};
+    printf("%s (%zu scans)\n", name, ranges.size());
+    measure("streaming", ranges, [&](const Range& r, uint64_t& rows, uint64_t& sum) {
+        int64_t n = 0;
+        idx.get_kv_in_range(
+            table_id, r.low, r.up, no_node, [&](uint64_t, Row* val, bool& continue_flag) {
+                sum += val->data;
+                n++;
+                if (r.count != -1 && n >= r.count) continue_flag = false;
+            });
+        rows += n;
+    });
+    Index::KVList kv_list;
+    measure("buffer", ranges, [&](const Range& r, uint64_t& rows, uint64_t& sum) {
+        idx.get_kv_in_range(table_id, r.low, r.up, r.count, kv_list);
+        for (auto& [k, val]: kv_list) sum += val->data;
+        rows += kv_list.size();
+    });
+    measure("map", ranges, [&](const Range& r, uint64_t& rows, uint64_t& sum) {
+        std::map<uint64_t, Row*> kv_map;
+        idx.get_kv_in_range(
+            table_id, r.low, r.up, no_node, [&](uint64_t key, Row* val, bool& continue_flag) {
+                kv_map.emplace(key, val);
+                if (r.count != -1 && static_cast<int64_t>(kv_map.size()) >= r.count)
+                    continue_flag = false;
+            });
+        for (auto& [k, val]: kv_map) sum += val->data;
+        rows += kv_map.size();
+    });
+}
+
+void run_composite(const char* name, StrIndex& idx, const std::vector<Range>& ranges) {
+    printf("%s (%zu scans)\n", name, ranges.size());
+    measure("streaming", ranges, [&](const Range& r, uint64_t& rows, uint64_t& sum) {
+        OrderLineCompositeKey low = create_composite_key(r.low);
+        OrderLineCompositeKey up = create_composite_key(r.up);
+        idx.scan(low.view(), up.view(), [&](StrIndex::StrKey, Row* val, bool&) {
+            sum += val->data;
+            rows++;
+        });
+    });
+    StrIndex::StrKVList kv_list;
+    measure("buffer", ranges, [&](const Range& r, uint64_t& rows, uint64_t& sum) {
+        OrderLineCompositeKey low = create_composite_key(r.low);
+        OrderLineCompositeKey up = create_composite_key(r.up);
+        idx.scan(low.view(), up.view(), false, r.count, kv_list);
+        for (size_t i = 0; i < kv_list.size(); i++) sum += kv_list[i].second->data;
+        rows += kv_list.size();
+    });
+}
+
+using KeyMap = std::map<uint64_t, Row*>;
+
+// Keys of m that a scan of [low, up) (or of (low, up] in reverse) returns, in scan order
+std::vector<uint64_t> expected_keys(
+    const KeyMap& m, uint64_t low, uint64_t up, bool reverse, int64_t count) {
+    std::vector<uint64_t> keys;
+    auto full = [&] { return count != -1 && static_cast<int64_t>(keys.size()) >= count; };
+    if (reverse) {
+        for (auto it = m.upper_bound(up); it != m.begin() && !full();) {
+            --it;
+            if (it->first <= low) break;
+            keys.push_back(it->first);
+        }
+    } else {
+        for (auto it = m.lower_bound(low); it != m.end() && it->first < up && !full(); ++it) {
+            keys.push_back(it->first);
+        }
+    }
+    return keys;
+}
+
+// Keys returned by the scan, or an empty list with an error if a value is not the one of its key
+std::vector<uint64_t> scanned_keys(const Index::KVList& kv_list, uint64_t& errors) {
+    std::vector<uint64_t> keys;
+    for (auto& [key, val]: kv_list) {
+        if (val->data != key) errors++;
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+uint64_t scan(
+    TableID table_id, uint64_t low, uint64_t up, bool reverse, int64_t count,
+    Index::KVList& kv_list, Index::NodeMap* nm = nullptr) {
+    Index& idx = Index::get_index();
+    if (reverse) {
+        if (nm) return idx.get_kv_in_rev_range(table_id, low, up, count, kv_list, *nm);
+        return idx.get_kv_in_rev_range(table_id, low, up, count, kv_list);
+    }
+    if (nm) return idx.get_kv_in_range(table_id, low, up, count, kv_list, *nm);
+    return idx.get_kv_in_range(table_id, low, up, count, kv_list);
+}
+
+bool node_changed(TableID table_id, const Index::NodeMap& nm) {
+    Index& idx = Index::get_index();
+    for (auto& [node, version]: nm) {
+        if (idx.get_version_value(table_id, node) != version) return true;
+    }
+    return false;
+}
+
+uint64_t check_sequential(
+    uint64_t num_keys, size_t num_ops, std::vector<Row>& key_rows, KeyMap& m) {
+    Index& idx = Index::get_index();
+    std::mt19937_64 rng(1);
+    uint64_t errors = 0;
+    Index::KVList kv_list;
+    for (size_t i = 0; i < num_ops; i++) {
+        uint64_t key = rng() % num_keys;
+        Row* row = &key_rows[key];
+        int op = rng() % 10;
+        if (op < 6) {
+            bool inserted = idx.insert(CHECK_TABLE, key, row) == Index::Result::OK;
+            if (inserted != m.emplace(key, row).second) errors++;
+        } else if (op < 8) {
+            bool removed = idx.remove(CHECK_TABLE, key) == Index::Result::OK;
+            if (removed != (m.erase(key) > 0)) errors++;
+        } else {
+            Row* val = nullptr;
+            bool found = idx.find(CHECK_TABLE, key, val) == Index::Result::OK;
+            if (found != (m.count(key) > 0) || (found && val != row)) errors++;
+        }
+        if (i % 100 == 0) {
+            uint64_t low = rng() % num_keys;
+            uint64_t up = low + rng() % (num_keys / 10 + 1);
+            bool reverse = rng() & 1;
+            int64_t count = (rng() & 1) ? -1 : static_cast<int64_t>(1 + rng() % 200);
+            scan(CHECK_TABLE, low, up, reverse, count, kv_list);
+            if (scanned_keys(kv_list, errors) != expected_keys(m, low, up, reverse, count)) {
+                errors++;
+            }
+        }
+    }
+    for (bool reverse: {false, true}) {
+        scan(CHECK_TABLE, 0, UINT64_MAX, reverse, -1, kv_list);
+        if (scanned_keys(kv_list, errors) != expected_keys(m, 0, UINT64_MAX, reverse, -1)) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+uint64_t check_versions(
+    uint64_t num_keys, size_t num_ops, std::vector<Row>& key_rows, KeyMap& m) {
+    Index& idx = Index::get_index();
+    std::mt19937_64 rng(2);
+    uint64_t errors = 0;
+    Index::KVList kv_list;
+    for (size_t i = 0; i < num_ops; i++) {
+        uint64_t low = rng() % num_keys;
+        uint64_t up = low + 1 + rng() % 1000;
+        bool reverse = rng() & 1;
+        Index::NodeMap nm;
+        scan(CHECK_TABLE, low, up, reverse, -1, kv_list, &nm);
+        // A key the scan covered: [low, up) forward, (low, up] in reverse
+        uint64_t key = low + reverse + rng() % (up - low);
+        if (key >= num_keys) continue;
+        if (m.erase(key)) {
+            if (idx.remove(CHECK_TABLE, key) != Index::Result::OK) errors++;
+        } else {
+            m.emplace(key, &key_rows[key]);
+            if (idx.insert(CHECK_TABLE, key, &key_rows[key]) != Index::Result::OK) errors++;
+        }
+        if (!node_changed(CHECK_TABLE, nm)) errors++;
+
+        // Insert of a key whose lookup found nothing
+        key = rng() % num_keys;
+        Row* val;
+        nm.clear();
+        if (idx.find(CHECK_TABLE, key, val, nm) == Index::Result::OK) continue;
+        m.emplace(key, &key_rows[key]);
+        if (idx.insert(CHECK_TABLE, key, &key_rows[key]) != Index::Result::OK) errors++;
+        if (!node_changed(CHECK_TABLE, nm)) errors++;
+    }
+    return errors;
+}
+
+uint64_t check_concurrent(
+    uint64_t num_keys, size_t num_ops, int num_threads, std::vector<Row>& key_rows) {
+    Index& idx = Index::get_index();
+    std::atomic<uint64_t> errors{0};
+    std::vector<KeyMap> maps(num_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 rng(t);
+            KeyMap& m = maps[t];
+            uint64_t local_errors = 0;
+            Index::KVList kv_list;
+            for (size_t i = 0; i < num_ops; i++) {
+                uint64_t key = (rng() % num_keys) * num_threads + t;
+                Row* row = &key_rows[key];
+                if (rng() % 3) {
+                    bool inserted = idx.insert(CHECK_CONCURRENT_TABLE, key, row) ==
+                                    Index::Result::OK;
+                    if (inserted != m.emplace(key, row).second) local_errors++;
+                } else {
+                    bool removed = idx.remove(CHECK_CONCURRENT_TABLE, key) == Index::Result::OK;
+                    if (removed != (m.erase(key) > 0)) local_errors++;
+                }
+                if (i % 50 != 0) continue;
+                uint64_t up = key + 1 + rng() % (200 * num_threads);
+                for (bool reverse: {false, true}) {
+                    scan(CHECK_CONCURRENT_TABLE, key, up, reverse, -1, kv_list);
+                    std::vector<uint64_t> keys = scanned_keys(kv_list, local_errors);
+                    std::vector<uint64_t> own;
+                    for (size_t j = 0; j < keys.size(); j++) {
+                        if (j > 0 && (reverse ? keys[j] >= keys[j - 1] : keys[j] <= keys[j - 1]))
+                            local_errors++;
+                        if (keys[j] % num_threads == static_cast<uint64_t>(t))
+                            own.push_back(keys[j]);
+                    }
+                    if (own != expected_keys(m, key, up, reverse, -1)) local_errors++;
+                }
+            }
+            errors += local_errors;
+        });
+    }
+    for (std::thread& th: threads) th.join();
+
+    KeyMap all;
+    for (KeyMap& m: maps) all.insert(m.begin(), m.end());
+    uint64_t final_errors = 0;
+    Index::KVList kv_list;
+    for (bool reverse: {false, true}) {
+        scan(CHECK_CONCURRENT_TABLE, 0, UINT64_MAX, reverse, -1, kv_list);
+        if (scanned_keys(kv_list, final_errors) != expected_keys(all, 0, UINT64_MAX, reverse, -1))
+            final_errors++;
+    }
+    return errors + final_errors;
+}
+
+int check(IndexBackend backend, uint64_t num_keys, size_t num_ops, int num_threads) {
+    Index& idx = Index::get_index();
+    idx.use_backend(CHECK_TABLE, backend);
+    idx.use_backend(CHECK_CONCURRENT_TABLE, backend);
+    std::vector<Row> key_rows(num_keys * num_threads);
+    for (uint64_t key = 0; key < key_rows.size(); key++) key_rows[key].data = key;
+
+    KeyMap m;
+    uint64_t sequential = check_sequential(num_keys, num_ops, key_rows, m);
+    printf("sequential: %" PRIu64 " error(s), %zu keys\n", sequential, m.size());
+    uint64_t versions = check_versions(num_keys, num_ops, key_rows, m);
+    printf("versions:   %" PRIu64 " error(s)\n", versions);
+    uint64_t concurrent = check_concurrent(num_keys, num_ops, num_threads, key_rows);
+    printf("concurrent: %" PRIu64 " error(s), %d thread(s)\n", concurrent, num_threads);
+    return sequential + versions + concurrent == 0 ? 0 : 1;
+}
+
+int main(int argc, const char* argv[]) {
+    if (argc < 4) {
+        printf(
+            "num_warehouses num_records num_scans [max_scan=<YCSB-E scan length>] "
+            "[index=masstree|btree|art] [check=<threads>]\n"
+            "art frees removed leaves and replaced nodes only with the index\n");
+        exit(1);
+    }
+
+    uint16_t num_warehouses = static_cast<uint16_t>(std::stoi(argv[1], nullptr, 10));
+    uint64_t num_records = static_cast<uint64_t>(std::stoull(argv[2], nullptr, 10));
+    size_t num_scans = static_cast<size_t>(std::stoull(argv[3], nullptr, 10));
+    Options opts(argc, argv, 4);
+    int64_t max_scan = opts.get_int("max_scan", 100);
+    IndexBackend backend = parse_index_backend(opts.get("index", "masstree"));
+    if (backend == IndexBackend::HASH) throw std::runtime_error("index cannot be hash");
+    int check_threads = opts.get_int("check", 0);
+    if (check_threads > 0) return check(backend, num_records, num_scans, check_threads);
+
+    Index& idx = Index::get_index();
+    idx.use_backend(ORDERLINE_TABLE, backend);
+    idx.use_backend(YCSB_TABLE, backend);
+    StrIndex str_idx;
+    std::vector<Row> rows;
+    rows.reserve(
+        num_warehouses * District::DISTS_PER_WARE * ORDERS_PER_DIST *
+            OrderLine::MAX_ORDLINES_PER_ORD +
+        num_records);
+
+    printf(
+        "Loading %u warehouse(s) of order lines and %" PRIu64 " YCSB records\n", num_warehouses,
+        num_records);
+    for (uint16_t w_id = 1; w_id <= num_warehouses; w_id++) {
+        for (uint8_t d_id = 1; d_id <= District::DISTS_PER_WARE; d_id++) {
+            for (uint32_t o_id = 1; o_id <= ORDERS_PER_DIST; o_id++) {
+                uint8_t ol_cnt =
+                    urand_int(OrderLine::MIN_ORDLINES_PER_ORD, OrderLine::MAX_ORDLINES_PER_ORD);
+                for (uint8_t ol_num = 1; ol_num <= ol_cnt; ol_num++) {
+                    rows.push_back(Row{rows.size()});
+                    auto key = OrderLine::Key::create_key(w_id, d_id, o_id, ol_num);
+                    idx.insert(ORDERLINE_TABLE, key.get_raw_key(), &rows.back());
+                    str_idx.insert(create_composite_key(key.get_raw_key()).view(), &rows.back());
+                }
+            }
+        }
+    }
+    for (uint64_t key = 0; key < num_records; key++) {
+        rows.push_back(Row{rows.size()});
+        idx.insert(YCSB_TABLE, key, &rows.back());
+    }
+    printf("Loaded\n");
+
+    std::vector<Range> ranges(num_scans);
+    for (Range& r: ranges) {
+        uint16_t w_id = urand_int(1, num_warehouses);
+        uint8_t d_id = urand_int(1, District::DISTS_PER_WARE);
+        uint32_t o_id = urand_int(21, ORDERS_PER_DIST + 1);
+        r.low = OrderLine::Key::create_key(w_id, d_id, o_id - 20, 1).get_raw_key();
+        r.up = OrderLine::Key::create_key(w_id, d_id, o_id, 1).get_raw_key();
+        r.count = -1;
+    }
+    run("orderline", ORDERLINE_TABLE, ranges);
+    run_composite("orderline (composite keys)", str_idx, ranges);
+
+    for (Range& r: ranges) {
+        r.low = urand_int(0, num_records - 1);
+        r.up = UINT64_MAX;
+        r.count = urand_int(1, max_scan);
+    }
+    run("ycsb", YCSB_TABLE, ranges);
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <inttypes.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "benchmarks/tpcc/include/benchmark.hpp"
+#include "benchmarks/tpcc/include/tx_batch.hpp"
+#include "benchmarks/tpcc/include/tx_runner.hpp"
+#include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "indexes/masstree.hpp"
+#include "protocols/calvin/include/calvin.hpp"
+#include "protocols/calvin/include/lock_manager.hpp"
+#include "protocols/calvin/include/value.hpp"
+#include "protocols/calvin/tpcc/initializer.hpp"
+#include "protocols/calvin/tpcc/lock_set.hpp"
+#include "protocols/calvin/tpcc/transaction.hpp"
+#include "protocols/common/epoch_manager.hpp"
+
+volatile mrcu_epoch_type active_epoch = 1;
+volatile std::uint64_t globalepoch = 1;
+volatile bool recovering = false;
+
+int main(int argc, const char* argv[]) {
+    Benchmark bench(argc, argv, "[batch=<transactions per epoch>]", Benchmark::NO_RETRY);
+
+    long batch_size = bench.get_options().get_int("batch", 10);
+    if (batch_size < 1) throw std::runtime_error("batch must be positive");
+    printf("%ld transaction(s) per epoch and worker\n", batch_size);
+
+    printf("Loading all tables with %" PRIu16 " warehouse(s)\n", bench.num_warehouses);
+
+    using Index = MasstreeIndexes<Value>;
+    using Protocol = Calvin<Index>;
+
+    Initializer<Index>::load_all_tables();
+    printf("Loaded\n");
+
+    EpochManager<Protocol> em(bench.num_threads, 40);
+
+    // Each worker generates the inputs of batch_size transactions, has them sequenced as one
+    // epoch and runs them in order
+    bench.run(em, [&](uint32_t worker_id, ThreadLocalData& t_data) {
+        Worker<Protocol> w(worker_id);
+        em.set_worker(worker_id, &w);
+        TxBatch batch(batch_size);
+        std::vector<LockSet> lock_sets(batch_size);
+        while (bench.is_running()) {
+            batch.generate(worker_id);
+            for (long i = 0; i < batch_size; i++) {
+                lock_sets[i].clear();
+                TxBatch::visit(batch[i], [&](auto& p) { declare_locks(p.input, lock_sets[i]); });
+            }
+            LockManager::get_lock_manager().sequence(lock_sets.data(), batch_size);
+
+            // Later transactions of other workers may wait for these, so the whole batch is run
+            // even if the benchmark is over
+            Stat& stat = t_data.stat;
+            Output& out = t_data.out;
+            for (long i = 0; i < batch_size; i++) {
+                Transaction tx(w);
+                tx.lock(lock_sets[i]);
+                TxBatch::visit(batch[i], [&](auto& p) { run_once(p, tx, stat, out); });
+            }
+        }
+    });
+
+    bench.report([] { printf("Epochs: %lu\n", LockManager::get_lock_manager().get_num_epochs()); });
+}
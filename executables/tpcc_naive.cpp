@@ -10,6 +10,7 @@
 #include "protocols/naive/include/initializer.hpp"
 #include "protocols/naive/include/transaction.hpp"
 #include "utils/logger.hpp"
+#include "utils/profiler.hpp"
 #include "utils/utils.hpp"
 
 void run_tx(int* flag, ThreadLocalData& t_data) {
@@ -111,4 +112,6 @@ int main(int argc, const char* argv[]) {
                 stat[p].abort_details[a]);
         });
     });
+
+    PROFILE_PRINT();
 }
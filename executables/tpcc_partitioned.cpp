@@ -0,0 +1,39 @@
+#include <inttypes.h>
+
+#include "benchmarks/tpcc/include/benchmark.hpp"
+#include "benchmarks/tpcc/include/tx_runner.hpp"
+#include "benchmarks/tpcc/include/tx_utils.hpp"
+#include "indexes/masstree.hpp"
+#include "protocols/common/epoch_manager.hpp"
+#include "protocols/partitioned/include/partitioned.hpp"
+#include "protocols/partitioned/include/value.hpp"
+#include "protocols/partitioned/tpcc/initializer.hpp"
+#include "protocols/partitioned/tpcc/transaction.hpp"
+
+volatile mrcu_epoch_type active_epoch = 1;
+volatile std::uint64_t globalepoch = 1;
+volatile bool recovering = false;
+
+int main(int argc, const char* argv[]) {
+    Benchmark bench(argc, argv, "");
+
+    printf("Loading all tables with %" PRIu16 " warehouse(s)\n", bench.num_warehouses);
+
+    using Index = MasstreeIndexes<Value>;
+    using Protocol = Partitioned<Index>;
+
+    Initializer<Index>::load_all_tables();
+    printf("Loaded\n");
+
+    EpochManager<Protocol> em(bench.num_threads, 40);
+    bench.run(em, [&](uint32_t worker_id, ThreadLocalData& t_data) {
+        Worker<Protocol> w(worker_id);
+        em.set_worker(worker_id, &w);
+        while (bench.is_running()) {
+            Transaction tx(w);
+            run_random_tx_with_retry(tx, t_data.stat, t_data.out);
+        }
+    });
+
+    bench.report();
+}
@@ -1,5 +1,6 @@
 #include <unistd.h>
 
+#include <memory>
 #include <string>
 #include <thread>
 
@@ -7,12 +8,16 @@
 #include "benchmarks/ycsb/include/tx_runner.hpp"
 #include "benchmarks/ycsb/include/tx_utils.hpp"
 #include "indexes/masstree.hpp"
+#include "protocols/common/memory_allocator.hpp"
 #include "protocols/common/timestamp_manager.hpp"
 #include "protocols/mvto/include/mvto.hpp"
 #include "protocols/mvto/include/value.hpp"
 #include "protocols/mvto/ycsb/initializer.hpp"
 #include "protocols/mvto/ycsb/transaction.hpp"
 #include "utils/logger.hpp"
+#include "utils/numa.hpp"
+#include "utils/options.hpp"
+#include "utils/profiler.hpp"
 #include "utils/utils.hpp"
 
 volatile mrcu_epoch_type active_epoch = 1;
@@ -28,7 +33,12 @@ using Record = Payload<PAYLOAD_SIZE>;
 
 template <typename Protocol>
 void run_tx(
-    int* flag, ThreadLocalData& t_data, uint32_t worker_id, TimeStampManager<Protocol>& tsm) {
+    int* flag, std::unique_ptr<ThreadLocalData>& t_data_ptr, uint32_t worker_id,
+    TimeStampManager<Protocol>& tsm) {
+    // Allocate worker local data after pinning so that it is placed on the local NUMA node
+    get_thread_pinning().pin(worker_id);
+    t_data_ptr = std::make_unique<ThreadLocalData>();
+    ThreadLocalData& t_data = *t_data_ptr;
     Worker<Protocol> w(tsm, worker_id, 1);
     tsm.set_worker(worker_id, &w);
 
@@ -60,8 +70,11 @@ void run_tx(
 }
 
 int main(int argc, const char* argv[]) {
-    if (argc != 7) {
-        printf("workload_type(A,B,C,F) num_records num_threads seconds skew reps_per_txn\n");
+    if (argc < 7) {
+        printf(
+            "workload_type(A,B,C,F) num_records num_threads seconds skew reps_per_txn "
+            "[pin=none|compact|scatter|<cpu list>] [hugepages=none|2m|1g] "
+            "[huge_gib=<1GiB pages>]\n");
         exit(1);
     }
 
@@ -74,6 +87,13 @@ int main(int argc, const char* argv[]) {
 
     assert(seconds > 0);
 
+    Options opts(argc, argv, 7);
+    ThreadPinning& pinning = get_thread_pinning();
+    pinning.configure(opts.get("pin", "none"), num_threads);
+    pinning.print();
+
+    MemoryAllocator::configure_pages(opts.get("hugepages", "none"), opts.get_int("huge_gib", 0));
+
     Config& c = get_mutable_config();
     c.set_workload_type(workload_type);
     c.set_num_records(num_records);
@@ -96,7 +116,7 @@ int main(int argc, const char* argv[]) {
 
     alignas(64) int flag = 1;
 
-    std::vector<ThreadLocalData> t_data(num_threads);
+    std::vector<std::unique_ptr<ThreadLocalData>> t_data(num_threads);
 
     for (int i = 0; i < num_threads; i++) {
         threads.emplace_back(run_tx<Protocol>, &flag, std::ref(t_data[i]), i, std::ref(tsm));
@@ -112,7 +132,7 @@ int main(int argc, const char* argv[]) {
 
     Stat stat;
     for (int i = 0; i < num_threads; i++) {
-        stat.add(t_data[i].stat);
+        stat.add(t_data[i]->stat);
     }
     Stat::PerTxType total = stat.aggregate_perf();
 
@@ -133,4 +153,6 @@ int main(int argc, const char* argv[]) {
             stat[p].num_commits / (double)total.num_commits, stat[p].num_usr_aborts,
             stat[p].num_sys_aborts);
     });
+
+    PROFILE_PRINT();
 }
\ No newline at end of file
@@ -0,0 +1,580 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "indexes/index_interface.hpp"
+#include "indexes/optimistic_lock.hpp"
+#include "utils/atomic_wrapper.hpp"
+
+/**
+ * Adaptive radix tree (Leis et al., ICDE 2013) of 64-bit keys synchronized with optimistic lock
+ * coupling (see indexes/optimistic_lock.hpp). Each inner node branches on one byte of the key
+ * (0: most significant) and has 4, 16, 48 or 256 children. Paths without branches are skipped:
+ * a node stores the bytes before its level, which all keys below it share, and a subtree with a
+ * single key is a leaf. Keys are 8 bytes, so the bytes are stored in full and a node is never
+ * changed by inserts below it that split its path; instead a new node is added between it and
+ * its parent.
+ * Inner nodes are the nodes of node verification (see indexes/index_interface.hpp): a key that
+ * is inserted changes the node whose child slot it is added to or replaces. A node that is full
+ * is replaced by a larger one and becomes obsolete, which also changes its version. Removed
+ * leaves and replaced nodes are freed with the tree, since readers may still be reading them and
+ * the tree has no epochs of its own: the memory of a table with many removes (NEW-ORDER under
+ * Delivery) grows until the tree is destroyed.
+ * The root is a Node256 that is never replaced.
+ */
+template <typename Value>
+class ARTOLC {
+public:
+    using Key = uint64_t;
+
+    ARTOLC()
+        : root(new Node256(0, 0)) {}
+
+    ~ARTOLC() {
+        free_child(as_child(root));
+        while (Node* node = retired_nodes.load(std::memory_order_relaxed)) {
+            retired_nodes.store(node->next_retired, std::memory_order_relaxed);
+            delete_node(node);
+        }
+        while (Leaf* leaf = retired_leaves.load(std::memory_order_relaxed)) {
+            retired_leaves.store(leaf->next_retired, std::memory_order_relaxed);
+            delete leaf;
+        }
+    }
+
+    ARTOLC(const ARTOLC&) = delete;
+    ARTOLC& operator=(const ARTOLC&) = delete;
+
+    // Returns nullptr if key is not found, and sets ni (if given) to the node it would be in
+    Value* find(Key key, IndexNodeInfo* ni) {
+        while (true) {
+            Node* node = root;
+            uint64_t version;
+            if (!node->lock.read_lock(version)) continue;
+            while (true) {
+                uintptr_t child = node->find_child(byte_at(key, node->level));
+                if (!node->lock.validate(version)) break;
+                if (child != 0 && is_leaf(child) && as_leaf(child)->key == key) {
+                    return as_leaf(child)->val;
+                }
+                if (child == 0 || is_leaf(child) || !as_node(child)->matches(key)) {
+                    if (ni) *ni = IndexNodeInfo{as_handle(node), version, version};
+                    return nullptr;
+                }
+                node = as_node(child);
+                if (!node->lock.read_lock(version)) break;
+            }
+        }
+    }
+
+    // Returns false if key is already in the tree. Otherwise ni (if given) is set to the node key
+    // was added to.
+    bool insert(Key key, Value* val, IndexNodeInfo* ni) {
+        while (true) {
+            Node* parent = nullptr;
+            uint64_t parent_version = 0;
+            uint8_t parent_byte = 0;
+            Node* node = root;
+            uint64_t version;
+            if (!node->lock.read_lock(version)) continue;
+            while (true) {
+                uint8_t b = byte_at(key, node->level);
+                uintptr_t child = node->find_child(b);
+                if (!node->lock.validate(version)) break;
+
+                if (child == 0 && !node->is_full()) {
+                    if (!node->lock.upgrade(version)) break;
+                    node->add_child(b, as_child(new Leaf(key, val)));
+                    uint64_t new_version = node->lock.unlock();
+                    if (ni) *ni = IndexNodeInfo{as_handle(node), version, new_version};
+                    return true;
+                }
+
+                if (child == 0) {
+                    // node is full, so it is not the root
+                    if (!parent->lock.upgrade(parent_version)) break;
+                    if (!node->lock.upgrade(version)) {
+                        parent->lock.unlock();
+                        break;
+                    }
+                    Node* larger = node->grow();
+                    larger->add_child(b, as_child(new Leaf(key, val)));
+                    parent->change_child(parent_byte, as_child(larger));
+                    node->lock.unlock_obsolete();
+                    parent->lock.unlock();
+                    retire(node);
+                    // node is obsolete and fails verification, larger was never seen
+                    uint64_t larger_version = larger->lock.get_version();
+                    if (ni) *ni = IndexNodeInfo{as_handle(larger), larger_version, larger_version};
+                    return true;
+                }
+
+                if (is_leaf(child) && as_leaf(child)->key == key) return false;
+                if (is_leaf(child) || !as_node(child)->matches(key)) {
+                    // A new node takes the place of the leaf or of the node whose path does not
+                    // match, with them and the new leaf as children
+                    Key other = is_leaf(child) ? as_leaf(child)->key : as_node(child)->prefix;
+                    if (!node->lock.upgrade(version)) break;
+                    uint8_t level = static_cast<uint8_t>(__builtin_clzll(key ^ other) / 8);
+                    Node* inner = new Node4(level, key);
+                    inner->ts = load_acquire(node->ts);
+                    inner->add_child(byte_at(other, level), child);
+                    inner->add_child(byte_at(key, level), as_child(new Leaf(key, val)));
+                    node->change_child(b, as_child(inner));
+                    uint64_t new_version = node->lock.unlock();
+                    // keys covered by node now belong to inner, which the caller cannot verify
+                    if (ni) {
+                        *ni = IndexNodeInfo{
+                            as_handle(node), OptimisticLock::locked_version(version), new_version};
+                    }
+                    return true;
+                }
+
+                parent = node;
+                parent_version = version;
+                parent_byte = b;
+                node = as_node(child);
+                if (!node->lock.read_lock(version)) break;
+            }
+        }
+    }
+
+    // Returns false if key is not found. Nodes are not shrunk or removed.
+    bool remove(Key key) {
+        while (true) {
+            Node* node = root;
+            uint64_t version;
+            if (!node->lock.read_lock(version)) continue;
+            while (true) {
+                uint8_t b = byte_at(key, node->level);
+                uintptr_t child = node->find_child(b);
+                if (!node->lock.validate(version)) break;
+                if (child == 0) return false;
+                if (is_leaf(child)) {
+                    if (as_leaf(child)->key != key) return false;
+                    if (!node->lock.upgrade(version)) break;
+                    node->remove_child(b);
+                    node->lock.unlock();
+                    retire(as_leaf(child));
+                    return true;
+                }
+                if (!as_node(child)->matches(key)) return false;
+                node = as_node(child);
+                if (!node->lock.read_lock(version)) break;
+            }
+        }
+    }
+
+    /**
+     * Calls per_node_func(IndexNode*, uint64_t version, bool& continue_flag) for each node that
+     * covers a part of the range and per_kv_func(Key, Value*, bool& continue_flag) for each key
+     * in it, in ascending order (descending if reverse), until max_scan_num keys (-1: all) are
+     * visited. Nodes are visited depth-first. If a node changes while it is read, the scan
+     * starts again from the root after the last key visited.
+     */
+    template <typename NodeFunc, typename KVFunc>
+    void scan(
+        Key lkey, bool lexclusive, Key rkey, bool rexclusive, bool reverse,
+        NodeFunc&& per_node_func, KVFunc&& per_kv_func, int64_t max_scan_num) {
+        if (lexclusive && lkey++ == UINT64_MAX) return;
+        if (rexclusive && rkey-- == 0) return;
+        if (lkey > rkey) return;
+
+        ScanState s{lkey, rkey, reverse, max_scan_num};
+        while (true) {
+            uint64_t version;
+            if (!root->lock.read_lock(version)) continue;
+            if (scan_node(root, version, s, per_node_func, per_kv_func) != Step::RESTART) return;
+        }
+    }
+
+    uint64_t get_version_value(IndexNode* node) { return as_node(node)->lock.get_version(); }
+
+    uint64_t get_ts(IndexNode* node) { return load_acquire(as_node(node)->ts); }
+
+    void update_ts(IndexNode* node, uint64_t ts) { update_node_ts(as_node(node)->ts, ts); }
+
+private:
+    enum class Type : uint8_t { N4, N16, N48, N256 };
+
+    // Children are tagged pointers, leaves have the lowest bit set
+    struct Leaf {
+        Leaf(Key key, Value* val)
+            : key(key)
+            , val(val) {}
+        const Key key;
+        Value* const val;
+        Leaf* next_retired = nullptr;
+    };
+
+    struct Node {
+        Node(Type type, uint8_t level, Key key)
+            : type(type)
+            , level(level)
+            , prefix(key & prefix_mask(level)) {}
+
+        OptimisticLock lock;
+        uint64_t ts = 0;  // see update_node_ts()
+        const Type type;
+        const uint8_t level;  // byte of the key the node branches on
+        const Key prefix;     // bytes before level (the others are 0)
+        uint16_t count = 0;
+        Node* next_retired = nullptr;
+
+        bool matches(Key key) const { return ((key ^ prefix) & prefix_mask(level)) == 0; }
+
+        // Whether some keys of [low, high] can be below the node
+        bool intersects(Key low, Key high) const {
+            return prefix <= high && (prefix | ~prefix_mask(level)) >= low;
+        }
+
+        uintptr_t find_child(uint8_t b);
+        bool is_full();
+        void add_child(uint8_t b, uintptr_t child);
+        void change_child(uint8_t b, uintptr_t child);
+        void remove_child(uint8_t b);
+        Node* grow();
+        bool next_child(int low, int high, bool reverse, int& b, uintptr_t& child);
+    };
+
+    // Node4 and Node16: children in the order of their bytes
+    template <size_t N, Type T>
+    struct NodeSorted : public Node {
+        NodeSorted(uint8_t level, Key key)
+            : Node(T, level, key) {}
+
+        uint8_t bytes[N];
+        uintptr_t children[N];
+
+        size_t size() { return std::min<size_t>(load(this->count), N); }
+
+        uintptr_t find_child(uint8_t b) {
+            for (size_t i = 0; i < size(); i++) {
+                if (load(bytes[i]) == b) return load(children[i]);
+            }
+            return 0;
+        }
+
+        void add_child(uint8_t b, uintptr_t child) {
+            size_t i = size();
+            for (; i > 0 && bytes[i - 1] > b; i--) {
+                store(bytes[i], bytes[i - 1]);
+                store(children[i], children[i - 1]);
+            }
+            store(bytes[i], b);
+            store(children[i], child);
+            store(this->count, this->count + 1);
+        }
+
+        void change_child(uint8_t b, uintptr_t child) {
+            for (size_t i = 0; i < size(); i++) {
+                if (bytes[i] == b) store(children[i], child);
+            }
+        }
+
+        void remove_child(uint8_t b) {
+            size_t n = size();
+            size_t i = 0;
+            while (i < n && bytes[i] != b) i++;
+            for (; i + 1 < n; i++) {
+                store(bytes[i], bytes[i + 1]);
+                store(children[i], children[i + 1]);
+            }
+            store(this->count, this->count - 1);
+        }
+
+        bool next_child(int low, int high, bool reverse, int& b, uintptr_t& child) {
+            size_t n = size();
+            for (size_t j = 0; j < n; j++) {
+                size_t i = reverse ? n - 1 - j : j;
+                int bi = load(bytes[i]);
+                if (bi < low || bi > high) continue;
+                b = bi;
+                child = load(children[i]);
+                return true;
+            }
+            return false;
+        }
+    };
+
+    using Node4 = NodeSorted<4, Type::N4>;
+    using Node16 = NodeSorted<16, Type::N16>;
+
+    struct Node48 : public Node {
+        Node48(uint8_t level, Key key)
+            : Node(Type::N48, level, key) {}
+
+        uint8_t slots[256] = {};  // 0: no child, otherwise index into children + 1
+        uintptr_t children[48] = {};
+
+        uintptr_t find_child(uint8_t b) {
+            uint8_t slot = load(slots[b]);
+            return slot == 0 ? 0 : load(children[(slot - 1) % 48]);
+        }
+
+        void add_child(uint8_t b, uintptr_t child) {
+            uint8_t i = 0;
+            while (children[i] != 0) i++;
+            store(children[i], child);
+            store(slots[b], i + 1);
+            store(this->count, this->count + 1);
+        }
+
+        void change_child(uint8_t b, uintptr_t child) { store(children[slots[b] - 1], child); }
+
+        void remove_child(uint8_t b) {
+            store(children[slots[b] - 1], 0);
+            store(slots[b], 0);
+            store(this->count, this->count - 1);
+        }
+
+        bool next_child(int low, int high, bool reverse, int& b, uintptr_t& child) {
+            for (int j = low; j <= high; j++) {
+                int bi = reverse ? high - (j - low) : j;
+                uint8_t slot = load(slots[bi]);
+                if (slot == 0) continue;
+                b = bi;
+                child = load(children[(slot - 1) % 48]);
+                return true;
+            }
+            return false;
+        }
+    };
+
+    struct Node256 : public Node {
+        Node256(uint8_t level, Key key)
+            : Node(Type::N256, level, key) {}
+
+        uintptr_t children[256] = {};
+
+        uintptr_t find_child(uint8_t b) { return load(children[b]); }
+
+        void add_child(uint8_t b, uintptr_t child) {
+            store(children[b], child);
+            store(this->count, this->count + 1);
+        }
+
+        void change_child(uint8_t b, uintptr_t child) { store(children[b], child); }
+
+        void remove_child(uint8_t b) {
+            store(children[b], 0);
+            store(this->count, this->count - 1);
+        }
+
+        bool next_child(int low, int high, bool reverse, int& b, uintptr_t& child) {
+            for (int j = low; j <= high; j++) {
+                int bi = reverse ? high - (j - low) : j;
+                uintptr_t c = load(children[bi]);
+                if (c == 0) continue;
+                b = bi;
+                child = c;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    enum class Step { CONTINUE, STOP, RESTART };
+
+    struct ScanState {
+        Key low;  // keys left to visit, moved past each key visited
+        Key high;
+        const bool reverse;
+        const int64_t max_scan_num;
+        int64_t scanned = 0;
+        bool continue_flag = true;
+    };
+
+    Node* const root;
+    std::atomic<Node*> retired_nodes{nullptr};
+    std::atomic<Leaf*> retired_leaves{nullptr};
+
+    static Key prefix_mask(uint8_t level) { return level == 0 ? 0 : ~Key(0) << (64 - 8 * level); }
+
+    static uint8_t byte_at(Key key, uint8_t level) {
+        return static_cast<uint8_t>(key >> (56 - 8 * level));
+    }
+
+    static bool is_leaf(uintptr_t child) { return child & 1; }
+
+    static Leaf* as_leaf(uintptr_t child) { return reinterpret_cast<Leaf*>(child & ~uintptr_t(1)); }
+
+    static Node* as_node(uintptr_t child) { return reinterpret_cast<Node*>(child); }
+
+    static uintptr_t as_child(Leaf* leaf) { return reinterpret_cast<uintptr_t>(leaf) | 1; }
+
+    static uintptr_t as_child(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+
+    static IndexNode* as_handle(Node* node) { return reinterpret_cast<IndexNode*>(node); }
+
+    static Node* as_node(IndexNode* node) { return reinterpret_cast<Node*>(node); }
+
+    template <typename NodeFunc, typename KVFunc>
+    Step scan_node(
+        Node* node, uint64_t version, ScanState& s, NodeFunc& per_node_func, KVFunc& per_kv_func) {
+        per_node_func(as_handle(node), version, s.continue_flag);
+        if (!s.continue_flag) return Step::STOP;
+
+        // bytes of the node in the range; a bound outside the path of the node is beyond it
+        int low = node->matches(s.low) ? byte_at(s.low, node->level) : 0;
+        int high = node->matches(s.high) ? byte_at(s.high, node->level) : 255;
+        while (low <= high) {
+            int b;
+            uintptr_t child;
+            bool found = node->next_child(low, high, s.reverse, b, child);
+            if (!node->lock.validate(version)) return Step::RESTART;
+            if (!found) break;
+            if (s.reverse) {
+                high = b - 1;
+            } else {
+                low = b + 1;
+            }
+
+            if (is_leaf(child)) {
+                Leaf* leaf = as_leaf(child);
+                if (leaf->key < s.low || leaf->key > s.high) continue;
+                if (s.max_scan_num >= 0 && s.scanned >= s.max_scan_num) return Step::STOP;
+                per_kv_func(leaf->key, leaf->val, s.continue_flag);
+                s.scanned++;
+                if (!s.continue_flag) return Step::STOP;
+                if (s.reverse) {
+                    if (leaf->key == s.low) return Step::STOP;
+                    s.high = leaf->key - 1;
+                } else {
+                    if (leaf->key == s.high) return Step::STOP;
+                    s.low = leaf->key + 1;
+                }
+            } else if (as_node(child)->intersects(s.low, s.high)) {
+                Node* next = as_node(child);
+                uint64_t next_version;
+                if (!next->lock.read_lock(next_version)) return Step::RESTART;
+                Step step = scan_node(next, next_version, s, per_node_func, per_kv_func);
+                if (step != Step::CONTINUE) return step;
+            }
+        }
+        if (s.max_scan_num >= 0 && s.scanned >= s.max_scan_num) return Step::STOP;
+        return Step::CONTINUE;
+    }
+
+    void retire(Node* node) {
+        node->next_retired = retired_nodes.load(std::memory_order_relaxed);
+        while (!retired_nodes.compare_exchange_weak(
+            node->next_retired, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    void retire(Leaf* leaf) {
+        leaf->next_retired = retired_leaves.load(std::memory_order_relaxed);
+        while (!retired_leaves.compare_exchange_weak(
+            leaf->next_retired, leaf, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    static void delete_node(Node* node) {
+        switch (node->type) {
+        case Type::N4: delete static_cast<Node4*>(node); break;
+        case Type::N16: delete static_cast<Node16*>(node); break;
+        case Type::N48: delete static_cast<Node48*>(node); break;
+        case Type::N256: delete static_cast<Node256*>(node); break;
+        }
+    }
+
+    static void free_child(uintptr_t child) {
+        if (child == 0) return;
+        if (is_leaf(child)) {
+            delete as_leaf(child);
+            return;
+        }
+        Node* node = as_node(child);
+        int b;
+        uintptr_t c;
+        for (int low = 0; low <= 255 && node->next_child(low, 255, false, b, c); low = b + 1) {
+            free_child(c);
+        }
+        delete_node(node);
+    }
+};
+
+// Operations on nodes of any type, dispatched on the type
+
+template <typename Value>
+uintptr_t ARTOLC<Value>::Node::find_child(uint8_t b) {
+    switch (type) {
+    case Type::N4: return static_cast<Node4*>(this)->find_child(b);
+    case Type::N16: return static_cast<Node16*>(this)->find_child(b);
+    case Type::N48: return static_cast<Node48*>(this)->find_child(b);
+    default: return static_cast<Node256*>(this)->find_child(b);
+    }
+}
+
+template <typename Value>
+bool ARTOLC<Value>::Node::is_full() {
+    uint16_t n = load(count);
+    switch (type) {
+    case Type::N4: return n >= 4;
+    case Type::N16: return n >= 16;
+    case Type::N48: return n >= 48;
+    default: return false;
+    }
+}
+
+template <typename Value>
+void ARTOLC<Value>::Node::add_child(uint8_t b, uintptr_t child) {
+    switch (type) {
+    case Type::N4: static_cast<Node4*>(this)->add_child(b, child); break;
+    case Type::N16: static_cast<Node16*>(this)->add_child(b, child); break;
+    case Type::N48: static_cast<Node48*>(this)->add_child(b, child); break;
+    case Type::N256: static_cast<Node256*>(this)->add_child(b, child); break;
+    }
+}
+
+template <typename Value>
+void ARTOLC<Value>::Node::change_child(uint8_t b, uintptr_t child) {
+    switch (type) {
+    case Type::N4: static_cast<Node4*>(this)->change_child(b, child); break;
+    case Type::N16: static_cast<Node16*>(this)->change_child(b, child); break;
+    case Type::N48: static_cast<Node48*>(this)->change_child(b, child); break;
+    case Type::N256: static_cast<Node256*>(this)->change_child(b, child); break;
+    }
+}
+
+template <typename Value>
+void ARTOLC<Value>::Node::remove_child(uint8_t b) {
+    switch (type) {
+    case Type::N4: static_cast<Node4*>(this)->remove_child(b); break;
+    case Type::N16: static_cast<Node16*>(this)->remove_child(b); break;
+    case Type::N48: static_cast<Node48*>(this)->remove_child(b); break;
+    case Type::N256: static_cast<Node256*>(this)->remove_child(b); break;
+    }
+}
+
+template <typename Value>
+bool ARTOLC<Value>::Node::next_child(int low, int high, bool reverse, int& b, uintptr_t& child) {
+    switch (type) {
+    case Type::N4: return static_cast<Node4*>(this)->next_child(low, high, reverse, b, child);
+    case Type::N16: return static_cast<Node16*>(this)->next_child(low, high, reverse, b, child);
+    case Type::N48: return static_cast<Node48*>(this)->next_child(low, high, reverse, b, child);
+    default: return static_cast<Node256*>(this)->next_child(low, high, reverse, b, child);
+    }
+}
+
+// Copy of a full node with room for more children, called with the lock held
+template <typename Value>
+typename ARTOLC<Value>::Node* ARTOLC<Value>::Node::grow() {
+    Node* larger;
+    switch (type) {
+    case Type::N4: larger = new Node16(level, prefix); break;
+    case Type::N16: larger = new Node48(level, prefix); break;
+    default: larger = new Node256(level, prefix); break;
+    }
+    larger->ts = load_acquire(ts);
+    int b;
+    uintptr_t child;
+    for (int low = 0; low <= 255 && next_child(low, 255, false, b, child); low = b + 1) {
+        larger->add_child(static_cast<uint8_t>(b), child);
+    }
+    return larger;
+}
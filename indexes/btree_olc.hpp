@@ -0,0 +1,463 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "indexes/index_interface.hpp"
+#include "indexes/optimistic_lock.hpp"
+#include "utils/atomic_wrapper.hpp"
+
+/**
+ * B+tree of 64-bit keys synchronized with optimistic lock coupling (see
+ * indexes/optimistic_lock.hpp), after the B+tree of Leis et al. Lookups and scans take no
+ * locks. Full nodes are split on the way down, so an insert locks at most a node and its
+ * parent. Nodes are never merged: removing keys leaves underfull leaves behind, and nodes are
+ * only freed with the tree.
+ * Child i of an inner node covers the keys in (keys[i-1], keys[i]], so each key belongs to one
+ * leaf, and the leaves are the nodes of node verification (see indexes/index_interface.hpp):
+ * the version of a leaf changes whenever a key is inserted into or removed from it, or it is
+ * split. Scans go from leaf to leaf by descending again from the root to the key that follows
+ * the bound of the leaf, so leaves have no sibling pointers.
+ */
+template <typename Value>
+class BTreeOLC {
+public:
+    using Key = uint64_t;
+
+    BTreeOLC()
+        : root(new Leaf()) {}
+
+    ~BTreeOLC() { free_node(root); }
+
+    BTreeOLC(const BTreeOLC&) = delete;
+    BTreeOLC& operator=(const BTreeOLC&) = delete;
+
+    // Returns nullptr if key is not found, and sets ni (if given) to the leaf it would be in
+    Value* find(Key key, IndexNodeInfo* ni) {
+        while (true) {
+            Path p;
+            if (!descend(key, p)) continue;
+            size_t i = p.leaf->lower_bound(key);
+            Value* val = p.leaf->has_key_at(i, key) ? load(p.leaf->vals[i]) : nullptr;
+            if (!p.leaf->lock.validate(p.version)) continue;
+            if (val == nullptr && ni) *ni = IndexNodeInfo{as_handle(p.leaf), p.version, p.version};
+            return val;
+        }
+    }
+
+    // Returns false if key is already in the tree. Otherwise ni (if given) is set to the leaf key
+    // was inserted into.
+    bool insert(Key key, Value* val, IndexNodeInfo* ni) {
+        while (true) {
+            Node* node = load_acquire(root);
+            uint64_t version;
+            if (!node->lock.read_lock(version) || node != load_acquire(root)) continue;
+
+            Inner* parent = nullptr;
+            uint64_t parent_version = 0;
+            bool restart = false;
+            while (node->is_inner) {
+                Inner* inner = static_cast<Inner*>(node);
+                if (inner->is_full()) {
+                    split(parent, parent_version, node, version);
+                    restart = true;
+                    break;
+                }
+                if (parent && !parent->lock.validate(parent_version)) {
+                    restart = true;
+                    break;
+                }
+                parent = inner;
+                parent_version = version;
+                node = inner->child(inner->lower_bound(key));
+                if (!inner->lock.validate(parent_version) || !node->lock.read_lock(version) ||
+                    !inner->lock.validate(parent_version)) {
+                    restart = true;
+                    break;
+                }
+            }
+            if (restart) continue;
+
+            Leaf* leaf = static_cast<Leaf*>(node);
+            size_t i = leaf->lower_bound(key);
+            bool found = leaf->has_key_at(i, key);
+            if (!leaf->lock.validate(version)) continue;
+            if (found) return false;
+            if (leaf->is_full()) {
+                split(parent, parent_version, leaf, version);
+                continue;
+            }
+            // The leaf still covers key if its version is unchanged: the parent was validated
+            // after the version was read, and leaves only lose keys to the leaves split from them.
+            if (!leaf->lock.upgrade(version)) continue;
+            leaf->insert_at(i, key, val);
+            uint64_t new_version = leaf->lock.unlock();
+            if (ni) *ni = IndexNodeInfo{as_handle(leaf), version, new_version};
+            return true;
+        }
+    }
+
+    // Returns false if key is not found
+    bool remove(Key key) {
+        while (true) {
+            Path p;
+            if (!descend(key, p)) continue;
+            size_t i = p.leaf->lower_bound(key);
+            bool found = p.leaf->has_key_at(i, key);
+            if (!p.leaf->lock.validate(p.version)) continue;
+            if (!found) return false;
+            if (!p.leaf->lock.upgrade(p.version)) continue;
+            p.leaf->erase_at(i);
+            p.leaf->lock.unlock();
+            return true;
+        }
+    }
+
+    /**
+     * Calls per_node_func(IndexNode*, uint64_t version, bool& continue_flag) for each leaf that
+     * covers a part of the range and per_kv_func(Key, Value*, bool& continue_flag) for each key
+     * in it, in ascending order (descending if reverse), until max_scan_num keys (-1: all) are
+     * visited. The keys of a leaf are passed after all of them are read at the version given to
+     * per_node_func. If a leaf changes before it is read completely, it is read again.
+     */
+    template <typename NodeFunc, typename KVFunc>
+    void scan(
+        Key lkey, bool lexclusive, Key rkey, bool rexclusive, bool reverse,
+        NodeFunc&& per_node_func, KVFunc&& per_kv_func, int64_t max_scan_num) {
+        if (lexclusive && lkey++ == UINT64_MAX) return;
+        if (rexclusive && rkey-- == 0) return;
+        if (lkey > rkey) return;
+
+        Key keys[LEAF_KEYS];
+        Value* vals[LEAF_KEYS];
+        Key pos = reverse ? rkey : lkey;
+        int64_t scanned = 0;
+        bool continue_flag = true;
+        while (true) {
+            Path p;
+            if (!descend(pos, p)) continue;
+            Key low = reverse ? lkey : pos;
+            Key high = reverse ? pos : rkey;
+            size_t n = 0;
+            for (size_t i = 0; i < p.leaf->size(); i++) {
+                Key k = load(p.leaf->keys[i]);
+                if (k < low || k > high) continue;
+                keys[n] = k;
+                vals[n++] = load(p.leaf->vals[i]);
+            }
+            if (!p.leaf->lock.validate(p.version)) continue;
+
+            per_node_func(as_handle(p.leaf), p.version, continue_flag);
+            if (!continue_flag) return;
+            for (size_t i = 0; i < n; i++) {
+                if (max_scan_num >= 0 && scanned >= max_scan_num) return;
+                size_t j = reverse ? n - 1 - i : i;
+                per_kv_func(keys[j], vals[j], continue_flag);
+                scanned++;
+                if (!continue_flag) return;
+            }
+            if (max_scan_num >= 0 && scanned >= max_scan_num) return;
+
+            if (reverse) {
+                if (!p.has_low || p.low < lkey) return;
+                pos = p.low;  // the leaf covers keys > p.low
+            } else {
+                if (!p.has_high || p.high >= rkey) return;
+                pos = p.high + 1;  // the leaf covers keys <= p.high
+            }
+        }
+    }
+
+    uint64_t get_version_value(IndexNode* node) { return as_leaf(node)->lock.get_version(); }
+
+    uint64_t get_ts(IndexNode* node) { return load_acquire(as_leaf(node)->ts); }
+
+    void update_ts(IndexNode* node, uint64_t ts) { update_node_ts(as_leaf(node)->ts, ts); }
+
+private:
+    static constexpr size_t LEAF_KEYS = 32;
+    static constexpr size_t INNER_KEYS = 64;
+
+    struct Node {
+        explicit Node(bool is_inner)
+            : is_inner(is_inner) {}
+        OptimisticLock lock;
+        const bool is_inner;
+        uint32_t count = 0;
+    };
+
+    struct Leaf : public Node {
+        Leaf()
+            : Node(false) {}
+
+        uint64_t ts = 0;  // see update_node_ts()
+        Key keys[LEAF_KEYS];
+        Value* vals[LEAF_KEYS];
+
+        // count read by an optimistic reader may be torn, so it is bounded by the capacity
+        size_t size() { return std::min<size_t>(load(this->count), LEAF_KEYS); }
+
+        bool is_full() { return size() == LEAF_KEYS; }
+
+        size_t lower_bound(Key key) { return lower_bound_in(keys, size(), key); }
+
+        bool has_key_at(size_t i, Key key) { return i < size() && load(keys[i]) == key; }
+
+        // Below are called with the lock held
+        void insert_at(size_t i, Key key, Value* val) {
+            for (size_t j = size(); j > i; j--) {
+                store(keys[j], keys[j - 1]);
+                store(vals[j], vals[j - 1]);
+            }
+            store(keys[i], key);
+            store(vals[i], val);
+            store(this->count, this->count + 1);
+        }
+
+        void erase_at(size_t i) {
+            for (size_t j = i + 1; j < size(); j++) {
+                store(keys[j - 1], keys[j]);
+                store(vals[j - 1], vals[j]);
+            }
+            store(this->count, this->count - 1);
+        }
+
+        // Moves the upper half to a new leaf; sep is the largest key left in this leaf
+        Leaf* split(Key& sep) {
+            Leaf* right = new Leaf();
+            size_t left_count = this->count / 2;
+            right->count = this->count - left_count;
+            std::copy(keys + left_count, keys + this->count, right->keys);
+            std::copy(vals + left_count, vals + this->count, right->vals);
+            right->ts = load_acquire(ts);
+            store(this->count, left_count);
+            sep = keys[left_count - 1];
+            return right;
+        }
+    };
+
+    struct Inner : public Node {
+        Inner()
+            : Node(true) {}
+
+        Inner(Key sep, Node* left, Node* right)
+            : Node(true) {
+            this->count = 1;
+            keys[0] = sep;
+            children[0] = left;
+            children[1] = right;
+        }
+
+        Key keys[INNER_KEYS];
+        Node* children[INNER_KEYS + 1];
+
+        size_t size() { return std::min<size_t>(load(this->count), INNER_KEYS); }
+
+        bool is_full() { return size() == INNER_KEYS; }
+
+        size_t lower_bound(Key key) { return lower_bound_in(keys, size(), key); }
+
+        Node* child(size_t i) { return load(children[i]); }
+
+        // Below are called with the lock held
+        // Adds the separator of a child that was split and the new right child
+        void insert(Key sep, Node* right) {
+            size_t i = lower_bound(sep);
+            for (size_t j = size(); j > i; j--) {
+                store(keys[j], keys[j - 1]);
+                store(children[j + 1], children[j]);
+            }
+            store(keys[i], sep);
+            store(children[i + 1], right);
+            store(this->count, this->count + 1);
+        }
+
+        // Moves the upper half to a new node; sep is the key between the two halves, which
+        // moves up to the parent
+        Inner* split(Key& sep) {
+            Inner* right = new Inner();
+            size_t n = this->count;
+            right->count = n - n / 2;
+            size_t left_count = n - right->count - 1;
+            std::copy(keys + left_count + 1, keys + n, right->keys);
+            std::copy(children + left_count + 1, children + n + 1, right->children);
+            store(this->count, left_count);
+            sep = keys[left_count];
+            return right;
+        }
+    };
+
+    struct Path {
+        Leaf* leaf;
+        uint64_t version;
+        Key low;  // the leaf covers (low, high]
+        Key high;
+        bool has_low = false;
+        bool has_high = false;
+    };
+
+public:
+    /**
+     * Lookup of one key that visits one node of the descent per step() and prefetches the node
+     * it visits next, so that the caller can do other work (such as stepping other lookups)
+     * while the node is fetched from memory. It restarts from the root like find() when a
+     * version changes.
+     */
+    class Lookup {
+    public:
+        Lookup() = default;
+
+        Lookup(BTreeOLC& tree, Key key)
+            : tree(&tree)
+            , key(key) {}
+
+        // Returns false once the lookup is done; get_value() then returns what find() would
+        bool step() {
+            if (node == nullptr) {
+                node = load_acquire(tree->root);
+                parent = nullptr;
+            }
+            uint64_t version;
+            bool valid = node->lock.read_lock(version)
+                && (parent ? parent->lock.validate(parent_version)
+                           : node == load_acquire(tree->root));
+            if (!valid) {
+                node = nullptr;
+                return true;
+            }
+            if (node->is_inner) {
+                Inner* inner = static_cast<Inner*>(node);
+                Node* child = inner->child(inner->lower_bound(key));
+                if (!inner->lock.validate(version)) {
+                    node = nullptr;
+                    return true;
+                }
+                // The parent is validated again after the version of the child is read
+                prefetch_node(child);
+                parent = inner;
+                parent_version = version;
+                node = child;
+                return true;
+            }
+            Leaf* leaf = static_cast<Leaf*>(node);
+            size_t i = leaf->lower_bound(key);
+            Value* v = leaf->has_key_at(i, key) ? load(leaf->vals[i]) : nullptr;
+            if (!leaf->lock.validate(version)) {
+                node = nullptr;
+                return true;
+            }
+            val = v;
+            return false;
+        }
+
+        Value* get_value() const { return val; }
+
+    private:
+        BTreeOLC* tree = nullptr;
+        Key key = 0;
+        Node* node = nullptr;  // visited next, nullptr to start from the root
+        Inner* parent = nullptr;
+        uint64_t parent_version = 0;
+        Value* val = nullptr;
+    };
+
+private:
+    Node* root;
+
+    static size_t lower_bound_in(Key* keys, size_t n, Key key) {
+        size_t lower = 0;
+        size_t upper = n;
+        while (lower < upper) {
+            size_t mid = (lower + upper) / 2;
+            if (load(keys[mid]) < key) {
+                lower = mid + 1;
+            } else {
+                upper = mid;
+            }
+        }
+        return lower;
+    }
+
+    static IndexNode* as_handle(Leaf* leaf) { return reinterpret_cast<IndexNode*>(leaf); }
+
+    static Leaf* as_leaf(IndexNode* node) { return reinterpret_cast<Leaf*>(node); }
+
+    // Prefetches what a lookup reads of a node: the keys of an inner node, which end before
+    // the values of a leaf end, or the keys and values of a leaf
+    static void prefetch_node(const Node* node) {
+        const char* p = reinterpret_cast<const char*>(node);
+        for (size_t offset = 0; offset < sizeof(Leaf); offset += 64) {
+            __builtin_prefetch(p + offset);
+        }
+    }
+
+    // Finds the leaf covering key. Returns false if the caller has to restart.
+    bool descend(Key key, Path& p) {
+        Node* node = load_acquire(root);
+        uint64_t version;
+        if (!node->lock.read_lock(version) || node != load_acquire(root)) return false;
+        while (node->is_inner) {
+            Inner* inner = static_cast<Inner*>(node);
+            size_t i = inner->lower_bound(key);
+            if (i > 0) {
+                p.low = load(inner->keys[i - 1]);
+                p.has_low = true;
+            }
+            if (i < inner->size()) {
+                p.high = load(inner->keys[i]);
+                p.has_high = true;
+            }
+            // The parent is validated again after the version of the child is read, so the child
+            // was not split in between
+            uint64_t parent_version = version;
+            node = inner->child(i);
+            if (!inner->lock.validate(parent_version) || !node->lock.read_lock(version) ||
+                !inner->lock.validate(parent_version)) {
+                return false;
+            }
+        }
+        p.leaf = static_cast<Leaf*>(node);
+        p.version = version;
+        return true;
+    }
+
+    // Splits a full node whose parent is not full, or adds a new root above it. The caller
+    // restarts afterwards, also if a version has changed and nothing is split.
+    void split(Inner* parent, uint64_t parent_version, Node* node, uint64_t version) {
+        if (parent && !parent->lock.upgrade(parent_version)) return;
+        if (!node->lock.upgrade(version)) {
+            if (parent) parent->lock.unlock();
+            return;
+        }
+        if (!parent && node != load_acquire(root)) {
+            // another thread has added a root above node
+            node->lock.unlock();
+            return;
+        }
+        Key sep;
+        Node* right;
+        if (node->is_inner) {
+            right = static_cast<Inner*>(node)->split(sep);
+        } else {
+            right = static_cast<Leaf*>(node)->split(sep);
+        }
+        if (parent) {
+            parent->insert(sep, right);
+        } else {
+            store_release(root, new Inner(sep, node, right));
+        }
+        node->lock.unlock();
+        if (parent) parent->lock.unlock();
+    }
+
+    static void free_node(Node* node) {
+        if (node->is_inner) {
+            Inner* inner = static_cast<Inner*>(node);
+            for (size_t i = 0; i <= inner->count; i++) free_node(inner->children[i]);
+            delete inner;
+        } else {
+            delete static_cast<Leaf*>(node);
+        }
+    }
+};
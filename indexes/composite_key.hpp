@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Key made of several fields, encoded so that comparing keys with memcmp (the order of
+ * MasstreeStrIndex::StrKey) compares the fields in the order they were appended:
+ *   unsigned integers are stored big-endian in sizeof(T) bytes
+ *   C strings are stored without their terminating '\0' followed by one '\0', so a string
+ *   sorts before its extensions (strings must not contain '\0')
+ * The key is built in place in a buffer of Capacity bytes, usually on the stack, and view()
+ * hands that buffer to the index without copying it. Fields are not limited to bit widths
+ * chosen in advance, e.g. a 32-bit warehouse id only costs 4 bytes of key.
+ */
+template <size_t Capacity>
+class CompositeKey {
+public:
+    template <typename T>
+    CompositeKey& append(T v) {
+        static_assert(std::is_integral_v<T> && std::is_unsigned_v<T>, "unsigned integers only");
+        check(sizeof(T));
+        for (size_t i = 0; i < sizeof(T); i++) {
+            buf[len + i] = static_cast<char>(v >> (8 * (sizeof(T) - 1 - i)));
+        }
+        len += sizeof(T);
+        return *this;
+    }
+
+    CompositeKey& append_cstr(const char* s, size_t max_len) {
+        size_t n = strnlen(s, max_len);
+        check(n + 1);
+        memcpy(&buf[len], s, n);
+        buf[len + n] = '\0';
+        len += n + 1;
+        return *this;
+    }
+
+    std::string_view view() const { return std::string_view(buf, len); }
+
+    size_t size() const { return len; }
+
+private:
+    char buf[Capacity];
+    size_t len = 0;
+
+    void check(size_t n) const {
+        if (len + n > Capacity) throw std::runtime_error("CompositeKey capacity exceeded");
+    }
+};
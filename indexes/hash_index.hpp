@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * Lock-free hash index of 64-bit keys for tables that are only accessed by exact key. Each
+ * bucket is a singly-linked chain of nodes pushed at its head with a CAS. A key keeps its node
+ * once inserted: remove() only clears the value of the node (nullptr means absent), and a later
+ * insert() of the same key sets it again, so nodes are never unlinked or freed while the index
+ * is in use and readers need no epochs. Two inserts of the same key cannot both add a node,
+ * since the loser's CAS on the bucket head fails and it finds the key when it retries.
+ * The number of buckets is fixed (the next power of two of the expected number of keys).
+ */
+template <typename Value>
+class HashIndex {
+public:
+    using Key = uint64_t;
+
+    explicit HashIndex(size_t expected_keys)
+        : shift(64 - get_bits(expected_keys))
+        , buckets(new std::atomic<Node*>[size_t(1) << (64 - shift)]) {
+        for (size_t i = 0; i < (size_t(1) << (64 - shift)); i++) {
+            buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~HashIndex() {
+        for (size_t i = 0; i < (size_t(1) << (64 - shift)); i++) {
+            Node* n = buckets[i].load(std::memory_order_relaxed);
+            while (n) {
+                Node* next = n->next;
+                delete n;
+                n = next;
+            }
+        }
+    }
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    Value* find(Key key) const {
+        Node* n = find_node(get_bucket(key).load(std::memory_order_acquire), key);
+        return n ? n->val.load(std::memory_order_acquire) : nullptr;
+    }
+
+    // Returns false if the key already has a value
+    bool insert(Key key, Value* val) {
+        std::atomic<Node*>& bucket = get_bucket(key);
+        Node* head = bucket.load(std::memory_order_acquire);
+        Node* new_node = nullptr;
+        while (true) {
+            if (Node* n = find_node(head, key)) {
+                delete new_node;
+                Value* expected = nullptr;
+                return n->val.compare_exchange_strong(
+                    expected, val, std::memory_order_acq_rel, std::memory_order_relaxed);
+            }
+            if (new_node == nullptr) new_node = new Node(key, val);
+            new_node->next = head;
+            if (bucket.compare_exchange_weak(
+                    head, new_node, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return true;
+            }
+        }
+    }
+
+    // Returns false if the key has no value
+    bool remove(Key key) {
+        Node* n = find_node(get_bucket(key).load(std::memory_order_acquire), key);
+        if (n == nullptr) return false;
+        Value* val = n->val.load(std::memory_order_acquire);
+        while (val != nullptr) {
+            if (n->val.compare_exchange_weak(
+                    val, nullptr, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void prefetch(Key key) const { __builtin_prefetch(&get_bucket(key)); }
+
+private:
+    struct Node {
+        Node(Key key, Value* val)
+            : key(key)
+            , val(val) {}
+        const Key key;
+        std::atomic<Value*> val;
+        Node* next = nullptr;  // set before the node is published, never changed after
+    };
+
+    const uint32_t shift;
+    const std::unique_ptr<std::atomic<Node*>[]> buckets;
+
+    static uint32_t get_bits(size_t expected_keys) {
+        uint32_t bits = 1;
+        while (bits < 62 && (size_t(1) << bits) < expected_keys) bits++;
+        return bits;
+    }
+
+    // Fibonacci hashing: the high bits of the product depend on all bits of the key, so packed
+    // keys that only differ in their high fields spread over the buckets as well
+    std::atomic<Node*>& get_bucket(Key key) const {
+        return buckets[(key * 0x9E3779B97F4A7C15ULL) >> shift];
+    }
+
+    static Node* find_node(Node* n, Key key) {
+        while (n && n->key != key) n = n->next;
+        return n;
+    }
+};
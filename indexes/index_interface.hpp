@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+
+#include "protocols/common/schema.hpp"
+
+/**
+ * Interface between the protocols and the index, which maps the keys of each table to values
+ * (the per-record metadata of the protocol). Protocols are templated on the Index class and
+ * use Index::get_index(), the singleton holding the indexes of all tables. is_index_v checks
+ * that a class provides:
+ *   types    Key (uint64_t), Value, LeafNode, NodeInfo, NodeMap, KVList, Result
+ *   lookups  find(table_id, key, val[, nm]), multi_find(table_id, n, keys, vals)
+ *   updates  insert(table_id, key, val[, ni | nm]), remove(table_id, key)
+ *   scans    get_kv_in_range(table_id, lkey, rkey, per_node_func, per_kv_func),
+ *            get_kv_in_range(table_id, lkey, rkey, count, kv_list[, nm]), the same for
+ *            get_kv_in_rev_range, and get_next_kv(table_id, key, next_key, next_val)
+ *   nodes    get_version_value(table_id, node), get_node_ts(table_id, node),
+ *            update_node_ts(table_id, node, ts)
+ *   tables   is_ordered(table_id): whether the table supports scans and get_next_kv
+ *
+ * Phantom protection (see docs/TPC-C.md) relies on the nodes of ordered indexes:
+ *   - Every key belongs to one leaf node at a time (an IndexNode*, only used as a handle and
+ *     passed back to the index). The version of the node changes whenever a key is inserted
+ *     into or removed from it, or keys are moved out of it.
+ *   - A scan calls per_node_func(node, version, continue_flag) for every node that covers a
+ *     part of the range (whether it holds keys in the range or not), with the version the keys
+ *     passed to per_kv_func(key, val, continue_flag) were read at.
+ *   - find with a NodeMap adds the node that would hold a missing key, and insert with a
+ *     NodeInfo reports the node the key was inserted into with its versions before and after
+ *     (old_version is never a version seen by a scan if the insert moved keys to other nodes).
+ *     The NodeMap variants of insert and of the list scans fail (BAD_INSERT, BAD_SCAN) if a
+ *     node already in the map has changed since its version was recorded.
+ *   - get_version_value returns the current version, so that a transaction detects inserts
+ *     into the ranges it scanned by comparing the versions it recorded (SILO).
+ *   - Nodes carry the largest timestamp of the scans that visited them (update_node_ts), which
+ *     an insert compares with its own timestamp (MVTO).
+ * Tables of unordered indexes have no nodes: NodeMaps are left as they are and NodeInfo::node
+ * is nullptr.
+ */
+
+// Node of an ordered index, only used as a handle
+struct IndexNode;
+
+struct IndexNodeInfo {
+    IndexNode* node = nullptr;
+    uint64_t old_version = 0;
+    uint64_t new_version = 0;
+};
+
+// Data structure storing a table (see MasstreeIndexes::use_backend())
+enum class IndexBackend {
+    MASSTREE,
+    BTREE,  // B+tree with optimistic lock coupling (indexes/btree_olc.hpp)
+    ART,    // adaptive radix tree with optimistic lock coupling (indexes/art_olc.hpp)
+    HASH,   // unordered (indexes/hash_index.hpp)
+};
+
+inline IndexBackend parse_index_backend(const std::string& name) {
+    if (name == "masstree") return IndexBackend::MASSTREE;
+    if (name == "btree") return IndexBackend::BTREE;
+    if (name == "art") return IndexBackend::ART;
+    if (name == "hash") return IndexBackend::HASH;
+    throw std::runtime_error("index must be masstree, btree, art or hash: " + name);
+}
+
+namespace index_interface {
+// Only for unevaluated operands
+template <typename T>
+T& ref();
+
+template <typename I>
+using K = typename I::Key;
+
+template <typename I>
+using V = typename I::Value*;
+
+template <typename I>
+using NM = typename I::NodeMap;
+
+template <typename I>
+using L = typename I::KVList;
+
+using NodeCallback = void (*)(IndexNode*, uint64_t, bool&);
+
+template <typename I>
+using KVCallback = void (*)(K<I>, V<I>, bool&);
+
+template <typename I, typename = void>
+struct HasMembers : std::false_type {};
+
+template <typename I>
+struct HasMembers<
+    I, std::void_t<
+           L<I>, decltype(I::Result::OK), decltype(I::Result::NOT_FOUND),
+           decltype(I::Result::BAD_INSERT), decltype(I::Result::NOT_INSERTED),
+           decltype(I::Result::NOT_DELETED), decltype(I::Result::BAD_SCAN)>>
+    : std::conjunction<
+          std::is_same<decltype(I::get_index()), I&>, std::is_same<K<I>, uint64_t>,
+          std::is_same<typename I::LeafNode, IndexNode>,
+          std::is_same<typename I::NodeInfo, IndexNodeInfo>,
+          std::is_same<NM<I>, std::unordered_map<IndexNode*, uint64_t>>> {};
+
+template <typename I, typename = void>
+struct HasOperations : std::false_type {};
+
+template <typename I>
+struct HasOperations<
+    I, std::void_t<
+           decltype(ref<I>().find(TableID(), K<I>(), ref<V<I>>())),
+           decltype(ref<I>().find(TableID(), K<I>(), ref<V<I>>(), ref<NM<I>>())),
+           decltype(ref<I>().multi_find(TableID(), size_t(), &ref<const K<I>>(), &ref<V<I>>())),
+           decltype(ref<I>().insert(TableID(), K<I>(), V<I>())),
+           decltype(ref<I>().insert(TableID(), K<I>(), V<I>(), ref<typename I::NodeInfo>())),
+           decltype(ref<I>().insert(TableID(), K<I>(), V<I>(), ref<NM<I>>())),
+           decltype(ref<I>().remove(TableID(), K<I>())),
+           decltype(ref<I>().get_next_kv(TableID(), K<I>(), ref<K<I>>(), ref<V<I>>())),
+           decltype(ref<I>().get_kv_in_range(
+               TableID(), K<I>(), K<I>(), NodeCallback(), KVCallback<I>())),
+           decltype(ref<I>().get_kv_in_rev_range(
+               TableID(), K<I>(), K<I>(), NodeCallback(), KVCallback<I>())),
+           decltype(ref<I>().get_kv_in_range(TableID(), K<I>(), K<I>(), int64_t(), ref<L<I>>())),
+           decltype(ref<I>().get_kv_in_range(
+               TableID(), K<I>(), K<I>(), int64_t(), ref<L<I>>(), ref<NM<I>>())),
+           decltype(ref<I>().get_kv_in_rev_range(
+               TableID(), K<I>(), K<I>(), int64_t(), ref<L<I>>())),
+           decltype(ref<I>().get_kv_in_rev_range(
+               TableID(), K<I>(), K<I>(), int64_t(), ref<L<I>>(), ref<NM<I>>())),
+           decltype(ref<I>().get_version_value(TableID(), ref<IndexNode*>())),
+           decltype(ref<I>().get_node_ts(TableID(), ref<IndexNode*>())),
+           decltype(ref<I>().update_node_ts(TableID(), ref<IndexNode*>(), uint64_t())),
+           decltype(ref<I>().is_ordered(TableID()))>> : std::true_type {};
+}  // namespace index_interface
+
+template <typename Index>
+inline constexpr bool is_index_v = std::conjunction_v<
+    index_interface::HasMembers<Index>, index_interface::HasOperations<Index>>;
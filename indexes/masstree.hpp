@@ -1,22 +1,42 @@
 #pragma once
 
-#include <map>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "indexes/art_olc.hpp"
+#include "indexes/btree_olc.hpp"
+#include "indexes/hash_index.hpp"
+#include "indexes/index_interface.hpp"
 #include "indexes/masstree_wrapper.hpp"
 #include "protocols/common/schema.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 #include "utils/utils.hpp"
 
+/**
+ * Index of each table, implementing the interface of indexes/index_interface.hpp. Tables are
+ * Masstrees unless another backend is chosen with use_backend(). Keys are 64-bit integers, stored
+ * big-endian in Masstree so that the byte order is the integer order. Keys of other lengths are
+ * supported by MasstreeStrIndex (indexes/masstree_str.hpp).
+ */
 template <typename Value_>
 class MasstreeIndexes {
 public:
     using Key = uint64_t;
     using Value = Value_;
     using MT = MasstreeWrapper<Value>;
-    using NodeInfo = typename MT::node_info_t;
-    using LeafNode = typename MT::leaf_type;
+    using NodeInfo = IndexNodeInfo;
+    using LeafNode = IndexNode;  // Masstree leaf, BTreeOLC leaf or ARTOLC inner node
     using NodeMap = std::unordered_map<LeafNode*, uint64_t>;  // key: node pointer,
                                                               // value: version
+    // Results of a range scan in scan order (descending keys for reverse scans). Reused across
+    // scans instead of a std::map, which would allocate a node per key.
+    using KVList = std::vector<std::pair<Key, Value*>>;
 
     enum Result {
         OK = 0,
@@ -27,97 +47,115 @@ public:
         BAD_SCAN,
     };
 
+    /**
+     * Keys of table_id are stored in the given backend instead of a Masstree. Must be called
+     * before the table is used; expected_keys sizes a HashIndex. BTREE and ART tables only take
+     * Keys. HASH tables only support find, multi_find, insert and remove of Keys, and they have
+     * no nodes: find leaves nm as it is, so a lookup that finds nothing is not protected from a
+     * concurrent insert of the key (a phantom). They thus reject the inserts of the concurrency
+     * control (insert with a NodeInfo or a NodeMap) and only take inserts while loading.
+     */
+    void use_backend(TableID table_id, IndexBackend backend, size_t expected_keys = 0) {
+        Table& t = tables[table_id];
+        t.backend = backend;
+        if (backend == IndexBackend::HASH) {
+            t.hash = std::make_unique<HashIndex<Value>>(expected_keys);
+        } else if (backend == IndexBackend::BTREE) {
+            t.btree = std::make_unique<BTreeOLC<Value>>();
+        } else if (backend == IndexBackend::ART) {
+            t.art = std::make_unique<ARTOLC<Value>>();
+        }
+    }
+
+    // Creates the index of table_id (a Masstree unless use_backend() chose another backend) if it
+    // does not exist yet. Tables are otherwise created on first use, which must not happen
+    // concurrently with any other access to the indexes, so tables that several threads load at
+    // the same time (see load_warehouses_on_owner_nodes()) have to be created beforehand.
+    void create_table(TableID table_id) { tables[table_id]; }
+
+    // Whether table_id supports scans and next-key locking
+    bool is_ordered(TableID table_id) {
+        return get_table(table_id).backend != IndexBackend::HASH;
+    }
+
     Result find(TableID table_id, Key key, Value*& val) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key key_buf = byte_swap(key);
-        val = mt.get_value(reinterpret_cast<char*>(&key_buf), sizeof(Key));
-        if (val == nullptr)
-            return NOT_FOUND;
-        else
-            return OK;
+        return visit(table_id, [&](auto& index) { return find_in(index, key, val); });
     }
 
     Result find(TableID table_id, Key key, Value*& val, NodeMap& nm) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key key_buf = byte_swap(key);
-        NodeInfo ni;
-        val = mt.get_value_and_get_nodeinfo_on_failure(
-            reinterpret_cast<char*>(&key_buf), sizeof(Key), ni);
-        if (val == nullptr) {
-            // node that would contain the missing key is added
-            nm.emplace(reinterpret_cast<LeafNode*>(ni.node), ni.new_version);
-            return NOT_FOUND;
-        } else {
-            return OK;
+        return visit(table_id, [&](auto& index) { return find_in(index, key, val, nm); });
+    }
+
+    /**
+     * Looks up keys[0..n) of a table; vals[i] is nullptr if keys[i] is not found, and each value
+     * found is prefetched. The lookups of a BTREE table are interleaved in groups: each visits
+     * one node in turn and prefetches its next one (BTreeOLC::Lookup), so that the misses of a
+     * group overlap. The buckets of a HASH table are all prefetched before the first lookup.
+     * MASSTREE and ART tables are looked up one key after another, as their descents cannot be
+     * interrupted, and only the misses on the values overlap with the next lookups.
+     */
+    Result multi_find(TableID table_id, size_t n, const Key* keys, Value** vals) {
+        Table& t = get_table(table_id);
+        if (t.backend == IndexBackend::HASH) {
+            for (size_t i = 0; i < n; i++) t.hash->prefetch(keys[i]);
+        }
+        return visit(table_id, [&](auto& index) { return find_all(index, n, keys, vals); });
+    }
+
+#if COROUTINES
+    /**
+     * Same as find() without a NodeMap, but the calling transaction suspends (co_await Yield(),
+     * see utils/coroutine.hpp) whenever the lookup has prefetched memory it needs next: the
+     * bucket of a HASH table, or each node of a BTREE descent. MASSTREE and ART tables are
+     * looked up as by find(), without suspending.
+     */
+    Task<Result> find_interleaved(TableID table_id, Key key, Value*& val) {
+        Table& t = get_table(table_id);
+        if (t.backend == IndexBackend::HASH) {
+            t.hash->prefetch(key);
+            co_await Yield();
+        } else if (t.backend == IndexBackend::BTREE) {
+            typename BTreeOLC<Value>::Lookup lookup(*t.btree, key);
+            while (lookup.step()) co_await Yield();
+            val = lookup.get_value();
+            co_return val ? OK : NOT_FOUND;
         }
+        co_return find(table_id, key, val);
     }
+#endif
 
     Result insert(TableID table_id, Key key, Value* val) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key key_buf = byte_swap(key);
-        bool inserted = mt.insert_value(reinterpret_cast<char*>(&key_buf), sizeof(Key), val);
-        return inserted ? OK : NOT_INSERTED;
+        return visit(table_id, [&](auto& index) { return insert_in(index, key, val); });
     }
 
     Result insert(TableID table_id, Key key, Value* val, NodeInfo& ni) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key key_buf = byte_swap(key);
-        bool inserted = mt.insert_value_and_get_nodeinfo_on_success(
-            reinterpret_cast<char*>(&key_buf), sizeof(Key), val, ni);
-        return inserted ? OK : NOT_INSERTED;
+        return visit(table_id, [&](auto& index) { return insert_in(index, key, val, ni); });
     }
 
     Result insert(TableID table_id, Key key, Value* val, NodeMap& nm) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key key_buf = byte_swap(key);
         NodeInfo ni;
-        bool inserted = mt.insert_value_and_get_nodeinfo_on_success(
-            reinterpret_cast<char*>(&key_buf), sizeof(Key), val, ni);
-        if (inserted) {
-            auto itr = nm.find(reinterpret_cast<LeafNode*>(ni.node));
-            if (itr == nm.end()) {
-                return OK;
-            }
-            if (itr->second != ni.old_version) {
-                return BAD_INSERT;
-            } else {
-                // update old node version if it exists
-                itr->second = ni.new_version;
-                return OK;
-            }
-        } else {
-            return NOT_INSERTED;
-        }
+        Result res = insert(table_id, key, val, ni);
+        return res == OK ? update_node_map(nm, ni) : res;
     }
 
     Result get_next_kv(TableID table_id, Key lkey, Key& next_key, Value*& next_value) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key lkey_buf = byte_swap(lkey);
         bool lexclusive = true;
-        Key rkey_buf = byte_swap(UINT64_MAX);
         bool rexclusive = false;
+        auto per_node_func = [](LeafNode* leaf, uint64_t version, bool& continue_flag) {
+            unused(leaf, version, continue_flag);
+        };
+        auto per_kv_func = [&next_key, &next_value](Key key, Value* val, bool& continue_flag) {
+            unused(continue_flag);
+            next_key = key;
+            next_value = val;
+            return;
+        };
 
-        mt.scan(
-            reinterpret_cast<char*>(&lkey_buf), sizeof(Key), lexclusive,
-            reinterpret_cast<char*>(&rkey_buf), sizeof(Key), rexclusive,
-            {[](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                 unused(leaf, version, continue_flag);
-             },
-             [&next_key, &next_value](
-                 const typename MT::Str& key, Value* val, bool& continue_flag) {
-                 unused(continue_flag);
-                 Key actual_key{__builtin_bswap64(*(reinterpret_cast<const uint64_t*>(key.s)))};
-                 next_key = actual_key;
-                 next_value = val;
-                 return;
-             }},
-            1);
+        visit(table_id, [&](auto& index) {
+            scan_in(
+                index, lkey, lexclusive, UINT64_MAX, rexclusive, false, per_node_func, per_kv_func,
+                1);
+        });
 
         return OK;
     }
@@ -125,139 +163,290 @@ public:
     template <typename NodeFunc, typename KVFunc>
     Result get_kv_in_range(
         TableID table_id, Key lkey, Key rkey, NodeFunc&& per_node_func, KVFunc&& per_kv_func) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key lkey_buf = byte_swap(lkey);
         bool lexclusive = false;
-        Key rkey_buf = byte_swap(rkey);
         bool rexclusive = true;
 
-        mt.scan(
-            reinterpret_cast<char*>(&lkey_buf), sizeof(Key), lexclusive,
-            reinterpret_cast<char*>(&rkey_buf), sizeof(Key), rexclusive,
-            {[&per_node_func](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                 per_node_func(leaf, version, continue_flag);
-             },
-             [&per_kv_func](const typename MT::Str& key, Value* val, bool& continue_flag) {
-                 Key actual_key{__builtin_bswap64(*(reinterpret_cast<const uint64_t*>(key.s)))};
-                 per_kv_func(actual_key, val, continue_flag);
-                 return;
-             }},
-            -1);
+        visit(table_id, [&](auto& index) {
+            scan_in(
+                index, lkey, lexclusive, rkey, rexclusive, false, per_node_func, per_kv_func, -1);
+        });
 
         return OK;
     }
 
     // [lkey --> rkey)
-    Result get_kv_in_range(
-        TableID table_id, Key lkey, Key rkey, int64_t count, std::map<Key, Value*>& kv_map) {
-        get_kv_in_range(
-            table_id, lkey, rkey,
-            [](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                unused(leaf, version, continue_flag);
-            },
-            [&kv_map, &count](Key key, Value* val, bool& continue_flag) {
-                kv_map.emplace(key, val);
-                if (count != -1 && static_cast<int64_t>(kv_map.size()) >= count)
-                    continue_flag = false;
-            });
-        return OK;
+    Result get_kv_in_range(TableID table_id, Key lkey, Key rkey, int64_t count, KVList& kv_list) {
+        return scan_into_list(table_id, lkey, rkey, false, count, kv_list, nullptr);
     }
 
     Result get_kv_in_range(
-        TableID table_id, Key lkey, Key rkey, int64_t count, std::map<Key, Value*>& kv_map,
-        NodeMap& nm) {
-        bool exception_caught = false;
-        get_kv_in_range(
-            table_id, lkey, rkey,
-            [&nm, &exception_caught](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                auto it = nm.find(leaf);
-                if (it == nm.end())
-                    nm.emplace_hint(it, leaf, version);
-                else if (it->second != version) {
-                    exception_caught = true;
-                    continue_flag = false;
-                }
-            },
-            [&kv_map, &count](Key key, Value* val, bool& continue_flag) {
-                kv_map.emplace(key, val);
-                if (count != -1 && static_cast<int64_t>(kv_map.size()) >= count)
-                    continue_flag = false;
-            });
-
-        return exception_caught ? BAD_SCAN : OK;
+        TableID table_id, Key lkey, Key rkey, int64_t count, KVList& kv_list, NodeMap& nm) {
+        return scan_into_list(table_id, lkey, rkey, false, count, kv_list, &nm);
     }
 
     template <typename NodeFunc, typename KVFunc>
     Result get_kv_in_rev_range(
         TableID table_id, Key lkey, Key rkey, NodeFunc&& per_node_func, KVFunc&& per_kv_func) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        Key lkey_buf = byte_swap(lkey);
         bool lexclusive = true;
-        Key rkey_buf = byte_swap(rkey);
         bool rexclusive = false;
 
-        mt.rscan(
-            reinterpret_cast<char*>(&lkey_buf), sizeof(Key), lexclusive,
-            reinterpret_cast<char*>(&rkey_buf), sizeof(Key), rexclusive,
-            {[&per_node_func](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                 per_node_func(leaf, version, continue_flag);
-             },
-             [&per_kv_func](const typename MT::Str& key, Value* val, bool& continue_flag) {
-                 Key actual_key{__builtin_bswap64(*(reinterpret_cast<const uint64_t*>(key.s)))};
-                 per_kv_func(actual_key, val, continue_flag);
-                 return;
-             }},
-            -1);
+        visit(table_id, [&](auto& index) {
+            scan_in(
+                index, lkey, lexclusive, rkey, rexclusive, true, per_node_func, per_kv_func, -1);
+        });
 
         return OK;
     }
 
     // (lkey <-- rkey]
     Result get_kv_in_rev_range(
-        TableID table_id, Key lkey, Key rkey, int64_t count, std::map<Key, Value*>& kv_map) {
-        get_kv_in_rev_range(
-            table_id, lkey, rkey,
-            [](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                unused(leaf, version, continue_flag);
-            },
-            [&kv_map, &count](Key key, Value* val, bool& continue_flag) {
-                kv_map.emplace(key, val);
-                if (count != -1 && static_cast<int64_t>(kv_map.size()) >= count)
-                    continue_flag = false;
-            });
-        return OK;
+        TableID table_id, Key lkey, Key rkey, int64_t count, KVList& kv_list) {
+        return scan_into_list(table_id, lkey, rkey, true, count, kv_list, nullptr);
     }
 
     // (lkey <-- rkey] with NodeInfo
     Result get_kv_in_rev_range(
-        TableID table_id, Key lkey, Key rkey, int64_t count, std::map<Key, Value*>& kv_map,
-        NodeMap& nm) {
-        bool exception_caught = false;
-        get_kv_in_rev_range(
-            table_id, lkey, rkey,
-            [&nm, &exception_caught](LeafNode* leaf, uint64_t version, bool& continue_flag) {
-                auto it = nm.find(leaf);
-                if (it == nm.end())
-                    nm.emplace_hint(it, leaf, version);
-                else if (it->second != version) {
-                    exception_caught = true;
-                    continue_flag = false;
+        TableID table_id, Key lkey, Key rkey, int64_t count, KVList& kv_list, NodeMap& nm) {
+        return scan_into_list(table_id, lkey, rkey, true, count, kv_list, &nm);
+    }
+
+    Result remove(TableID table_id, Key key) {
+        return visit(table_id, [&](auto& index) { return remove_in(index, key); });
+    }
+
+    uint64_t get_version_value(TableID table_id, LeafNode* node) {
+        Table& t = get_table(table_id);
+        switch (t.backend) {
+        case IndexBackend::BTREE: return t.btree->get_version_value(node);
+        case IndexBackend::ART: return t.art->get_version_value(node);
+        case IndexBackend::HASH: throw std::runtime_error("hash index tables have no nodes");
+        default: return t.mt.get_version_value(as_leaf(node));
+        }
+    }
+
+    // Timestamp of a node for MVTO (see update_node_ts() of indexes/optimistic_lock.hpp). Only
+    // the leaves of the MVTO branch of Masstree have one, so Masstree tables need it.
+    uint64_t get_node_ts(TableID table_id, LeafNode* node) {
+        Table& t = get_table(table_id);
+        switch (t.backend) {
+        case IndexBackend::BTREE: return t.btree->get_ts(node);
+        case IndexBackend::ART: return t.art->get_ts(node);
+        case IndexBackend::HASH: throw std::runtime_error("hash index tables have no nodes");
+        default: return as_leaf(node)->get_ts();
+        }
+    }
+
+    void update_node_ts(TableID table_id, LeafNode* node, uint64_t ts) {
+        Table& t = get_table(table_id);
+        switch (t.backend) {
+        case IndexBackend::BTREE: t.btree->update_ts(node, ts); break;
+        case IndexBackend::ART: t.art->update_ts(node, ts); break;
+        case IndexBackend::HASH: throw std::runtime_error("hash index tables have no nodes");
+        default: as_leaf(node)->update_ts(ts); break;
+        }
+    }
+
+    // Other
+    static MasstreeIndexes<Value>& get_index() {
+        static MasstreeIndexes<Value> idx;
+        return idx;
+    }
+
+private:
+    struct Table {
+        IndexBackend backend = IndexBackend::MASSTREE;
+        MT mt;
+        // the one of backend is set if it is not MASSTREE
+        std::unique_ptr<HashIndex<Value>> hash;
+        std::unique_ptr<BTreeOLC<Value>> btree;
+        std::unique_ptr<ARTOLC<Value>> art;
+    };
+    // Tables are added by use_backend(), create_table() or their first use, all from one thread
+    // at a time (see create_table()). Threads loading or running transactions concurrently only
+    // look them up with find(), which does not modify the map.
+    std::unordered_map<TableID, Table> tables;
+
+    Table& get_table(TableID table_id) {
+        auto it = tables.find(table_id);
+        return it != tables.end() ? it->second : tables[table_id];
+    }
+
+    // Calls f with the index of the table. The *_in overloads below implement each operation
+    // for each backend: MT, HashIndex and the ordered OLC indexes (templates).
+    template <typename F>
+    decltype(auto) visit(TableID table_id, F&& f) {
+        Table& t = get_table(table_id);
+        switch (t.backend) {
+        case IndexBackend::HASH: return f(*t.hash);
+        case IndexBackend::BTREE: return f(*t.btree);
+        case IndexBackend::ART: return f(*t.art);
+        default: t.mt.thread_init(0); return f(t.mt);
+        }
+    }
+
+    static IndexNode* as_node(typename MT::leaf_type* leaf) {
+        return reinterpret_cast<IndexNode*>(leaf);
+    }
+
+    static typename MT::leaf_type* as_leaf(IndexNode* node) {
+        return reinterpret_cast<typename MT::leaf_type*>(node);
+    }
+
+    // per_node_func of Masstree scans, which pass their leaves
+    template <typename NodeFunc>
+    static auto leaf_func(NodeFunc& per_node_func) {
+        return [&per_node_func](
+                   typename MT::leaf_type* leaf, uint64_t version, bool& continue_flag) {
+            per_node_func(as_node(leaf), version, continue_flag);
+        };
+    }
+
+    Result find_in(MT& mt, Key key, Value*& val) {
+        Key key_buf = byte_swap(key);
+        val = mt.get_value(reinterpret_cast<char*>(&key_buf), sizeof(Key));
+        if (val == nullptr)
+            return NOT_FOUND;
+        else
+            return OK;
+    }
+
+    Result find_in(HashIndex<Value>& hash, Key key, Value*& val) {
+        val = hash.find(key);
+        return val ? OK : NOT_FOUND;
+    }
+
+    template <typename Ordered>
+    Result find_in(Ordered& index, Key key, Value*& val) {
+        val = index.find(key, nullptr);
+        return val ? OK : NOT_FOUND;
+    }
+
+    Result find_in(MT& mt, Key key, Value*& val, NodeMap& nm) {
+        Key key_buf = byte_swap(key);
+        typename MT::node_info_t ni;
+        val = mt.get_value_and_get_nodeinfo_on_failure(
+            reinterpret_cast<char*>(&key_buf), sizeof(Key), ni);
+        if (val == nullptr) {
+            // node that would contain the missing key is added
+            nm.emplace(reinterpret_cast<LeafNode*>(ni.node), ni.new_version);
+            return NOT_FOUND;
+        } else {
+            return OK;
+        }
+    }
+
+    Result find_in(HashIndex<Value>& hash, Key key, Value*& val, NodeMap&) {
+        return find_in(hash, key, val);
+    }
+
+    template <typename Ordered>
+    Result find_in(Ordered& index, Key key, Value*& val, NodeMap& nm) {
+        NodeInfo ni;
+        val = index.find(key, &ni);
+        if (val == nullptr) {
+            nm.emplace(ni.node, ni.new_version);
+            return NOT_FOUND;
+        } else {
+            return OK;
+        }
+    }
+
+    template <typename Index>
+    Result find_all(Index& index, size_t n, const Key* keys, Value** vals) {
+        Result res = OK;
+        for (size_t i = 0; i < n; i++) {
+            if (find_in(index, keys[i], vals[i]) != OK) {
+                res = NOT_FOUND;
+            } else {
+                __builtin_prefetch(vals[i]);
+            }
+        }
+        return res;
+    }
+
+    Result find_all(BTreeOLC<Value>& index, size_t n, const Key* keys, Value** vals) {
+        constexpr size_t GROUP_SIZE = 8;
+        typename BTreeOLC<Value>::Lookup lookups[GROUP_SIZE];
+        bool done[GROUP_SIZE];
+        Result res = OK;
+        for (size_t first = 0; first < n; first += GROUP_SIZE) {
+            size_t group_size = std::min(GROUP_SIZE, n - first);
+            for (size_t i = 0; i < group_size; i++) {
+                lookups[i] = typename BTreeOLC<Value>::Lookup(index, keys[first + i]);
+                done[i] = false;
+            }
+            size_t pending = group_size;
+            while (pending > 0) {
+                for (size_t i = 0; i < group_size; i++) {
+                    if (done[i] || lookups[i].step()) continue;
+                    done[i] = true;
+                    pending--;
+                }
+            }
+            for (size_t i = 0; i < group_size; i++) {
+                Value* val = lookups[i].get_value();
+                vals[first + i] = val;
+                if (val == nullptr) {
+                    res = NOT_FOUND;
+                } else {
+                    __builtin_prefetch(val);
                 }
-            },
-            [&kv_map, &count](Key key, Value* val, bool& continue_flag) {
-                kv_map.emplace(key, val);
-                if (count != -1 && static_cast<int64_t>(kv_map.size()) >= count)
-                    continue_flag = false;
-            });
+            }
+        }
+        return res;
+    }
 
-        return exception_caught ? BAD_SCAN : OK;
+    Result insert_in(MT& mt, Key key, Value* val) {
+        Key key_buf = byte_swap(key);
+        bool inserted = mt.insert_value(reinterpret_cast<char*>(&key_buf), sizeof(Key), val);
+        return inserted ? OK : NOT_INSERTED;
     }
 
-    Result remove(TableID table_id, Key key) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
+    Result insert_in(HashIndex<Value>& hash, Key key, Value* val) {
+        return hash.insert(key, val) ? OK : NOT_INSERTED;
+    }
+
+    template <typename Ordered>
+    Result insert_in(Ordered& index, Key key, Value* val) {
+        return index.insert(key, val, nullptr) ? OK : NOT_INSERTED;
+    }
+
+    Result insert_in(MT& mt, Key key, Value* val, NodeInfo& ni) {
+        Key key_buf = byte_swap(key);
+        typename MT::node_info_t mt_ni;
+        bool inserted = mt.insert_value_and_get_nodeinfo_on_success(
+            reinterpret_cast<char*>(&key_buf), sizeof(Key), val, mt_ni);
+        ni = NodeInfo{
+            reinterpret_cast<LeafNode*>(mt_ni.node), mt_ni.old_version, mt_ni.new_version};
+        return inserted ? OK : NOT_INSERTED;
+    }
+
+    Result insert_in(HashIndex<Value>&, Key, Value*, NodeInfo&) {
+        throw std::runtime_error("hash index tables do not take inserts under concurrency control");
+    }
+
+    template <typename Ordered>
+    Result insert_in(Ordered& index, Key key, Value* val, NodeInfo& ni) {
+        return index.insert(key, val, &ni) ? OK : NOT_INSERTED;
+    }
+
+    // After an insert reported by ni, the version of its node in nm (if any) is updated, unless
+    // the node has changed since nm recorded it
+    Result update_node_map(NodeMap& nm, const NodeInfo& ni) {
+        auto itr = nm.find(ni.node);
+        if (itr == nm.end()) {
+            return OK;
+        }
+        if (itr->second != ni.old_version) {
+            return BAD_INSERT;
+        } else {
+            // update old node version if it exists
+            itr->second = ni.new_version;
+            return OK;
+        }
+    }
+
+    Result remove_in(MT& mt, Key key) {
         Key key_buf = byte_swap(key);
         if (mt.remove_value(reinterpret_cast<char*>(&key_buf), sizeof(Key))) {
             return OK;
@@ -266,23 +455,90 @@ public:
         }
     }
 
-    uint64_t get_version_value(TableID table_id, LeafNode* node) {
-        auto& mt = indexes[table_id];
-        mt.thread_init(0);
-        return mt.get_version_value(node);
+    Result remove_in(HashIndex<Value>& hash, Key key) {
+        return hash.remove(key) ? OK : NOT_DELETED;
     }
 
-    // Other
-    static MasstreeIndexes<Value>& get_index() {
-        static MasstreeIndexes<Value> idx;
-        return idx;
+    template <typename Ordered>
+    Result remove_in(Ordered& index, Key key) {
+        return index.remove(key) ? OK : NOT_DELETED;
     }
 
-private:
-    std::unordered_map<TableID, MT> indexes;
+    template <typename NodeFunc, typename KVFunc>
+    void scan_in(
+        MT& mt, Key lkey, bool lexclusive, Key rkey, bool rexclusive, bool reverse,
+        NodeFunc& per_node_func, KVFunc& per_kv_func, int64_t max_scan_num) {
+        Key lkey_buf = byte_swap(lkey);
+        Key rkey_buf = byte_swap(rkey);
+        auto per_str_kv_func = [&per_kv_func](
+                                   const typename MT::Str& key, Value* val, bool& continue_flag) {
+            per_kv_func(to_int(key.s), val, continue_flag);
+        };
+        if (reverse) {
+            mt.rscan(
+                reinterpret_cast<char*>(&lkey_buf), sizeof(Key), lexclusive,
+                reinterpret_cast<char*>(&rkey_buf), sizeof(Key), rexclusive,
+                leaf_func(per_node_func), per_str_kv_func, max_scan_num);
+        } else {
+            mt.scan(
+                reinterpret_cast<char*>(&lkey_buf), sizeof(Key), lexclusive,
+                reinterpret_cast<char*>(&rkey_buf), sizeof(Key), rexclusive,
+                leaf_func(per_node_func), per_str_kv_func, max_scan_num);
+        }
+    }
+
+    template <typename NodeFunc, typename KVFunc>
+    void scan_in(HashIndex<Value>&, Key, bool, Key, bool, bool, NodeFunc&, KVFunc&, int64_t) {
+        throw std::runtime_error("hash index tables cannot be scanned");
+    }
 
-    Key byte_swap(Key key) {
+    template <typename Ordered, typename NodeFunc, typename KVFunc>
+    void scan_in(
+        Ordered& index, Key lkey, bool lexclusive, Key rkey, bool rexclusive, bool reverse,
+        NodeFunc& per_node_func, KVFunc& per_kv_func, int64_t max_scan_num) {
+        index.scan(
+            lkey, lexclusive, rkey, rexclusive, reverse, per_node_func, per_kv_func, max_scan_num);
+    }
+
+    static Key byte_swap(Key key) {
         Key key_buf{__builtin_bswap64(key)};
         return key_buf;
     }
+
+    static Key to_int(const char* s) {
+        Key key_buf;
+        memcpy(&key_buf, s, sizeof(Key));
+        return __builtin_bswap64(key_buf);
+    }
+
+    // Collects up to count (-1: all) keys of a range. With nm, the leaves visited are added to
+    // nm, and the scan fails if a leaf already in nm has changed since.
+    Result scan_into_list(
+        TableID table_id, Key lkey, Key rkey, bool reverse, int64_t count, KVList& kv_list,
+        NodeMap* nm) {
+        kv_list.clear();
+        bool exception_caught = false;
+        auto per_node_func = [nm, &exception_caught](
+                                 LeafNode* leaf, uint64_t version, bool& continue_flag) {
+            if (nm == nullptr) return;
+            auto it = nm->find(leaf);
+            if (it == nm->end())
+                nm->emplace_hint(it, leaf, version);
+            else if (it->second != version) {
+                exception_caught = true;
+                continue_flag = false;
+            }
+        };
+        auto per_kv_func = [&kv_list, &count](Key key, Value* val, bool& continue_flag) {
+            kv_list.emplace_back(key, val);
+            if (count != -1 && static_cast<int64_t>(kv_list.size()) >= count)
+                continue_flag = false;
+        };
+        if (reverse) {
+            get_kv_in_rev_range(table_id, lkey, rkey, per_node_func, per_kv_func);
+        } else {
+            get_kv_in_range(table_id, lkey, rkey, per_node_func, per_kv_func);
+        }
+        return exception_caught ? BAD_SCAN : OK;
+    }
 };
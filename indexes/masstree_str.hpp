@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "indexes/masstree_wrapper.hpp"
+
+/**
+ * Masstree keyed by byte strings (StrKey) ordered by memcmp, e.g. composite keys (see
+ * indexes/composite_key.hpp). Keys are handed to Masstree as they are, without copying, and may
+ * be of any length: keys longer than 8 bytes go into the deeper layers of the trie, so their
+ * fields do not have to be bit-packed into 64 bits. Keys passed to scan callbacks are only valid
+ * until the callback returns.
+ *
+ * The tables of the protocols stay in MasstreeIndexes, whose keys are 64-bit integers like the
+ * keys of their read and write sets; micro_scan compares the two.
+ */
+template <typename Value_>
+class MasstreeStrIndex {
+public:
+    using StrKey = std::string_view;
+    using Value = Value_;
+    using MT = MasstreeWrapper<Value>;
+
+    // Results of a range scan in scan order, reused across scans. The keys are copied into one
+    // buffer, which keeps its capacity like the list itself.
+    class StrKVList {
+    public:
+        void clear() {
+            keys.clear();
+            entries.clear();
+        }
+
+        size_t size() const { return entries.size(); }
+
+        bool empty() const { return entries.empty(); }
+
+        void emplace_back(StrKey key, Value* val) {
+            entries.push_back({keys.size(), key.size(), val});
+            keys.append(key.data(), key.size());
+        }
+
+        std::pair<StrKey, Value*> operator[](size_t i) const {
+            const Entry& e = entries[i];
+            return {StrKey(keys.data() + e.offset, e.len), e.val};
+        }
+
+    private:
+        struct Entry {
+            size_t offset;
+            size_t len;
+            Value* val;
+        };
+        std::string keys;
+        std::vector<Entry> entries;
+    };
+
+    Value* find(StrKey key) {
+        mt.thread_init(0);
+        return mt.get_value(key.data(), key.size());
+    }
+
+    bool insert(StrKey key, Value* val) {
+        mt.thread_init(0);
+        return mt.insert_value(key.data(), key.size(), val);
+    }
+
+    bool remove(StrKey key) {
+        mt.thread_init(0);
+        return mt.remove_value(key.data(), key.size());
+    }
+
+    // [lkey --> rkey), to the end of the index if rkey.data() is nullptr (StrKey()).
+    // per_kv_func(StrKey key, Value* val, bool& continue_flag) is called for each key in range.
+    template <typename KVFunc>
+    void scan(StrKey lkey, StrKey rkey, KVFunc&& per_kv_func) {
+        mt.thread_init(0);
+        mt.scan(
+            lkey.data(), lkey.size(), false, rkey.data(), rkey.size(), true, no_node,
+            [&per_kv_func](const typename MT::Str& key, Value* val, bool& continue_flag) {
+                per_kv_func(StrKey(key.s, key.len), val, continue_flag);
+            });
+    }
+
+    // (lkey <-- rkey]
+    template <typename KVFunc>
+    void rscan(StrKey lkey, StrKey rkey, KVFunc&& per_kv_func) {
+        mt.thread_init(0);
+        mt.rscan(
+            lkey.data(), lkey.size(), true, rkey.data(), rkey.size(), false, no_node,
+            [&per_kv_func](const typename MT::Str& key, Value* val, bool& continue_flag) {
+                per_kv_func(StrKey(key.s, key.len), val, continue_flag);
+            });
+    }
+
+    // Up to count (-1: all) keys of [lkey --> rkey), or of (lkey <-- rkey] if reverse
+    void scan(StrKey lkey, StrKey rkey, bool reverse, int64_t count, StrKVList& kv_list) {
+        kv_list.clear();
+        auto per_kv_func = [&kv_list, count](StrKey key, Value* val, bool& continue_flag) {
+            kv_list.emplace_back(key, val);
+            if (count != -1 && static_cast<int64_t>(kv_list.size()) >= count)
+                continue_flag = false;
+        };
+        if (reverse) {
+            rscan(lkey, rkey, per_kv_func);
+        } else {
+            scan(lkey, rkey, per_kv_func);
+        }
+    }
+
+private:
+    MT mt;
+
+    static void no_node(typename MT::leaf_type*, uint64_t, bool&) {}
+};
@@ -13,6 +13,11 @@
 #include "masstree/masstree_tcursor.hh"
 #include "masstree/string.hh"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
 class key_unparse_unsigned {
 public:
     static int unparse_key(Masstree::key<uint64_t> key, char* buf, int buflen) {
@@ -177,26 +182,74 @@ public:
         return 0;           // not removed
     }
 
-    class Callback {
+    // End key of a scan. 8-byte keys (all keys of MasstreeIndexes) are compared as big-endian
+    // integers, other keys with memcmp.
+    class EndKey {
     public:
-        std::function<void(leaf_type*, uint64_t, bool&)> per_node_func;
-        std::function<void(const Str&, T*, bool&)> per_kv_func;
+        EndKey(const char* const key, const std::size_t len, const bool exclusive)
+            : key_(key)
+            , len_(len)
+            , exclusive_(exclusive)
+            , is_int_(key != nullptr && len == sizeof(uint64_t))
+            , int_key_(is_int_ ? load_int(key) : 0) {}
+
+        // key < end key (or equal if inclusive); always true without end key
+        bool is_before(const Str& key) const {
+            if (key_ == nullptr) return true;
+            int res = compare(key);
+            return res < 0 || (res == 0 && !exclusive_);
+        }
+
+        // key > end key (or equal if inclusive); always true without end key
+        bool is_after(const Str& key) const {
+            if (key_ == nullptr) return true;
+            int res = compare(key);
+            return res > 0 || (res == 0 && !exclusive_);
+        }
+
+    private:
+        const char* const key_;
+        const std::size_t len_;
+        const bool exclusive_;
+        const bool is_int_;
+        const uint64_t int_key_;
+
+        static uint64_t load_int(const char* s) {
+            uint64_t v;
+            memcpy(&v, s, sizeof(uint64_t));
+            return __builtin_bswap64(v);
+        }
+
+        int compare(const Str& key) const {
+            std::size_t len = static_cast<std::size_t>(key.len);
+            if (is_int_ && len == sizeof(uint64_t)) {
+                uint64_t k = load_int(key.s);
+                return k < int_key_ ? -1 : (k > int_key_ ? 1 : 0);
+            }
+            int res = memcmp(key.s, key_, std::min(len_, len));
+            if (res != 0) return res;
+            return len < len_ ? -1 : (len > len_ ? 1 : 0);
+        }
     };
+
+    // The callbacks are template parameters, so that they are inlined into the scan loop.
+    // per_node_func(leaf_type*, uint64_t version, bool& continue_flag) is called for every leaf
+    // visited and per_kv_func(const Str& key, T* val, bool& continue_flag) for every key in range.
+    template <typename NodeFunc, typename KVFunc>
     class SearchRangeScanner {
     public:
         SearchRangeScanner(
             const char* const rkey, const std::size_t len_rkey, const bool r_exclusive,
-            Callback& callback, int64_t max_scan_num = -1)
-            : rkey_(rkey)
-            , len_rkey_(len_rkey)
-            , r_exclusive_(r_exclusive)
-            , callback_(callback)
+            NodeFunc& per_node_func, KVFunc& per_kv_func, int64_t max_scan_num = -1)
+            : end_key_(rkey, len_rkey, r_exclusive)
+            , per_node_func_(per_node_func)
+            , per_kv_func_(per_kv_func)
             , max_scan_num_(max_scan_num) {}
 
         template <typename ScanStackElt, typename Key>
         void visit_leaf(const ScanStackElt& iter, const Key& key, threadinfo&) {
             (void)key;
-            callback_.per_node_func(iter.node(), iter.full_version_value(), continue_flag);
+            per_node_func_(iter.node(), iter.full_version_value(), continue_flag);
         }
 
         bool visit_value(const Str key, T* val, threadinfo&) {
@@ -204,70 +257,48 @@ public:
                 return false;
             }
             ++scan_num_cnt_;
-
-            bool endless_key = (rkey_ == nullptr);
-
-            if (endless_key) {
-                callback_.per_kv_func(key, val, continue_flag);
-                return true;
-            }
-
-            // compare key with end key
-            const int res =
-                memcmp(rkey_, key.s, std::min(len_rkey_, static_cast<std::size_t>(key.len)));
-
-            bool smaller_than_end_key = (res > 0);
-            bool same_as_end_key_but_shorter =
-                ((res == 0) && (len_rkey_ > static_cast<std::size_t>(key.len)));
-            bool same_as_end_key_inclusive =
-                ((res == 0) && (len_rkey_ == static_cast<std::size_t>(key.len)) && (!r_exclusive_));
-
-            if (smaller_than_end_key || same_as_end_key_but_shorter || same_as_end_key_inclusive) {
-                callback_.per_kv_func(key, val, continue_flag);
-                return true;
-            }
-
-            return false;
+            if (!end_key_.is_before(key)) return false;
+            per_kv_func_(key, val, continue_flag);
+            return true;
         }
 
     private:
-        const char* const rkey_{};
-        const std::size_t len_rkey_{};
-        const bool r_exclusive_{};
-        std::vector<const T*> scan_buffer_{};
-        Callback& callback_;
-        const bool limited_scan_{false};
+        const EndKey end_key_;
+        NodeFunc& per_node_func_;
+        KVFunc& per_kv_func_;
         int64_t scan_num_cnt_ = 0;
         int64_t max_scan_num_ = -1;
 
         bool continue_flag = true;
     };
 
+    template <typename NodeFunc, typename KVFunc>
     void scan(
         const char* const lkey, const std::size_t len_lkey, const bool l_exclusive,
         const char* const rkey, const std::size_t len_rkey, const bool r_exclusive,
-        Callback&& callback, int64_t max_scan_num = -1) {
+        NodeFunc&& per_node_func, KVFunc&& per_kv_func, int64_t max_scan_num = -1) {
         Str mtkey = (lkey == nullptr ? Str() : Str(lkey, len_lkey));
 
-        SearchRangeScanner scanner(rkey, len_rkey, r_exclusive, callback, max_scan_num);
+        SearchRangeScanner<std::remove_reference_t<NodeFunc>, std::remove_reference_t<KVFunc>>
+            scanner(rkey, len_rkey, r_exclusive, per_node_func, per_kv_func, max_scan_num);
         table_.scan(mtkey, !l_exclusive, scanner, *ti);
     }
 
+    template <typename NodeFunc, typename KVFunc>
     class BackwordScanner {
     public:
         BackwordScanner(
             const char* const lkey, const std::size_t len_lkey, const bool l_exclusive,
-            Callback& callback, int64_t max_scan_num = -1)
-            : lkey_(lkey)
-            , len_lkey_(len_lkey)
-            , l_exclusive_(l_exclusive)
-            , callback_(callback)
+            NodeFunc& per_node_func, KVFunc& per_kv_func, int64_t max_scan_num = -1)
+            : end_key_(lkey, len_lkey, l_exclusive)
+            , per_node_func_(per_node_func)
+            , per_kv_func_(per_kv_func)
             , max_scan_num_(max_scan_num) {}
 
         template <typename ScanStackElt, typename Key>
         void visit_leaf(const ScanStackElt& iter, const Key& key, threadinfo&) {
             (void)key;
-            callback_.per_node_func(iter.node(), iter.full_version_value(), continue_flag);
+            per_node_func_(iter.node(), iter.full_version_value(), continue_flag);
         }
 
         bool visit_value(const Str key, T* val, threadinfo&) {
@@ -275,51 +306,30 @@ public:
                 return false;
             }
             ++scan_num_cnt_;
-
-            bool endless_key = (lkey_ == nullptr);
-
-            if (endless_key) {
-                callback_.per_kv_func(key, val, continue_flag);
-                return true;
-            }
-
-            // compare key with end key
-            const int res =
-                memcmp(lkey_, key.s, std::min(len_lkey_, static_cast<std::size_t>(key.len)));
-
-            bool bigger_than_end_key = (res < 0);
-            bool same_as_end_key_but_longer =
-                ((res == 0) && (len_lkey_ < static_cast<std::size_t>(key.len)));
-            bool same_as_end_key_inclusive =
-                ((res == 0) && (len_lkey_ == static_cast<std::size_t>(key.len)) && (!l_exclusive_));
-
-            if (bigger_than_end_key || same_as_end_key_but_longer || same_as_end_key_inclusive) {
-                callback_.per_kv_func(key, val, continue_flag);
-                return true;
-            }
-
-            return false;
+            if (!end_key_.is_after(key)) return false;
+            per_kv_func_(key, val, continue_flag);
+            return true;
         }
 
     private:
-        const char* const lkey_{};
-        const std::size_t len_lkey_{};
-        const bool l_exclusive_{};
-        std::vector<const T*> scan_buffer_{};
-        Callback& callback_;
+        const EndKey end_key_;
+        NodeFunc& per_node_func_;
+        KVFunc& per_kv_func_;
         int64_t scan_num_cnt_ = 0;
         int64_t max_scan_num_ = -1;
 
         bool continue_flag = true;
     };
 
+    template <typename NodeFunc, typename KVFunc>
     void rscan(
         const char* const lkey, const std::size_t len_lkey, const bool l_exclusive,
         const char* const rkey, const std::size_t len_rkey, const bool r_exclusive,
-        Callback&& callback, int64_t max_scan_num = -1) {
+        NodeFunc&& per_node_func, KVFunc&& per_kv_func, int64_t max_scan_num = -1) {
         Str mtkey = (lkey == nullptr ? Str() : Str(rkey, len_rkey));
 
-        BackwordScanner scanner(lkey, len_lkey, l_exclusive, callback, max_scan_num);
+        BackwordScanner<std::remove_reference_t<NodeFunc>, std::remove_reference_t<KVFunc>>
+            scanner(lkey, len_lkey, l_exclusive, per_node_func, per_kv_func, max_scan_num);
         table_.rscan(mtkey, !r_exclusive, scanner, *ti);
     }
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "utils/atomic_wrapper.hpp"
+
+/**
+ * Version lock of optimistic lock coupling (Leis et al., "Optimistic Lock Coupling: A Scalable
+ * and Efficient General-Purpose Synchronization Method", IEEE Data Eng. Bull. 2019).
+ * Readers do not write to the node: they read the version, read the node and validate that the
+ * version is unchanged, restarting otherwise. Writers upgrade a version they read to a lock, so
+ * every modification of a node changes its version. The version is
+ *   bits 63..2: counter, incremented by each unlock
+ *   bit 1:      locked
+ *   bit 0:      obsolete (the node was replaced and must not be used any more)
+ * Fields that readers access concurrently with a writer are read and written with load() and
+ * store() of utils/atomic_wrapper.hpp. Readers must not act on what they read before it is
+ * validated.
+ */
+class OptimisticLock {
+public:
+    // Reads the version, waiting while the node is locked. Returns false if the node is obsolete.
+    bool read_lock(uint64_t& version) const {
+        while (true) {
+            version = load_acquire(word);
+            if (version & OBSOLETE) return false;
+            if (!(version & LOCKED)) return true;
+        }
+    }
+
+    // Whether the node is unchanged since version was read (by read_lock())
+    bool validate(uint64_t version) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return load(word) == version;
+    }
+
+    // Locks the node if it is unchanged since version was read
+    bool upgrade(uint64_t version) { return compare_exchange(word, version, version + LOCKED); }
+
+    // Returns the new version
+    uint64_t unlock() { return fetch_add(word, LOCKED, __ATOMIC_RELEASE) + LOCKED; }
+
+    void unlock_obsolete() { fetch_add(word, LOCKED + OBSOLETE, __ATOMIC_RELEASE); }
+
+    // Current version, locked or obsolete versions included (for node verification)
+    uint64_t get_version() const { return load_acquire(word); }
+
+    // Version that a node never has when it is not locked, so it differs from any version
+    // returned by read_lock() or unlock()
+    static uint64_t locked_version(uint64_t version) { return version | LOCKED; }
+
+private:
+    static constexpr uint64_t OBSOLETE = 1;
+    static constexpr uint64_t LOCKED = 2;
+    mutable uint64_t word = 0;
+};
+
+// Node timestamp of MVTO: the largest timestamp of the range scans that visited the node
+inline void update_node_ts(uint64_t& node_ts, uint64_t ts) {
+    uint64_t current = load_acquire(node_ts);
+    while (current < ts && !compare_exchange(node_ts, current, ts)) {
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "utils/atomic_wrapper.hpp"
+
+enum class LockMode : uint8_t { SHARED, EXCLUSIVE };
+
+/**
+ * Locks declared by a transaction before it runs, and the position of each of its requests in
+ * the queue of the lock once sequenced (see LockManager).
+ */
+class LockSet {
+public:
+    void add(uint32_t lock_id, LockMode mode) { requests.push_back(Request{lock_id, mode}); }
+
+    void clear() {
+        requests.clear();
+        grants.clear();
+    }
+
+    size_t size() const { return requests.size(); }
+
+private:
+    friend class LockManager;
+
+    struct Request {
+        uint32_t lock_id;
+        LockMode mode;
+    };
+
+    // The request is granted once num_released of the lock reaches wait_for
+    struct Grant {
+        uint32_t lock_id;
+        uint64_t wait_for;
+    };
+
+    std::vector<Request> requests;
+    std::vector<Grant> grants;
+
+    // A transaction must not queue behind itself, so requests for the same lock are merged
+    // into one, exclusive if any of them is.
+    void merge_requests() {
+        std::sort(requests.begin(), requests.end(), [](const Request& lhs, const Request& rhs) {
+            return lhs.lock_id < rhs.lock_id;
+        });
+        size_t n = 0;
+        for (size_t i = 0; i < requests.size(); i++) {
+            if (n > 0 && requests[n - 1].lock_id == requests[i].lock_id) {
+                if (requests[i].mode == LockMode::EXCLUSIVE) {
+                    requests[n - 1].mode = LockMode::EXCLUSIVE;
+                }
+            } else {
+                requests[n++] = requests[i];
+            }
+        }
+        requests.resize(n);
+    }
+};
+
+/**
+ * Calvin style deterministic lock manager.
+ * The sequencer appends the lock requests of whole batches of transactions (epochs) to the lock
+ * queues in a single global order, and every lock is granted in queue order: an exclusive
+ * request once all earlier requests are released, a shared request once the last exclusive
+ * request before it is released. Since requests behind an unreleased exclusive request cannot
+ * be granted, these conditions reduce to counting releases, so a queue is just three counters.
+ * A transaction only waits for transactions sequenced before it. Workers that execute their
+ * sequenced transactions in order therefore never deadlock, and transactions never abort
+ * because of conflicts. Lock ids are 0 to num_locks - 1.
+ */
+class LockManager {
+public:
+    void initialize(size_t num_locks) {
+        locks = std::make_unique<Lock[]>(num_locks);
+        size = num_locks;
+    }
+
+    // Sequences a batch of transactions, in the order of the batch
+    void sequence(LockSet* batch, size_t num_txs) {
+        for (size_t i = 0; i < num_txs; i++) {
+            batch[i].merge_requests();
+            batch[i].grants.clear();
+        }
+        lock_sequencer();
+        for (size_t i = 0; i < num_txs; i++) {
+            for (const LockSet::Request& req: batch[i].requests) {
+                Lock& l = get_lock(req.lock_id);
+                uint64_t pos = l.num_requests++;
+                if (req.mode == LockMode::EXCLUSIVE) {
+                    batch[i].grants.push_back(LockSet::Grant{req.lock_id, pos});
+                    l.exclusive_end = pos + 1;
+                } else {
+                    batch[i].grants.push_back(LockSet::Grant{req.lock_id, l.exclusive_end});
+                }
+            }
+        }
+        num_epochs++;
+        unlock_sequencer();
+    }
+
+    // Waits until all locks of a sequenced transaction are granted
+    void acquire(const LockSet& ls) {
+        for (const LockSet::Grant& g: ls.grants) {
+            uint64_t& released = get_lock(g.lock_id).num_released;
+            while (load_acquire(released) < g.wait_for) {
+            }
+        }
+    }
+
+    void release(const LockSet& ls) {
+        for (const LockSet::Grant& g: ls.grants) {
+            fetch_add(get_lock(g.lock_id).num_released, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    uint64_t get_num_epochs() const { return num_epochs; }
+
+    static LockManager& get_lock_manager() {
+        static LockManager lm;
+        return lm;
+    }
+
+private:
+    struct alignas(64) Lock {
+        uint64_t num_requests = 0;   // sequenced so far, modified by the sequencer only
+        uint64_t exclusive_end = 0;  // position of the last exclusive request + 1
+        uint64_t num_released = 0;
+    };
+
+    std::unique_ptr<Lock[]> locks;
+    size_t size = 0;
+    alignas(64) bool sequencing = false;
+    uint64_t num_epochs = 0;
+
+    Lock& get_lock(uint32_t lock_id) {
+        if (lock_id >= size) throw std::runtime_error("invalid lock id");
+        return locks[lock_id];
+    }
+
+    void lock_sequencer() {
+        while (true) {
+            bool expected = false;
+            if (!load_acquire(sequencing) && compare_exchange(sequencing, expected, true)) return;
+        }
+    }
+
+    void unlock_sequencer() { store_release(sequencing, false); }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "protocols/common/schema.hpp"
+
+using Rec = void;
+
+enum WriteType { UPDATE = 0, INSERT, DELETE };
+
+template <typename Value>
+struct WriteElement {
+    WriteElement(Rec* before, WriteType wt, Value* val)
+        : before(before)
+        , wt(wt)
+        , val(val){};
+    Rec* before = nullptr;  // before image of the record modified in place, restored on abort
+                            // nullptr when wt is INSERT, or DELETE of an unmodified record
+    WriteType wt = UPDATE;
+    Value* val;  // pointer to index
+};
+
+template <typename Key, typename Value>
+class WriteSet {
+public:
+    using Table = std::unordered_map<Key, WriteElement<Value>>;
+    Table& get_table(TableID table_id) { return ws[table_id]; }
+
+private:
+    std::unordered_map<TableID, Table> ws;
+};
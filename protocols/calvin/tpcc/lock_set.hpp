@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "benchmarks/tpcc/include/config.hpp"
+#include "benchmarks/tpcc/include/delivery_tx.hpp"
+#include "benchmarks/tpcc/include/neworder_tx.hpp"
+#include "benchmarks/tpcc/include/orderstatus_tx.hpp"
+#include "benchmarks/tpcc/include/payment_tx.hpp"
+#include "benchmarks/tpcc/include/record_layout.hpp"
+#include "benchmarks/tpcc/include/stocklevel_tx.hpp"
+#include "protocols/calvin/include/lock_manager.hpp"
+
+/**
+ * Locks of TPC-C transactions, derived from their inputs.
+ * Each warehouse has a lock for the warehouse record, one per district for the district record
+ * and the orders, new orders and order lines of the district, one per district for the
+ * customers of the district and their last-name index (customers looked up by last name are
+ * only known at run time), and STOCK_LOCKS locks for its stock records, selected by item id.
+ * Items are read-only and not locked, and history records have no key.
+ */
+class TpccLocks {
+public:
+    static constexpr uint32_t STOCK_LOCKS = 64;
+    static constexpr uint32_t LOCKS_PER_WAREHOUSE = 1 + 2 * District::DISTS_PER_WARE + STOCK_LOCKS;
+
+    static size_t get_num_locks() {
+        return get_config().get_num_warehouses() * LOCKS_PER_WAREHOUSE;
+    }
+
+    static uint32_t warehouse(uint16_t w_id) { return (w_id - 1) * LOCKS_PER_WAREHOUSE; }
+
+    static uint32_t district(uint16_t w_id, uint8_t d_id) { return warehouse(w_id) + d_id; }
+
+    static uint32_t customers(uint16_t w_id, uint8_t d_id) {
+        return warehouse(w_id) + District::DISTS_PER_WARE + d_id;
+    }
+
+    static uint32_t stock(uint16_t w_id, uint32_t i_id) {
+        return warehouse(w_id) + 1 + 2 * District::DISTS_PER_WARE + i_id % STOCK_LOCKS;
+    }
+};
+
+inline void declare_locks(const NewOrderTx::Input& input, LockSet& ls) {
+    ls.add(TpccLocks::warehouse(input.w_id), LockMode::SHARED);
+    ls.add(TpccLocks::district(input.w_id, input.d_id), LockMode::EXCLUSIVE);
+    ls.add(TpccLocks::customers(input.w_id, input.d_id), LockMode::SHARED);
+    for (uint8_t i = 0; i < input.ol_cnt; i++) {
+        if (input.items[i].ol_i_id == Item::UNUSED_ID) continue;
+        ls.add(
+            TpccLocks::stock(input.items[i].ol_supply_w_id, input.items[i].ol_i_id),
+            LockMode::EXCLUSIVE);
+    }
+}
+
+inline void declare_locks(const PaymentTx::Input& input, LockSet& ls) {
+    ls.add(TpccLocks::warehouse(input.w_id), LockMode::EXCLUSIVE);
+    ls.add(TpccLocks::district(input.w_id, input.d_id), LockMode::EXCLUSIVE);
+    ls.add(TpccLocks::customers(input.c_w_id, input.c_d_id), LockMode::EXCLUSIVE);
+}
+
+inline void declare_locks(const OrderStatusTx::Input& input, LockSet& ls) {
+    ls.add(TpccLocks::district(input.w_id, input.d_id), LockMode::SHARED);
+    ls.add(TpccLocks::customers(input.w_id, input.d_id), LockMode::SHARED);
+}
+
+inline void declare_locks(const DeliveryTx::Input& input, LockSet& ls) {
+    for (uint8_t d_id = 1; d_id <= District::DISTS_PER_WARE; d_id++) {
+        ls.add(TpccLocks::district(input.w_id, d_id), LockMode::EXCLUSIVE);
+        ls.add(TpccLocks::customers(input.w_id, d_id), LockMode::EXCLUSIVE);
+    }
+}
+
+// The stock records read are those of the last 20 orders, which are only known at run time, so
+// all stock locks of the warehouse are taken
+inline void declare_locks(const StockLevelTx::Input& input, LockSet& ls) {
+    ls.add(TpccLocks::district(input.w_id, input.d_id), LockMode::SHARED);
+    uint32_t first = TpccLocks::stock(input.w_id, 0);
+    for (uint32_t i = 0; i < TpccLocks::STOCK_LOCKS; i++) ls.add(first + i, LockMode::SHARED);
+}
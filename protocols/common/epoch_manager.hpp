@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
@@ -9,8 +10,11 @@
 #include <vector>
 
 #include "protocols/common/memory_allocator.hpp"
+#include "protocols/common/schema.hpp"
+#include "protocols/common/slab_allocator.hpp"
 #include "protocols/common/transaction_id.hpp"
 #include "utils/atomic_wrapper.hpp"
+#include "utils/coroutine.hpp"
 #include "utils/logger.hpp"
 
 template <typename Protocol>
@@ -76,13 +80,23 @@ class Worker {
 public:
     Worker(uint32_t worker_id)
         : worker_id(worker_id)
-        , tx_counter(1) {}
+        , tx_counter(1) {
+        std::fill_n(slot_epochs, TxSlot::MAX, UINT32_MAX);
+    }
 
+    // The epoch of the worker is the oldest epoch its transactions started in, as the
+    // coroutine mode runs several of them at a time (one per TxSlot, see utils/coroutine.hpp)
     std::unique_ptr<Protocol> begin_tx() {
-        store_release(get_worker_epoch(), load_acquire(EpochManager<Protocol>::get_global_epoch()));
+        uint32_t epoch = load_acquire(EpochManager<Protocol>::get_global_epoch());
+        uint32_t slot = TxSlot::get();
+        slot_epochs[slot] = epoch;
+        num_slots = std::max(num_slots, slot + 1);
+        uint32_t oldest = epoch;
+        for (uint32_t i = 0; i < num_slots; i++) oldest = std::min(oldest, slot_epochs[i]);
+        store_release(get_worker_epoch(), oldest);
         TxID txid(worker_id, tx_counter);
         ++tx_counter;
-        return std::make_unique<Protocol>(txid, load_acquire(get_worker_epoch()));
+        return std::make_unique<Protocol>(txid, epoch);
     }
 
     uint32_t& get_worker_epoch() { return worker_epoch; }
@@ -92,6 +106,8 @@ public:
 private:
     uint32_t worker_id;
     uint32_t tx_counter;
+    uint32_t num_slots = 0;
+    uint32_t slot_epochs[TxSlot::MAX];  // epoch of the last transaction of each slot, if any
     alignas(64) uint32_t worker_epoch;
 };
 
@@ -102,6 +118,11 @@ public:
         gc_container.emplace(current_epoch, ptr);
     }
 
+    // For records allocated from SlabAllocator
+    static void collect(uint32_t current_epoch, TableID table_id, void* rec) {
+        SlabAllocator::retire(current_epoch, table_id, rec);
+    }
+
     static void remove(uint32_t current_epoch) {
         auto& gc_container = get_gc_container();
         if (current_epoch >= 2) {
@@ -113,6 +134,7 @@ public:
             }
 
             gc_container.erase(gc_container.begin(), end);
+            SlabAllocator::reclaim(current_epoch - 2);
         }
     }
 
@@ -1,12 +1,88 @@
 #pragma once
 
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+
 #include "mimalloc/include/mimalloc.h"
 
 class MemoryAllocator {
 public:
     static void* allocate(size_t size) { return mi_malloc(size); }
 
-    static void* aligned_allocate(size_t size) { return mi_malloc(size); }
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    static void* aligned_allocate(size_t size) { return mi_malloc_aligned(size, CACHE_LINE_SIZE); }
 
     static void deallocate(void* ptr) { return mi_free(ptr); }
-};
\ No newline at end of file
+
+    enum PageMode { DEFAULT_PAGES, HUGE_2M, HUGE_1G };
+
+    /**
+     * Backs subsequently allocated mimalloc segments with huge pages. This covers records,
+     * versions and index nodes alike since Masstree allocates through the overridden malloc.
+     *   none: 4KiB pages (default)
+     *   2m:   2MiB pages (MAP_HUGETLB if hugetlbfs pages are available, transparent huge
+     *         pages otherwise)
+     *   1g:   reserves gib 1GiB pages interleaved over the NUMA nodes up front; allocations
+     *         beyond the reservation fall back to 2MiB pages
+     * Must be called before tables are loaded.
+     */
+    static void configure_pages(const std::string& mode, size_t gib) {
+        if (mode.empty() || mode == "none") {
+            page_mode() = DEFAULT_PAGES;
+        } else if (mode == "2m") {
+            mi_option_enable(mi_option_large_os_pages);
+            page_mode() = HUGE_2M;
+        } else if (mode == "1g") {
+            if (gib == 0) throw std::runtime_error("number of 1GiB pages is not specified");
+            if (mi_reserve_huge_os_pages_interleave(gib, 0, gib * 1000) != 0) {
+                throw std::runtime_error(
+                    "failed to reserve " + std::to_string(gib) + " 1GiB page(s)");
+            }
+            mi_option_enable(mi_option_large_os_pages);
+            page_mode() = HUGE_1G;
+        } else {
+            throw std::runtime_error("unknown page mode: " + mode);
+        }
+    }
+
+    static PageMode get_page_mode() { return page_mode(); }
+
+    /**
+     * Hands size bytes of memory bound to NUMA node node_id (OS id) to mimalloc as an arena.
+     * mimalloc prefers the arena of the node the allocating thread is running on, so threads
+     * pinned to the node allocate node-local memory regardless of which thread touches it
+     * first. Allocations fall back to regular OS memory once the arena is exhausted.
+     */
+    static void reserve_node_arena(int node_id, size_t size) {
+        if (node_id < 0 || node_id >= static_cast<int>(sizeof(unsigned long) * 8)) {
+            throw std::runtime_error("unsupported numa node " + std::to_string(node_id));
+        }
+        void* start =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (start == MAP_FAILED) throw std::runtime_error("failed to map arena memory");
+        // madvise only fails if THP is not compiled in, in which case 4KiB pages are used
+        if (page_mode() != DEFAULT_PAGES) madvise(start, size, MADV_HUGEPAGE);
+        unsigned long nodemask = 1UL << node_id;
+        if (syscall(SYS_mbind, start, size, MPOL_BIND, &nodemask, sizeof(nodemask) * 8 + 1, 0)) {
+            munmap(start, size);
+            throw std::runtime_error("failed to bind arena to node " + std::to_string(node_id));
+        }
+        // pages are zero-filled and committed on first touch
+        if (!mi_manage_os_memory(start, size, true, false, true, node_id)) {
+            munmap(start, size);
+            throw std::runtime_error("failed to register arena of node " + std::to_string(node_id));
+        }
+    }
+
+private:
+    static PageMode& page_mode() {
+        static PageMode m = DEFAULT_PAGES;
+        return m;
+    }
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+/**
+ * Result list of a range scan (a std::vector), taken from a thread-local pool and given back
+ * cleared on destruction, so that scans reuse the capacity of earlier ones instead of
+ * allocating per scanned key. Buffers of nested scans are distinct.
+ */
+template <typename List>
+class ScanBuffer {
+public:
+    ScanBuffer()
+        : list(acquire()) {}
+
+    ~ScanBuffer() {
+        list.clear();
+        get_pool().push_back(std::move(list));
+    }
+
+    ScanBuffer(const ScanBuffer&) = delete;
+    ScanBuffer& operator=(const ScanBuffer&) = delete;
+
+    List& get() { return list; }
+
+private:
+    List list;
+
+    static std::vector<List>& get_pool() {
+        thread_local std::vector<List> pool;
+        return pool;
+    }
+
+    static List acquire() {
+        std::vector<List>& pool = get_pool();
+        if (pool.empty()) return List();
+        List l = std::move(pool.back());
+        pool.pop_back();
+        return l;
+    }
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 using TableID = uint64_t;
@@ -10,6 +12,7 @@ using TableID = uint64_t;
 struct TableInfo {
     size_t rec_size = 0;
     TableID secondary = 0;
+    std::vector<std::pair<size_t, size_t>> commutative;  // (offset, size) of commutative fields
 };
 
 class Schema {
@@ -25,6 +28,24 @@ public:
         schema[primary].secondary = secondary;
     }
 
+    // Fields that may be updated by commutative adds (Transaction::add_to_field())
+    void add_commutative_field(TableID table_id, size_t offset, size_t size) {
+        auto& fields = schema[table_id].commutative;
+        fields.emplace_back(offset, size);
+        std::sort(fields.begin(), fields.end());
+    }
+
+    const std::vector<std::pair<size_t, size_t>>& get_commutative_fields(TableID table_id) const {
+        return schema.at(table_id).commutative;
+    }
+
+    bool is_commutative_field(TableID table_id, size_t offset, size_t size) const {
+        for (auto& [o, s]: get_commutative_fields(table_id)) {
+            if (o == offset && s == size) return true;
+        }
+        return false;
+    }
+
     std::vector<TableID> get_tables() {
         std::vector<TableID> tables;
         for (auto& [table_id, size]: schema) {
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include "protocols/common/memory_allocator.hpp"
+#include "protocols/common/schema.hpp"
+
+/**
+ * Per-thread, per-table pools of fixed-size records.
+ * Each table gets slots of Schema::get_record_size() rounded up to a cache line, carved out of
+ * cache-line-aligned chunks. Freed slots go to the free list of the calling thread's pool for
+ * the table, regardless of which thread allocated them.
+ *
+ * Records retired by committed writers are kept in per-epoch batches (retire()) and spliced
+ * back into the free list as a whole once the epoch is safe (reclaim()), instead of being freed
+ * one by one.
+ *
+ * Chunks are never returned to mimalloc: records outlive the threads that allocate them (e.g.
+ * loader threads), and a thread's pool is dropped without touching the chunks when it exits.
+ */
+class SlabAllocator {
+public:
+    static constexpr size_t SLOT_ALIGNMENT = MemoryAllocator::CACHE_LINE_SIZE;
+    static constexpr size_t CHUNK_SIZE = 256 * 1024;
+    static constexpr size_t MIN_SLOTS_PER_CHUNK = 16;
+
+    static void* allocate(TableID table_id) { return get_slab(table_id).allocate(); }
+
+    static void deallocate(TableID table_id, void* ptr) {
+        if (ptr) get_slab(table_id).deallocate(ptr);
+    }
+
+    // ptr can be reused once epoch (or a later epoch) is reclaimed
+    static void retire(uint32_t epoch, TableID table_id, void* ptr) {
+        if (ptr) get_slab(table_id).retire(epoch, ptr);
+    }
+
+    // Returns records retired in epochs <= epoch to the free lists of the calling thread
+    static void reclaim(uint32_t epoch) {
+        for (auto& [table_id, slab]: get_slabs()) slab.reclaim(epoch);
+    }
+
+private:
+    struct Slot {
+        Slot* next;
+    };
+
+    // Intrusive singly-linked list of slots
+    struct SlotList {
+        Slot* head = nullptr;
+        Slot* tail = nullptr;
+
+        void push(void* ptr) {
+            Slot* s = reinterpret_cast<Slot*>(ptr);
+            s->next = head;
+            head = s;
+            if (!tail) tail = s;
+        }
+
+        void splice(SlotList& rhs) {
+            if (!rhs.head) return;
+            rhs.tail->next = head;
+            head = rhs.head;
+            if (!tail) tail = rhs.tail;
+            rhs.head = rhs.tail = nullptr;
+        }
+    };
+
+    class Slab {
+    public:
+        explicit Slab(size_t rec_size)
+            : slot_size(round_up(std::max(rec_size, sizeof(Slot)), SLOT_ALIGNMENT))
+            , chunk_size(std::max(CHUNK_SIZE, slot_size * MIN_SLOTS_PER_CHUNK)) {}
+
+        void* allocate() {
+            if (free_slots.head) {
+                Slot* s = free_slots.head;
+                free_slots.head = s->next;
+                if (!free_slots.head) free_slots.tail = nullptr;
+                return s;
+            }
+            if (bump == bump_end) {
+                bump = reinterpret_cast<uint8_t*>(MemoryAllocator::aligned_allocate(chunk_size));
+                bump_end = bump + (chunk_size / slot_size) * slot_size;
+            }
+            void* ptr = bump;
+            bump += slot_size;
+            return ptr;
+        }
+
+        void deallocate(void* ptr) { free_slots.push(ptr); }
+
+        void retire(uint32_t epoch, void* ptr) {
+            // Batches are ordered by epoch. Putting a record into a later batch only delays its
+            // reuse, so a smaller epoch than the newest batch can safely join that batch.
+            if (retired.empty() || retired.back().first < epoch) {
+                retired.emplace_back(epoch, SlotList());
+            }
+            retired.back().second.push(ptr);
+        }
+
+        void reclaim(uint32_t epoch) {
+            while (!retired.empty() && retired.front().first <= epoch) {
+                free_slots.splice(retired.front().second);
+                retired.pop_front();
+            }
+        }
+
+    private:
+        size_t slot_size;
+        size_t chunk_size;
+        uint8_t* bump = nullptr;
+        uint8_t* bump_end = nullptr;
+        SlotList free_slots;
+        std::deque<std::pair<uint32_t, SlotList>> retired;
+
+        static size_t round_up(size_t n, size_t align) { return (n + align - 1) / align * align; }
+    };
+
+    static std::unordered_map<TableID, Slab>& get_slabs() {
+        thread_local std::unordered_map<TableID, Slab> slabs;
+        return slabs;
+    }
+
+    static Slab& get_slab(TableID table_id) {
+        auto& slabs = get_slabs();
+        auto it = slabs.find(table_id);
+        if (it != slabs.end()) return it->second;
+        size_t rec_size = Schema::get_schema().get_record_size(table_id);
+        return slabs.emplace(table_id, Slab(rec_size)).first->second;
+    }
+};
@@ -14,6 +14,53 @@
 #include "utils/atomic_wrapper.hpp"
 #include "utils/logger.hpp"
 
+// Objects removed by a transaction are held until the smallest timestamp of the running
+// transactions passes the largest count taken after the removal (see Worker::begin_tx()), as
+// transactions that started before may still use them
+class GarbageCollector {
+public:
+    static void collect(uint64_t current_largest_ts, void* ptr) {
+        get_temp_gc_map().emplace(current_largest_ts, ptr);
+    }
+
+    static void remove(uint64_t smallest_ts) {
+        auto& gc_map = get_gc_map();
+        auto end = gc_map.upper_bound(smallest_ts);
+        for (auto iter = gc_map.begin(); iter != end; ++iter) {
+            MemoryAllocator::deallocate(iter->second);
+        }
+        gc_map.erase(gc_map.begin(), end);
+    }
+
+    // Whether collected pointers wait for attach_new_ts()
+    static bool has_detached() { return !get_temp_gc_map().empty(); }
+
+    static void attach_new_ts(uint64_t new_largest_ts) {
+        auto& temp_gc_map = get_temp_gc_map();
+        auto& gc_map = get_gc_map();
+        auto end = temp_gc_map.upper_bound(new_largest_ts);
+        auto iter = temp_gc_map.begin();
+        while (iter != end) {
+            auto element = temp_gc_map.extract(iter++);
+            element.key() = new_largest_ts;
+            gc_map.insert(std::move(element));
+        }
+    }
+
+private:
+    // gc pointers that hold timestamp
+    static std::multimap<uint64_t, void*>& get_gc_map() {
+        thread_local std::multimap<uint64_t, void*> gc_map;
+        return gc_map;
+    }
+
+    // temporary holds some gc pointers
+    static std::multimap<uint64_t, void*>& get_temp_gc_map() {
+        thread_local std::multimap<uint64_t, void*> gc_map;
+        return gc_map;
+    }
+};
+
 template <typename Protocol>
 class Worker;
 
@@ -47,14 +94,16 @@ private:
     std::vector<Worker<Protocol>*> workers;
     uint64_t interval;
 
+    // Smallest count of the running transactions and largest count of the next ones. The
+    // count of a running transaction can be far below the next count of its worker, which
+    // synchronize() and get_abort_boosted_ts() move ahead.
     std::pair<uint64_t, uint64_t> get_gc_txn_cnt() {
         uint64_t largest = 0;
         uint64_t smallest = UINT64_MAX;
         for (Worker<Protocol>* worker: workers) {
             if (worker == nullptr) continue;
-            uint64_t txn_cnt = load_acquire(worker->txn_cnt);
-            smallest = std::min(txn_cnt, smallest);
-            largest = std::max(txn_cnt, largest);
+            smallest = std::min(load_acquire(worker->active_txn_cnt), smallest);
+            largest = std::max(load_acquire(worker->txn_cnt), largest);
         }
         return std::make_pair(smallest, largest);
     }
@@ -90,6 +139,7 @@ template <typename Protocol>
 class Worker {
 public:
     alignas(64) uint64_t txn_cnt{1};
+    uint64_t active_txn_cnt{1};  // count of the running transaction
     uint64_t smallest_txn_cnt{1};
     uint64_t largest_txn_cnt{1};
 
@@ -102,6 +152,12 @@ public:
         , tx_counter(1) {}
 
     std::unique_ptr<Protocol> begin_tx() {
+        // What the previous transactions of this worker removed may still be used by the
+        // transactions running on the other workers, which all started before the current
+        // largest count, so it is freed once the smallest timestamp has passed that count
+        if (GarbageCollector::has_detached()) {
+            GarbageCollector::attach_new_ts(get_ts(tsm.get_gc_txn_cnt().second));
+        }
         TxID txid(worker_id, tx_counter);
         ++tx_counter;
         return std::make_unique<Protocol>(txid, get_new_ts(), get_smallest_ts(), get_largest_ts());
@@ -110,6 +166,7 @@ public:
     uint64_t get_new_ts() {
         abort_cnt = 0;
         uint64_t cnt = fetch_add(txn_cnt, 1);
+        store_release(active_txn_cnt, cnt);
         if (cnt % synchronize_cnt == 0) synchronize();
         return cnt << (sizeof(worker_id) * 8) | worker_id;
     }
@@ -118,6 +175,7 @@ public:
         abort_cnt++;
         uint64_t cnt =
             fetch_add(txn_cnt, std::pow(2, std::min(abort_cnt, static_cast<uint64_t>(2))));
+        store_release(active_txn_cnt, cnt);
         if (cnt % synchronize_cnt == 0) synchronize();
         return cnt << (sizeof(worker_id) * 8) | worker_id;
     }
@@ -140,45 +198,3 @@ private:
 
     void synchronize() { tsm.synchronize(worker_id, load_acquire(txn_cnt), next_worker_offset++); }
 };
-
-class GarbageCollector {
-public:
-    static void collect(uint64_t current_largest_ts, void* ptr) {
-        get_temp_gc_map().emplace(current_largest_ts, ptr);
-    }
-
-    static void remove(uint64_t smallest_ts, uint64_t new_largest_ts) {
-        attach_new_ts(new_largest_ts);
-        auto& gc_map = get_gc_map();
-        auto end = gc_map.upper_bound(smallest_ts);
-        for (auto iter = gc_map.begin(); iter != end; ++iter) {
-            MemoryAllocator::deallocate(iter->second);
-        }
-        gc_map.erase(gc_map.begin(), end);
-    }
-
-private:
-    // gc pointers that hold timestamp
-    static std::multimap<uint64_t, void*>& get_gc_map() {
-        thread_local std::multimap<uint64_t, void*> gc_map;
-        return gc_map;
-    }
-
-    // temporary holds some gc pointers
-    static std::multimap<uint64_t, void*>& get_temp_gc_map() {
-        thread_local std::multimap<uint64_t, void*> gc_map;
-        return gc_map;
-    }
-
-    static void attach_new_ts(uint64_t new_largest_ts) {
-        auto& temp_gc_map = get_temp_gc_map();
-        auto& gc_map = get_gc_map();
-        auto end = temp_gc_map.upper_bound(new_largest_ts);
-        auto iter = temp_gc_map.begin();
-        while (iter != end) {
-            auto element = temp_gc_map.extract(iter++);
-            element.key() = new_largest_ts;
-            gc_map.insert(std::move(element));
-        }
-    }
-};
\ No newline at end of file
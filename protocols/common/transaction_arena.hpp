@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "protocols/common/memory_allocator.hpp"
+#include "utils/coroutine.hpp"
+
+/**
+ * Thread-local bump allocator for memory that lives at most until the end of the current
+ * transaction attempt (local copies of records). reset() makes all of it reusable at once.
+ * Chunks are kept across transactions, so the allocator is not touched in steady state.
+ * Transactions multiplexed on a thread by the coroutine mode each have their own arena (see
+ * TxSlot in utils/coroutine.hpp).
+ */
+class TransactionArena {
+public:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    static void* allocate(size_t size) {
+        TransactionArena& a = get_arena();
+        constexpr size_t mask = MemoryAllocator::CACHE_LINE_SIZE - 1;
+        size = (size + mask) & ~mask;
+        while (a.cur < a.chunks.size()) {
+            Chunk& c = a.chunks[a.cur];
+            if (c.used + size <= c.size) {
+                void* ptr = c.base + c.used;
+                c.used += size;
+                return ptr;
+            }
+            a.cur++;
+        }
+        size_t chunk_size = std::max(CHUNK_SIZE, size);
+        uint8_t* base = reinterpret_cast<uint8_t*>(MemoryAllocator::aligned_allocate(chunk_size));
+        a.chunks.push_back(Chunk{base, chunk_size, size});
+        a.cur = a.chunks.size() - 1;
+        return base;
+    }
+
+    static void reset() {
+        TransactionArena& a = get_arena();
+        for (Chunk& c: a.chunks) c.used = 0;
+        a.cur = 0;
+    }
+
+    ~TransactionArena() {
+        for (Chunk& c: chunks) MemoryAllocator::deallocate(c.base);
+    }
+
+private:
+    struct Chunk {
+        uint8_t* base;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t cur = 0;
+
+    static TransactionArena& get_arena() {
+        thread_local TransactionArena a[TxSlot::MAX];
+        return a[TxSlot::get()];
+    }
+};
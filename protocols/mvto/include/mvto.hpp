@@ -4,18 +4,24 @@
 #include <cstring>
 #include <set>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
+#include "indexes/index_interface.hpp"
 #include "protocols/common/timestamp_manager.hpp"
 #include "protocols/common/transaction_id.hpp"
 #include "protocols/mvto/include/readwriteset.hpp"
 #include "utils/logger.hpp"
+#include "utils/profiler.hpp"
 #include "utils/utils.hpp"
 
 template <typename Index>
 class MVTO {
 public:
+    static_assert(is_index_v<Index>, "Index must implement indexes/index_interface.hpp");
     using Key = typename Index::Key;
     using Value = typename Index::Value;
+    using KRList = std::vector<std::pair<Key, Rec*>>;  // results of scans in scan order
     using Version = typename Value::Version;
     using LeafNode = typename Index::LeafNode;
     using NodeInfo = typename Index::NodeInfo;
@@ -28,7 +34,7 @@ public:
         LOG_INFO("START Tx, ts: %lu, s_ts: %lu, l_ts: %lu", start_ts, smallest_ts, largest_ts);
     }
 
-    ~MVTO() { GarbageCollector::remove(smallest_ts, largest_ts); }
+    ~MVTO() { GarbageCollector::remove(smallest_ts); }
 
     void set_new_ts(uint64_t start_ts_, uint64_t smallest_ts_, uint64_t largest_ts_) {
         start_ts = start_ts_;
@@ -36,7 +42,16 @@ public:
         largest_ts = largest_ts_;
     }
 
-    const Rec* read(TableID table_id, Key key) {
+    // Looks up keys in the index together, so that the cache misses of the lookups overlap (see
+    // MasstreeIndexes::multi_find), and stores the value of each key in vals (nullptr if it is
+    // not found). The read/write set is not modified. A value found is passed to read() or
+    // update() as found, so that its key is not looked up again.
+    void lookup(TableID table_id, const std::vector<Key>& keys, std::vector<Value*>& vals) {
+        vals.resize(keys.size());
+        Index::get_index().multi_find(table_id, keys.size(), keys.data(), vals.data());
+    }
+
+    const Rec* read(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO(
             "READ (ts: %lu, s_ts: %lu, l_ts: %lu, t: %lu, k: %lu)", start_ts, smallest_ts,
             largest_ts, table_id, key);
@@ -46,8 +61,9 @@ public:
         auto rw_iter = rw_table.find(key);
 
         if (rw_iter == rw_table.end()) {
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) return nullptr;
 
             // Read version chain and get the correct version
@@ -177,7 +193,7 @@ public:
         }
     }
 
-    Rec* update(TableID table_id, Key key) {
+    Rec* update(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO(
             "UPDATE (ts: %lu, s_ts: %lu, l_ts: %lu, t: %lu, k: %lu)", start_ts, smallest_ts,
             largest_ts, table_id, key);
@@ -191,8 +207,9 @@ public:
 
         if (rw_iter == rw_table.end()) {
             // Abort if not found in index
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) return nullptr;
 
             // Read version chain and get the correct version
@@ -363,8 +380,7 @@ public:
     }
 
     bool read_scan(
-        TableID table_id, Key lkey, Key rkey, int64_t count, bool rev,
-        std::map<Key, Rec*>& kr_map) {
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool rev, KRList& kr_list) {
         LOG_INFO(
             "READ_SCAN (ts: %lu, s_ts: %lu, l_ts: %lu, t: %lu, lk: %lu, rk: %lu, c: %ld)", start_ts,
             smallest_ts, largest_ts, table_id, lkey, rkey, count);
@@ -375,7 +391,7 @@ public:
 
         auto per_node_func = [&](LeafNode* leaf, uint64_t version, bool& continue_flag) {
             unused(version, continue_flag);
-            leaf->update_ts(start_ts);
+            idx.update_node_ts(table_id, leaf, start_ts);
         };
         auto per_kv_func = [&](Key key, Value* val, bool& continue_flag) {
             auto rw_iter = rw_table.find(key);
@@ -405,13 +421,13 @@ public:
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(version->rec, nullptr, ReadWriteType::READ, false, val));
 
-                kr_map.emplace(key, version->rec);
+                kr_list.emplace_back(key, version->rec);
             } else {
                 auto rwt = rw_iter->second.rwt;
                 if (rwt == ReadWriteType::READ) {
-                    kr_map.emplace(key, rw_iter->second.read_rec);
+                    kr_list.emplace_back(key, rw_iter->second.read_rec);
                 } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                    kr_map.emplace(key, rw_iter->second.write_rec);
+                    kr_list.emplace_back(key, rw_iter->second.write_rec);
                 } else if (rwt == ReadWriteType::DELETE) {
                     throw std::runtime_error("deleted value");
                 } else {
@@ -419,7 +435,7 @@ public:
                 }
             }
 
-            if (count != -1 && static_cast<int64_t>(kr_map.size()) >= count) continue_flag = false;
+            if (count != -1 && static_cast<int64_t>(kr_list.size()) >= count) continue_flag = false;
         };
 
         [[maybe_unused]] typename Index::Result res;
@@ -434,8 +450,7 @@ public:
 
 
     bool update_scan(
-        TableID table_id, Key lkey, Key rkey, int64_t count, bool rev,
-        std::map<Key, Rec*>& kr_map) {
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool rev, KRList& kr_list) {
         LOG_INFO(
             "UPDATE_SCAN (ts: %lu, s_ts: %lu, l_ts: %lu, t: %lu, lk: %lu, rk: %lu, c: %ld)",
             start_ts, smallest_ts, largest_ts, table_id, lkey, rkey, count);
@@ -449,7 +464,7 @@ public:
 
         auto per_node_func = [&](LeafNode* leaf, uint64_t version, bool& continue_flag) {
             unused(version, continue_flag);
-            leaf->update_ts(start_ts);
+            idx.update_node_ts(table_id, leaf, start_ts);
         };
         auto per_kv_func = [&](Key key, Value* val, bool& continue_flag) {
             auto rw_iter = rw_table.find(key);
@@ -483,7 +498,7 @@ public:
                     std::forward_as_tuple(version->rec, rec, ReadWriteType::UPDATE, false, val));
                 // Place it in writeset
                 w_table.emplace_back(key, new_iter);
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
             } else {
                 auto rwt = rw_iter->second.rwt;
                 if (rwt == ReadWriteType::READ) {
@@ -494,9 +509,9 @@ public:
                     rw_iter->second.rwt = ReadWriteType::UPDATE;
                     // Place it in writeset
                     w_table.emplace_back(key, rw_iter);
-                    kr_map.emplace(key, rec);
+                    kr_list.emplace_back(key, rec);
                 } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                    kr_map.emplace(key, rw_iter->second.write_rec);
+                    kr_list.emplace_back(key, rw_iter->second.write_rec);
                 } else if (rwt == ReadWriteType::DELETE) {
                     throw std::runtime_error("deleted value");
                 } else {
@@ -504,7 +519,7 @@ public:
                 }
             }
 
-            if (count != -1 && static_cast<int64_t>(kr_map.size()) >= count) continue_flag = false;
+            if (count != -1 && static_cast<int64_t>(kr_list.size()) >= count) continue_flag = false;
         };
 
         [[maybe_unused]] typename Index::Result res;
@@ -592,6 +607,7 @@ public:
         Index& idx = Index::get_index();
 
         LOG_INFO("LOCKING RECORDS");
+        PROFILE_PHASE(LOCK);
         // Lock records
         for (TableID table_id: tables) {
             auto& w_table = ws.get_table(table_id);
@@ -621,8 +637,7 @@ public:
                     } else if (res == Index::Result::OK) {
                         // to prevent phantoms, abort if timestamp of the node is larger than
                         // start_ts
-                        LeafNode* leaf = reinterpret_cast<LeafNode*>(ni.node);
-                        if (leaf->get_ts() > start_ts) {
+                        if (idx.get_node_ts(table_id, ni.node) > start_ts) {
                             remove_already_inserted(table_id, w_iter->first, false);
                             unlock_writeset(table_id, w_iter->first, false);
                             return false;
@@ -655,6 +670,7 @@ public:
         }
 
         LOG_INFO("APPLY CHANGES TO INDEX");
+        PROFILE_PHASE(WRITE);
         // Apply changes to index
         for (TableID table_id: tables) {
             auto& w_table = ws.get_table(table_id);
@@ -679,6 +695,7 @@ public:
     }
 
     void abort() {
+        PROFILE_PHASE(ABORT);
         for (TableID table_id: tables) {
             auto& rw_table = rws.get_table(table_id);
             auto& w_table = ws.get_table(table_id);
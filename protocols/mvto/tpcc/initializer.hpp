@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstddef>
+
 #include "benchmarks/tpcc/include/config.hpp"
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "protocols/common/memory_allocator.hpp"
 #include "protocols/common/schema.hpp"
+#include "protocols/tpcc_common/index_selection.hpp"
 #include "protocols/tpcc_common/record_misc.hpp"
+#include "protocols/tpcc_common/warehouse_loader.hpp"
 #include "utils/utils.hpp"
 
 template <typename Index>
@@ -49,6 +53,12 @@ private:
         Stock* s = reinterpret_cast<Stock*>(MemoryAllocator::aligned_allocate(sizeof(Stock)));
         s->generate(s_w_id, s_i_id);
         insert_into_index(get_id<Stock>(), key.get_raw_key(), reinterpret_cast<void*>(s));
+#if TPCC_HOT_COLD_SPLIT
+        StockData* sd =
+            reinterpret_cast<StockData*>(MemoryAllocator::aligned_allocate(sizeof(StockData)));
+        sd->generate(s_w_id, s_i_id);
+        insert_into_index(get_id<StockData>(), key.get_raw_key(), reinterpret_cast<void*>(sd));
+#endif
     }
 
     static void create_and_insert_district_record(uint16_t d_w_id, uint8_t d_id) {
@@ -66,10 +76,19 @@ private:
             reinterpret_cast<Customer*>(MemoryAllocator::aligned_allocate(sizeof(Customer)));
         c->generate(c_w_id, c_d_id, c_id, t);
         insert_into_index(get_id<Customer>(), key.get_raw_key(), reinterpret_cast<void*>(c));
-        CustomerSecondary cs;
-        cs.key.c_key = key.c_key;
+#if TPCC_HOT_COLD_SPLIT
+        CustomerData* cd = reinterpret_cast<CustomerData*>(
+            MemoryAllocator::aligned_allocate(sizeof(CustomerData)));
+        cd->generate(c_w_id, c_d_id, c_id);
+        insert_into_index(
+            get_id<CustomerData>(), key.get_raw_key(), reinterpret_cast<void*>(cd));
+#endif
+        CustomerSecondary* cs = reinterpret_cast<CustomerSecondary*>(
+            MemoryAllocator::aligned_allocate(sizeof(CustomerSecondary)));
+        *cs = CustomerSecondary(*c);
         CustomerSecondaryKey cs_key = CustomerSecondaryKey::create_key(*c);
-        get_customer_secondary_table().emplace(cs_key, cs);
+        insert_into_index(
+            get_id<CustomerSecondary>(), cs_key.get_raw_key(), reinterpret_cast<void*>(cs));
     }
 
     static void create_and_insert_history_record(
@@ -178,27 +197,34 @@ private:
     // Loading warehouses table eventually evokes loading of all the tables other than the items
     // table.
     static void load_warehouses_table() {
-        const size_t nr_w = get_config().get_num_warehouses();
-        for (size_t w_id = 1; w_id <= nr_w; w_id++) {
+        load_warehouses_on_owner_nodes<Index>([](uint16_t w_id) {
             create_and_insert_warehouse_record(w_id);
             load_stocks_table(w_id);
             load_districts_table(w_id);
-        }
+        });
     }
 
 
 public:
     static void load_all_tables() {
+        select_table_indexes<Index>();
         Schema& sch = Schema::get_mutable_schema();
         sch.set_record_size(get_id<Item>(), sizeof(Item));
         sch.set_record_size(get_id<Warehouse>(), sizeof(Warehouse));
         sch.set_record_size(get_id<Stock>(), sizeof(Stock));
         sch.set_record_size(get_id<District>(), sizeof(District));
         sch.set_record_size(get_id<Customer>(), sizeof(Customer));
+        sch.set_record_size(get_id<CustomerSecondary>(), sizeof(CustomerSecondary));
         sch.set_record_size(get_id<Order>(), sizeof(Order));
         sch.set_record_size(get_id<OrderSecondary>(), sizeof(OrderSecondary));
         sch.set_record_size(get_id<OrderLine>(), sizeof(OrderLine));
         sch.set_record_size(get_id<NewOrder>(), sizeof(NewOrder));
+        sch.add_commutative_field(get_id<Warehouse>(), offsetof(Warehouse, w_ytd), sizeof(double));
+        sch.add_commutative_field(get_id<District>(), offsetof(District, d_ytd), sizeof(double));
+#if TPCC_HOT_COLD_SPLIT
+        sch.set_record_size(get_id<StockData>(), sizeof(StockData));
+        sch.set_record_size(get_id<CustomerData>(), sizeof(CustomerData));
+#endif
 
         load_items_table();
         load_warehouses_table();
@@ -15,6 +15,10 @@
 #include "protocols/naive/include/type_tuple.hpp"
 #include "utils/logger.hpp"
 
+#if TPCC_HOT_COLD_SPLIT
+#error "NAIVE keeps one table per record type and does not support TPCC_HOT_COLD_SPLIT"
+#endif
+
 struct CustomerSecondaryKey;
 struct OrderSecondaryKey;
 
@@ -48,6 +48,28 @@ public:
         return rec_ptr == nullptr ? Result::FAIL : Result::SUCCESS;
     }
 
+    // Same as get_record() for each of the n keys. Stops at the first key that does not succeed.
+    template <typename Record>
+    Result get_records_batch(
+        size_t n, const typename Record::Key* rec_keys, const Record** rec_ptrs) {
+        for (size_t i = 0; i < n; i++) {
+            Result res = get_record(rec_ptrs[i], rec_keys[i]);
+            if (res != Result::SUCCESS) return res;
+        }
+        return Result::SUCCESS;
+    }
+
+    // Same as prepare_record_for_update() for each of the n keys
+    template <typename Record>
+    Result prepare_records_for_update_batch(
+        size_t n, const typename Record::Key* rec_keys, Record** rec_ptrs) {
+        for (size_t i = 0; i < n; i++) {
+            Result res = prepare_record_for_update(rec_ptrs[i], rec_keys[i]);
+            if (res != Result::SUCCESS) return res;
+        }
+        return Result::SUCCESS;
+    }
+
     template <IsHistory Record>
     Result prepare_record_for_insert(Record*& rec_ptr) {
         rec_ptr = ws.apply_insert_to_writeset<Record>();
@@ -79,6 +101,21 @@ public:
         return Result::SUCCESS;
     }
 
+    // No commutative writes: an add is a read-modify-write of the record
+    template <typename Record, typename T>
+    Result add_to_field(typename Record::Key rec_key, size_t offset, T delta) {
+        Record* rec_ptr = nullptr;
+        Result res = prepare_record_for_update(rec_ptr, rec_key);
+        if (res != Result::SUCCESS) return res;
+        *reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(rec_ptr) + offset) += delta;
+        return finish_update(rec_ptr);
+    }
+
+    template <typename Record>
+    Result get_record_ignoring_adds(const Record*& rec_ptr, typename Record::Key rec_key) {
+        return get_record(rec_ptr, rec_key);
+    }
+
     template <typename Record>
     Result prepare_record_for_delete(
         [[maybe_unused]] const Record*& rec_ptr, typename Record::Key rec_key) {
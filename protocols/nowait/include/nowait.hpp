@@ -1,19 +1,25 @@
 #pragma once
 
 #include <cstring>
-#include <map>
 #include <set>
 #include <stdexcept>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "indexes/index_interface.hpp"
 #include "protocols/common/epoch_manager.hpp"
+#include "protocols/common/scan_buffer.hpp"
 #include "protocols/nowait/include/readwriteset.hpp"
+#include "utils/profiler.hpp"
 
 template <typename Index>
 class NoWait {
 public:
+    static_assert(is_index_v<Index>, "Index must implement indexes/index_interface.hpp");
     using Key = typename Index::Key;
     using Value = typename Index::Value;
+    using KRList = std::vector<std::pair<Key, Rec*>>;  // results of scans in scan order
 
     NoWait(TxID txid, uint32_t epoch)
         : txid(txid)
@@ -29,7 +35,16 @@ public:
         GarbageCollector::remove(starting_epoch);
     }
 
-    const Rec* read(TableID table_id, Key key) {
+    // Looks up keys in the index together, so that the cache misses of the lookups overlap (see
+    // MasstreeIndexes::multi_find), and stores the value of each key in vals (nullptr if it is
+    // not found). The read/write set is not modified. A value found is passed to read() or
+    // update() as found, so that its key is not looked up again.
+    void lookup(TableID table_id, const std::vector<Key>& keys, std::vector<Value*>& vals) {
+        vals.resize(keys.size());
+        Index::get_index().multi_find(table_id, keys.size(), keys.data(), vals.data());
+    }
+
+    const Rec* read(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO("READ (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
         Index& idx = Index::get_index();
         tables.insert(table_id);
@@ -37,8 +52,9 @@ public:
         auto rw_iter = rw_table.find(key);
         if (rw_iter == rw_table.end()) {
             // Abort if key is not found in table
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) {
                 return nullptr;  // abort
             }
@@ -83,9 +99,15 @@ public:
             typename Index::Result res = idx.find(table_id, key, val);
             if (res == Index::Result::OK) return nullptr;
 
-            // Get next key write lock
+            // Get next key write lock. Hash index tables have no next key to protect the missing
+            // key with, so they only take inserts while loading (see
+            // MasstreeIndexes::use_backend())
             Key next_key = 0;
             Value* next_value = nullptr;
+            if (!idx.is_ordered(table_id)) {
+                throw std::runtime_error(
+                    "hash index tables do not take inserts under concurrency control");
+            }
             res = idx.get_next_kv(table_id, key, next_key, next_value);
             assert(next_key != 0);
             assert(next_value != nullptr);
@@ -110,7 +132,7 @@ public:
             }
 
             // Unlock next key
-            next_value->rwl.unlock();
+            if (next_value) next_value->rwl.unlock();
 
             // Place record to modify into localset
             Rec* rec = MemoryAllocator::aligned_allocate(record_size);
@@ -134,7 +156,7 @@ public:
         }
     }
 
-    Rec* update(TableID table_id, Key key) {
+    Rec* update(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO("UPDATE (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
 
         const Schema& sch = Schema::get_schema();
@@ -147,8 +169,9 @@ public:
 
         if (rw_iter == rw_table.end()) {
             // Abort if not found in index
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) return nullptr;  // abort
 
             // Get write lock
@@ -207,7 +230,11 @@ public:
             if (res == Index::Result::NOT_FOUND) {
                 // Get next key write lock
                 Key next_key;
-                Value* next_value;
+                Value* next_value = nullptr;
+                if (!idx.is_ordered(table_id)) {
+                    throw std::runtime_error(
+                        "hash index tables do not take inserts under concurrency control");
+                }
                 res = idx.get_next_kv(table_id, key, next_key, next_value);
                 if (res != Index::Result::OK) return nullptr;
                 auto next_iter = rw_table.find(next_key);
@@ -229,7 +256,7 @@ public:
                     return nullptr;  // abort
                 }
                 // Unlock next key
-                next_value->rwl.unlock();
+                if (next_value) next_value->rwl.unlock();
                 // Place record to modify into localset
                 Rec* rec = MemoryAllocator::aligned_allocate(record_size);
                 rw_table.emplace_hint(
@@ -277,7 +304,7 @@ public:
 
     bool read_scan(
         TableID table_id, Key lkey, Key rkey, int64_t count, [[maybe_unused]] bool rev,
-        std::map<Key, Rec*>& kr_map) {
+        KRList& kr_list) {
         // no reverse scan in nowait
         if (rev == true) throw std::runtime_error("reverse scan not supported in nowait");
         LOG_INFO(
@@ -287,13 +314,14 @@ public:
 
         tables.insert(table_id);
         auto& rw_table = rws.get_table(table_id);
-        std::map<Key, Value*> kv_map;
+        ScanBuffer<typename Index::KVList> kv_buf;
+        auto& kv_list = kv_buf.get();
 
         [[maybe_unused]] typename Index::Result res;
-        res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_map);
+        res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_list);
         assert(res == Index::Result::OK);
 
-        for (auto& [key, val]: kv_map) {
+        for (auto& [key, val]: kv_list) {
             auto rw_iter = rw_table.find(key);
 
             if (rw_iter == rw_table.end()) {
@@ -303,15 +331,15 @@ public:
                 rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(nullptr, ReadWriteType::READ, false, val));
-                kr_map.emplace(key, val->rec);
+                kr_list.emplace_back(key, val->rec);
                 continue;
             }
 
             auto rwt = rw_iter->second.rwt;
             if (rwt == ReadWriteType::READ) {
-                kr_map.emplace(key, rw_iter->second.val->rec);
+                kr_list.emplace_back(key, rw_iter->second.val->rec);
             } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                kr_map.emplace(key, rw_iter->second.rec);
+                kr_list.emplace_back(key, rw_iter->second.rec);
             } else if (rwt == ReadWriteType::DELETE) {
                 return false;
             } else {
@@ -323,7 +351,7 @@ public:
 
     bool update_scan(
         TableID table_id, Key lkey, Key rkey, int64_t count, [[maybe_unused]] bool rev,
-        std::map<Key, Rec*>& kr_map) {
+        KRList& kr_list) {
         // no reverse scan in nowait
         if (rev == true) throw std::runtime_error("reverse scan not supported in nowait");
         LOG_INFO(
@@ -335,13 +363,14 @@ public:
         size_t record_size = sch.get_record_size(table_id);
         tables.insert(table_id);
         auto& rw_table = rws.get_table(table_id);
-        std::map<Key, Value*> kv_map;
+        ScanBuffer<typename Index::KVList> kv_buf;
+        auto& kv_list = kv_buf.get();
 
         [[maybe_unused]] typename Index::Result res;
-        res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_map);
+        res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_list);
         assert(res == Index::Result::OK);
 
-        for (auto& [key, val]: kv_map) {
+        for (auto& [key, val]: kv_list) {
             auto rw_iter = rw_table.find(key);
 
             if (rw_iter == rw_table.end()) {
@@ -353,7 +382,7 @@ public:
                 rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(rec, ReadWriteType::UPDATE, false, val));
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
                 continue;
             }
 
@@ -366,9 +395,9 @@ public:
                 memcpy(rec, rw_iter->second.val->rec, record_size);
                 rw_iter->second.rec = rec;
                 rw_iter->second.rwt = ReadWriteType::UPDATE;
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
             } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                kr_map.emplace(key, rw_iter->second.rec);
+                kr_list.emplace_back(key, rw_iter->second.rec);
             } else if (rwt == ReadWriteType::DELETE) {
                 return false;
             } else {
@@ -422,6 +451,7 @@ public:
 
     bool precommit() {
         LOG_INFO("PRECOMMIT, e: %u", starting_epoch);
+        PROFILE_PHASE(WRITE);
 
         Index& idx = Index::get_index();
 
@@ -459,6 +489,7 @@ public:
     }
 
     void abort() {
+        PROFILE_PHASE(ABORT);
         Index& idx = Index::get_index();
 
         for (TableID table_id: tables) {
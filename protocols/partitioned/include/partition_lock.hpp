@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+#include "utils/atomic_wrapper.hpp"
+
+/**
+ * One spin lock per partition. Partition ids are 1 to num_partitions.
+ * A lock is held by a transaction from its first access to the partition until it commits or
+ * aborts, so a worker that only accesses its own partition never contends with others.
+ * The locks are ticket locks: a transaction waiting in lock() gets the partition as soon as it is
+ * released, even if its holder aborted and immediately retries on it (see
+ * Partitioned::lock_partition()).
+ */
+class PartitionLocks {
+public:
+    void initialize(size_t num_partitions) {
+        locks = std::make_unique<Lock[]>(num_partitions + 1);
+        size = num_partitions;
+    }
+
+    void lock(uint32_t partition) {
+        Lock& l = get_lock(partition);
+        uint32_t ticket = fetch_add(l.next, 1);
+        while (load_acquire(l.serving) != ticket) {
+        }
+    }
+
+    bool try_lock(uint32_t partition) {
+        Lock& l = get_lock(partition);
+        uint32_t serving = load_acquire(l.serving);
+        uint32_t expected = serving;
+        return compare_exchange(l.next, expected, serving + 1);
+    }
+
+    void unlock(uint32_t partition) {
+        Lock& l = get_lock(partition);
+        store_release(l.serving, load(l.serving) + 1);
+    }
+
+    static PartitionLocks& get_partition_locks() {
+        static PartitionLocks pl;
+        return pl;
+    }
+
+private:
+    struct alignas(64) Lock {
+        uint32_t next = 0;     // ticket of the next transaction that locks the partition
+        uint32_t serving = 0;  // ticket of the holder, or of the next one if released
+    };
+
+    std::unique_ptr<Lock[]> locks;
+    size_t size = 0;
+
+    Lock& get_lock(uint32_t partition) {
+        if (partition == 0 || partition > size) throw std::runtime_error("invalid partition");
+        return locks[partition];
+    }
+};
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "indexes/index_interface.hpp"
+#include "protocols/common/epoch_manager.hpp"
+#include "protocols/common/scan_buffer.hpp"
+#include "protocols/common/transaction_arena.hpp"
+#include "protocols/partitioned/include/partition_lock.hpp"
+#include "protocols/partitioned/include/writeset.hpp"
+#include "utils/profiler.hpp"
+
+/**
+ * H-Store style execution: the database is split into partitions (warehouses in TPC-C), and a
+ * transaction locks each partition it accesses as a whole (lock_partition()) before touching
+ * its records. Records have no TidWord or lock and are read and modified in place; the before
+ * images of updated records are kept to roll back aborts. A worker executing transactions on
+ * its own partition thus pays one uncontended lock per transaction, while multi-partition
+ * transactions serialize with every transaction on the partitions they access.
+ * The caller maps records to partitions. Records outside of any partition (UNPARTITIONED) must
+ * be read-only.
+ */
+template <typename Index>
+class Partitioned {
+public:
+    static_assert(is_index_v<Index>, "Index must implement indexes/index_interface.hpp");
+    using Key = typename Index::Key;
+    using Value = typename Index::Value;
+    using KRList = std::vector<std::pair<Key, Rec*>>;  // results of scans in scan order
+
+    static constexpr uint32_t UNPARTITIONED = 0;
+
+    Partitioned(TxID txid, uint32_t epoch)
+        : txid(txid)
+        , starting_epoch(epoch) {
+        LOG_INFO("START Tx, e: %u", starting_epoch);
+        TransactionArena::reset();
+    }
+
+    ~Partitioned() {
+        unlock_partitions();
+        GarbageCollector::remove(starting_epoch);
+    }
+
+    // Partition locks are taken in increasing order of ids if possible. Waiting for a partition
+    // with a smaller id than one already held could deadlock, so the transaction aborts if that
+    // partition is locked.
+    bool lock_partition(uint32_t partition) {
+        if (partition == UNPARTITIONED) return true;
+        auto it = std::lower_bound(partitions.begin(), partitions.end(), partition);
+        if (it != partitions.end() && *it == partition) return true;
+        PartitionLocks& pl = PartitionLocks::get_partition_locks();
+        if (it == partitions.end()) {
+            pl.lock(partition);
+        } else if (!pl.try_lock(partition)) {
+            LOG_INFO("PARTITION LOCKED (e: %u, p: %u)", starting_epoch, partition);
+            return false;
+        }
+        partitions.insert(it, partition);
+        return true;
+    }
+
+    // Looks up keys in the index together, so that the cache misses of the lookups overlap (see
+    // MasstreeIndexes::multi_find), and stores the value of each key in vals (nullptr if it is
+    // not found). The read/write set is not modified. A value found is passed to read() or
+    // update() as found, so that its key is not looked up again.
+    void lookup(TableID table_id, const std::vector<Key>& keys, std::vector<Value*>& vals) {
+        vals.resize(keys.size());
+        Index::get_index().multi_find(table_id, keys.size(), keys.data(), vals.data());
+    }
+
+    const Rec* read(TableID table_id, Key key, Value* found = nullptr) {
+        LOG_INFO("READ (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+        auto& w_table = ws.get_table(table_id);
+        auto w_iter = w_table.find(key);
+        if (w_iter != w_table.end()) {
+            if (w_iter->second.wt == WriteType::DELETE) return nullptr;
+            return w_iter->second.val->rec;
+        }
+        Value* val = found;
+        typename Index::Result res =
+            val ? Index::Result::OK : Index::get_index().find(table_id, key, val);
+        if (res == Index::Result::NOT_FOUND) return nullptr;
+        return val->rec;
+    }
+
+    Rec* insert(TableID table_id, Key key) {
+        LOG_INFO("INSERT (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+
+        const Schema& sch = Schema::get_schema();
+        Index& idx = Index::get_index();
+
+        size_t record_size = sch.get_record_size(table_id);
+        tables.insert(table_id);
+        auto& w_table = ws.get_table(table_id);
+        auto w_iter = w_table.find(key);
+
+        if (w_iter == w_table.end()) {
+            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Value* val = reinterpret_cast<Value*>(MemoryAllocator::aligned_allocate(sizeof(Value)));
+            val->rec = rec;
+            typename Index::Result res = idx.insert(table_id, key, val);
+            if (res == Index::Result::NOT_INSERTED) {
+                MemoryAllocator::deallocate(val);
+                MemoryAllocator::deallocate(rec);
+                return nullptr;
+            }
+            w_table.emplace_hint(
+                w_iter, std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(nullptr, WriteType::INSERT, val));
+            return rec;
+        }
+
+        auto wt = w_iter->second.wt;
+        if (wt == WriteType::UPDATE || wt == WriteType::INSERT) {
+            return nullptr;
+        } else if (wt == WriteType::DELETE) {
+            // The deleted record is still in the index and is overwritten instead
+            if (!w_iter->second.before) {
+                w_iter->second.before = copy_before_image(table_id, w_iter->second.val->rec);
+            }
+            w_iter->second.wt = WriteType::UPDATE;
+            return w_iter->second.val->rec;
+        } else {
+            throw std::runtime_error("invalid state");
+        }
+    }
+
+    Rec* update(TableID table_id, Key key, Value* found = nullptr) {
+        LOG_INFO("UPDATE (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+
+        tables.insert(table_id);
+        auto& w_table = ws.get_table(table_id);
+        auto w_iter = w_table.find(key);
+
+        if (w_iter == w_table.end()) {
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : Index::get_index().find(table_id, key, val);
+            if (res == Index::Result::NOT_FOUND) return nullptr;
+            w_table.emplace_hint(
+                w_iter, std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(
+                    copy_before_image(table_id, val->rec), WriteType::UPDATE, val));
+            return val->rec;
+        }
+
+        auto wt = w_iter->second.wt;
+        if (wt == WriteType::UPDATE || wt == WriteType::INSERT) {
+            return w_iter->second.val->rec;
+        } else if (wt == WriteType::DELETE) {
+            return nullptr;
+        } else {
+            throw std::runtime_error("invalid state");
+        }
+    }
+
+    Rec* write(TableID table_id, Key key) {
+        LOG_INFO("WRITE (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+        return upsert(table_id, key);
+    }
+
+    Rec* upsert(TableID table_id, Key key) {
+        LOG_INFO("UPSERT (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+        auto& w_table = ws.get_table(table_id);
+        auto w_iter = w_table.find(key);
+        if (w_iter != w_table.end()) {
+            if (w_iter->second.wt == WriteType::DELETE) return insert(table_id, key);
+            return w_iter->second.val->rec;
+        }
+        Value* val;
+        typename Index::Result res = Index::get_index().find(table_id, key, val);
+        if (res == Index::Result::NOT_FOUND) return insert(table_id, key);
+        return update(table_id, key);
+    }
+
+    bool read_scan(
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse, KRList& kr_list) {
+        LOG_INFO(
+            "READ_SCAN (e: %u, t: %lu, lk: %lu, rk: %lu, c: %ld)", starting_epoch, table_id, lkey,
+            rkey, count);
+        scan(table_id, lkey, rkey, count, reverse, [&](Key key, Value* val) {
+            kr_list.emplace_back(key, val->rec);
+        });
+        return true;
+    }
+
+    bool update_scan(
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse, KRList& kr_list) {
+        LOG_INFO(
+            "UPDATE_SCAN (e: %u, t: %lu, lk: %lu, rk: %lu, c: %ld)", starting_epoch, table_id, lkey,
+            rkey, count);
+        tables.insert(table_id);
+        auto& w_table = ws.get_table(table_id);
+        scan(table_id, lkey, rkey, count, reverse, [&](Key key, Value* val) {
+            auto w_iter = w_table.find(key);
+            if (w_iter == w_table.end()) {
+                w_table.emplace_hint(
+                    w_iter, std::piecewise_construct, std::forward_as_tuple(key),
+                    std::forward_as_tuple(
+                        copy_before_image(table_id, val->rec), WriteType::UPDATE, val));
+            }
+            kr_list.emplace_back(key, val->rec);
+        });
+        return true;
+    }
+
+    const Rec* remove(TableID table_id, Key key) {
+        LOG_INFO("REMOVE (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+
+        Index& idx = Index::get_index();
+
+        tables.insert(table_id);
+        auto& w_table = ws.get_table(table_id);
+        auto w_iter = w_table.find(key);
+
+        if (w_iter == w_table.end()) {
+            // The record is removed from the index on commit
+            Value* val;
+            typename Index::Result res = idx.find(table_id, key, val);
+            if (res == Index::Result::NOT_FOUND) return nullptr;
+            w_table.emplace_hint(
+                w_iter, std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(nullptr, WriteType::DELETE, val));
+            return val->rec;
+        }
+
+        auto wt = w_iter->second.wt;
+        if (wt == WriteType::UPDATE) {
+            // The before image is kept in case of abort
+            w_iter->second.wt = WriteType::DELETE;
+            return w_iter->second.val->rec;
+        } else if (wt == WriteType::INSERT) {
+            Value* val = w_iter->second.val;
+            idx.remove(table_id, key);
+            GarbageCollector::collect(starting_epoch, val->rec);
+            GarbageCollector::collect(starting_epoch, val);
+            w_table.erase(w_iter);
+            return val->rec;
+        } else if (wt == WriteType::DELETE) {
+            return nullptr;
+        } else {
+            throw std::runtime_error("invalid state");
+        }
+    }
+
+    bool precommit() {
+        LOG_INFO("PRECOMMIT, e: %u", starting_epoch);
+        PROFILE_PHASE(WRITE);
+
+        Index& idx = Index::get_index();
+
+        // Updates and inserts are already in place
+        for (TableID table_id: tables) {
+            auto& w_table = ws.get_table(table_id);
+            for (auto w_iter = w_table.begin(); w_iter != w_table.end(); ++w_iter) {
+                if (w_iter->second.wt != WriteType::DELETE) continue;
+                Value* val = w_iter->second.val;
+                idx.remove(table_id, w_iter->first);
+                GarbageCollector::collect(starting_epoch, val->rec);
+                GarbageCollector::collect(starting_epoch, val);
+            }
+            w_table.clear();
+        }
+        tables.clear();
+        unlock_partitions();
+        return true;
+    }
+
+    void abort() {
+        PROFILE_PHASE(ABORT);
+        const Schema& sch = Schema::get_schema();
+        Index& idx = Index::get_index();
+
+        for (TableID table_id: tables) {
+            size_t record_size = sch.get_record_size(table_id);
+            auto& w_table = ws.get_table(table_id);
+            for (auto w_iter = w_table.begin(); w_iter != w_table.end(); ++w_iter) {
+                Value* val = w_iter->second.val;
+                if (w_iter->second.wt == WriteType::INSERT) {
+                    idx.remove(table_id, w_iter->first);
+                    GarbageCollector::collect(starting_epoch, val->rec);
+                    GarbageCollector::collect(starting_epoch, val);
+                } else if (w_iter->second.before) {
+                    memcpy(val->rec, w_iter->second.before, record_size);
+                }
+            }
+            w_table.clear();
+        }
+        tables.clear();
+        unlock_partitions();
+        TransactionArena::reset();
+    }
+
+private:
+    TxID txid;
+    uint32_t starting_epoch;
+    std::set<TableID> tables;
+    WriteSet<Key, Value> ws;
+    std::vector<uint32_t> partitions;  // locked by this transaction, sorted
+
+    void unlock_partitions() {
+        PartitionLocks& pl = PartitionLocks::get_partition_locks();
+        for (uint32_t partition: partitions) pl.unlock(partition);
+        partitions.clear();
+    }
+
+    Rec* copy_before_image(TableID table_id, const Rec* rec) {
+        size_t record_size = Schema::get_schema().get_record_size(table_id);
+        Rec* before = TransactionArena::allocate(record_size);
+        memcpy(before, rec, record_size);
+        return before;
+    }
+
+    // Calls f(key, val) for up to count records in the range that are not deleted by this
+    // transaction, in the order of the scan. Deleted records stay in the index until commit,
+    // so they are skipped and the scan asks for as many more records.
+    template <typename F>
+    void scan(TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse, F&& f) {
+        Index& idx = Index::get_index();
+        auto& w_table = ws.get_table(table_id);
+        int64_t scan_count = count == -1 ? -1 : count + static_cast<int64_t>(w_table.size());
+        ScanBuffer<typename Index::KVList> kv_buf;
+        auto& kv_list = kv_buf.get();
+        [[maybe_unused]] typename Index::Result res;
+        if (reverse) {
+            res = idx.get_kv_in_rev_range(table_id, lkey, rkey, scan_count, kv_list);
+        } else {
+            res = idx.get_kv_in_range(table_id, lkey, rkey, scan_count, kv_list);
+        }
+        assert(res == Index::Result::OK);
+
+        int64_t visited = 0;
+        auto visit = [&](Key key, Value* val) {
+            if (count != -1 && visited == count) return false;
+            auto w_iter = w_table.find(key);
+            if (w_iter != w_table.end() && w_iter->second.wt == WriteType::DELETE) return true;
+            f(key, val);
+            visited++;
+            return true;
+        };
+        for (auto& [key, val]: kv_list) {
+            if (!visit(key, val)) break;
+        }
+    }
+};
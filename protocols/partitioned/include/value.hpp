@@ -0,0 +1,6 @@
+#pragma once
+
+// Records are protected by the lock of their partition, so the index value is just the pointer
+struct Value {
+    void* rec;
+};
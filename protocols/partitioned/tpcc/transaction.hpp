@@ -0,0 +1,318 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <cassert>
+#include <vector>
+
+#include "benchmarks/tpcc/include/record_key.hpp"
+#include "benchmarks/tpcc/include/record_layout.hpp"
+#include "protocols/common/epoch_manager.hpp"
+#include "protocols/common/scan_buffer.hpp"
+#include "protocols/tpcc_common/record_misc.hpp"
+
+template <typename Protocol>
+class Transaction {
+public:
+    uint32_t thread_id = 0;
+
+    Transaction(Worker<Protocol>& worker)
+        : thread_id(worker.get_id())
+        , protocol(std::move(worker.begin_tx())) {}
+
+    ~Transaction() {}
+
+    void abort() { protocol->abort(); }
+
+    bool commit() {
+        if (protocol->precommit()) {
+            return true;
+        } else {
+            abort();
+            return false;
+        }
+    }
+
+    enum Result {
+        SUCCESS,
+        FAIL,  // e.g. not found, already exists
+        ABORT  // e.g. could not acquire lock/latch and no-wait-> system abort
+    };
+
+    // Do not use this function for read-modify-write.
+    // Use prepare_record_for_update() intead.
+    template <typename Record>
+    Result get_record(const Record*& rec_ptr, typename Record::Key rec_key) {
+        if (!lock_partition(rec_key)) return Result::ABORT;
+        rec_ptr = reinterpret_cast<const Record*>(
+            protocol->read(get_id<Record>(), rec_key.get_raw_key()));
+        return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+    }
+
+    // Same as get_record() for each of the n keys, but all keys are looked up in the index
+    // together first so that their cache misses overlap, and each record is then accessed with
+    // the value found instead of looking its key up again. Stops at the first key that does not
+    // succeed.
+    template <typename Record>
+    Result get_records_batch(
+        size_t n, const typename Record::Key* rec_keys, const Record** rec_ptrs) {
+        // Partitions are locked before the lookup, as in get_record()
+        for (size_t i = 0; i < n; i++) {
+            if (!lock_partition(rec_keys[i])) return Result::ABORT;
+        }
+        const auto& vals = lookup<Record>(n, rec_keys);
+        for (size_t i = 0; i < n; i++) {
+            rec_ptrs[i] = reinterpret_cast<const Record*>(
+                protocol->read(get_id<Record>(), rec_keys[i].get_raw_key(), vals[i]));
+            if (rec_ptrs[i] == nullptr) return Result::ABORT;
+        }
+        return Result::SUCCESS;
+    }
+
+    // Same as prepare_record_for_update() for each of the n keys, batched like
+    // get_records_batch(). A key given several times gets the same write set record each time.
+    template <typename Record>
+    Result prepare_records_for_update_batch(
+        size_t n, const typename Record::Key* rec_keys, Record** rec_ptrs) {
+        // Partitions are locked before the lookup, as in get_record()
+        for (size_t i = 0; i < n; i++) {
+            if (!lock_partition(rec_keys[i])) return Result::ABORT;
+        }
+        const auto& vals = lookup<Record>(n, rec_keys);
+        for (size_t i = 0; i < n; i++) {
+            rec_ptrs[i] = reinterpret_cast<Record*>(
+                protocol->update(get_id<Record>(), rec_keys[i].get_raw_key(), vals[i]));
+            if (rec_ptrs[i] == nullptr) return Result::ABORT;
+        }
+        return Result::SUCCESS;
+    }
+
+    Result prepare_record_for_insert(History*& rec_ptr) {
+        auto& t = get_history_table();
+        t.emplace_back();
+        rec_ptr = &(t.back());
+        return Result::SUCCESS;
+    }
+
+    template <typename Record>
+    Result prepare_record_for_insert(Record*& rec_ptr, typename Record::Key rec_key) {
+        if (!lock_partition(rec_key)) return Result::ABORT;
+        // rec_ptr points to the record in the index
+        rec_ptr =
+            reinterpret_cast<Record*>(protocol->insert(get_id<Record>(), rec_key.get_raw_key()));
+        return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+    }
+
+    template <typename Record>
+    Result finish_insert([[maybe_unused]] Record* rec_ptr) {
+        // secondary index insert
+        if constexpr (std::is_same<Record, Customer>::value || std::is_same<Record, Order>::value) {
+            Secondary<Record>* sec = nullptr;
+            auto sec_key = Secondary<Record>::Key::create_key(*rec_ptr);
+            Result res = prepare_record_for_insert(sec, sec_key);
+            if (res != Result::SUCCESS) return res;
+            *sec = Secondary<Record>(*rec_ptr);
+        }
+        return Result::SUCCESS;
+    }
+
+    // Get record and prepare for update.
+    template <typename Record>
+    Result prepare_record_for_update(Record*& rec_ptr, typename Record::Key rec_key) {
+        if (!lock_partition(rec_key)) return Result::ABORT;
+        // rec_ptr points to the record in the index, modified in place
+        rec_ptr =
+            reinterpret_cast<Record*>(protocol->update(get_id<Record>(), rec_key.get_raw_key()));
+        return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+    }
+
+    template <typename Record>
+    Result finish_update([[maybe_unused]] Record* rec_ptr) {
+        // Secondary index update is not needed in TPC-C
+        return Result::SUCCESS;
+    }
+
+    // No commutative writes: an add is a read-modify-write of the record
+    template <typename Record, typename T>
+    Result add_to_field(typename Record::Key rec_key, size_t offset, T delta) {
+        Record* rec_ptr = nullptr;
+        Result res = prepare_record_for_update(rec_ptr, rec_key);
+        if (res != Result::SUCCESS) return res;
+        *reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(rec_ptr) + offset) += delta;
+        return finish_update(rec_ptr);
+    }
+
+    template <typename Record>
+    Result get_record_ignoring_adds(const Record*& rec_ptr, typename Record::Key rec_key) {
+        return get_record(rec_ptr, rec_key);
+    }
+
+    template <typename Record>
+    Result prepare_record_for_delete(const Record*& rec_ptr, typename Record::Key rec_key) {
+        if (!lock_partition(rec_key)) return Result::ABORT;
+        rec_ptr = reinterpret_cast<const Record*>(
+            protocol->remove(get_id<Record>(), rec_key.get_raw_key()));
+        return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+    }
+
+    template <typename Record>
+    Result finish_delete([[maybe_unused]] Record* rec_ptr) {
+        // Secondary index delete is not needed in TPC-C
+        return Result::SUCCESS;
+    }
+
+    Result get_customer_by_last_name(
+        const Customer*& c, uint16_t w_id, uint8_t d_id, const char* c_last) {
+        uint32_t c_last_num = get_clast_number(c_last);
+        CustomerSecondary::Key c_sec_low_key =
+            CustomerSecondary::Key::create_key(w_id, d_id, c_last_num);
+        CustomerSecondary::Key c_sec_high_key =
+            CustomerSecondary::Key::create_key(w_id, d_id, c_last_num + 1);
+        if (!lock_partition(c_sec_low_key)) return Result::ABORT;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+        bool scanned = protocol->read_scan(
+            get_id<CustomerSecondary>(), c_sec_low_key.get_raw_key(),
+            c_sec_high_key.get_raw_key(), -1, false, kr_list);
+        if (!scanned) return Result::ABORT;
+
+        if (kr_list.empty()) {
+            c = nullptr;
+            return Result::FAIL;
+        }
+
+        const CustomerSecondary* c_sec = get_middle_customer(kr_list);
+        return get_record(c, c_sec->key);
+    }
+
+    Result get_customer_by_last_name_and_prepare_for_update(
+        Customer*& c, uint16_t w_id, uint8_t d_id, const char* c_last) {
+        const Customer* c_temp = nullptr;
+        Result res = get_customer_by_last_name(c_temp, w_id, d_id, c_last);
+        if (res != Result::SUCCESS) return res;
+
+        // prepare the record for update in place
+        Customer::Key c_key = Customer::Key::create_key(*c_temp);
+        return prepare_record_for_update(c, c_key);
+    }
+
+    Result get_order_by_customer_id(const Order*& o, uint16_t w_id, uint8_t d_id, uint32_t c_id) {
+        OrderSecondary::Key o_sec_low_key = OrderSecondary::Key::create_key(w_id, d_id, c_id, 0);
+        OrderSecondary::Key o_sec_high_key =
+            OrderSecondary::Key::create_key(w_id, d_id, c_id + 1, 0);
+        if (!lock_partition(o_sec_low_key)) return Result::ABORT;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+
+        bool scanned = protocol->read_scan(
+            get_id<OrderSecondary>(), o_sec_low_key.get_raw_key(), o_sec_high_key.get_raw_key(), -1,
+            false, kr_list);
+
+        if (scanned) {
+            auto iter = kr_list.rbegin();
+            assert(iter->second);
+            auto o_sec = reinterpret_cast<OrderSecondary*>(iter->second);
+            Order::Key o_key = o_sec->key;
+            return get_record(o, o_key);
+            assert(false);
+        }
+        return Result::ABORT;
+    }
+
+    Result get_neworder_with_smallest_key_no_less_than(const NewOrder*& no, NewOrder::Key low) {
+        if (!lock_partition(low)) return Result::ABORT;
+        // The scan stops at the end of the district so that other partitions are not read
+        NewOrder::Key up = NewOrder::Key::create_key(low.w_id, low.d_id + 1, 0);
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+        bool scanned = protocol->read_scan(
+            get_id<NewOrder>(), low.get_raw_key(), up.get_raw_key(), 1, false, kr_list);
+        if (scanned) {
+            for (auto& [k, r]: kr_list) {
+                assert(r);
+                NewOrder::Key nk(k);
+                if (nk.w_id == low.w_id && nk.d_id == low.d_id) {
+                    no = reinterpret_cast<NewOrder*>(r);
+                    return Result::SUCCESS;
+                } else {
+                    return Result::FAIL;
+                }
+                assert(false);
+            }
+            return Result::FAIL;
+        }
+        return Result::ABORT;
+    }
+
+    // [low ,up)
+    template <typename Record, typename Func>
+    Result range_query(typename Record::Key low, typename Record::Key up, Func&& func) {
+        // Ranges do not span warehouses
+        if (!lock_partition(low)) return Result::ABORT;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+        bool scanned = protocol->read_scan(
+            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_list);
+        if (scanned) {
+            for (auto& [k, r]: kr_list) {
+                assert(r);
+                Record* rec = reinterpret_cast<Record*>(r);
+                func(*rec);
+            }
+            return Result::SUCCESS;
+        } else {
+            return Result::ABORT;
+        }
+    }
+
+    // [low ,up)
+    template <typename Record, typename Func>
+    Result range_update(typename Record::Key low, typename Record::Key up, Func&& func) {
+        if (!lock_partition(low)) return Result::ABORT;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+        bool scanned = protocol->update_scan(
+            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_list);
+        Result res;
+        if (scanned) {
+            for (auto& [k, r]: kr_list) {
+                assert(r);
+                Record* rec = reinterpret_cast<Record*>(r);
+                func(*rec);
+                res = finish_update(rec);
+                if (res != Result::SUCCESS) return res;
+            }
+            return Result::SUCCESS;
+        } else {
+            return Result::ABORT;
+        }
+    }
+
+private:
+    std::unique_ptr<Protocol> protocol = nullptr;
+
+    // Values of the n keys found by one Protocol::lookup(), to be passed to read() and update()
+    template <typename Record>
+    const std::vector<typename Protocol::Value*>& lookup(
+        size_t n, const typename Record::Key* rec_keys) {
+        thread_local std::vector<typename Protocol::Key> keys;
+        thread_local std::vector<typename Protocol::Value*> vals;
+        keys.clear();
+        for (size_t i = 0; i < n; i++) keys.push_back(rec_keys[i].get_raw_key());
+        protocol->lookup(get_id<Record>(), keys, vals);
+        return vals;
+    }
+
+    // Warehouses are the partitions. The item table is read-only and not partitioned.
+    static uint32_t get_partition(const ItemKey&) { return Protocol::UNPARTITIONED; }
+    static uint32_t get_partition(const WarehouseKey& key) { return key.w_key; }
+    template <typename Key>
+    static uint32_t get_partition(const Key& key) {
+        return key.w_id;
+    }
+
+    template <typename Key>
+    bool lock_partition(const Key& key) {
+        return protocol->lock_partition(get_partition(key));
+    }
+};
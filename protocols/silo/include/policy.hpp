@@ -0,0 +1,29 @@
+#pragma once
+
+// Read and update policies of Silo (see docs/PROTOCOLS.md)
+// The executables pick them with -DSILO_READ_BY_COPY=ON and -DSILO_MODIFY_ORIGINAL=ON
+#ifndef SILO_READ_BY_COPY
+#    define SILO_READ_BY_COPY 0
+#endif
+#ifndef SILO_MODIFY_ORIGINAL
+#    define SILO_MODIFY_ORIGINAL 0
+#endif
+
+// A read returns the pointer to the shared record, which stays valid until the epoch GC retires
+// it. Only safe if records are never modified in place.
+struct ReadByPointer {};
+
+// A read copies the record into a transaction local buffer and retries until the copy is
+// consistent with an unlocked, unchanged TidWord (seqlock).
+struct ReadByCopy {};
+
+// An update installs a new copy of the record and the old one is retired through epoch GC.
+struct CopyOnWrite {
+    using DefaultReadPolicy = ReadByPointer;
+};
+
+// An update is buffered in a transaction local copy that is copied into the original record
+// while its TidWord is locked. Readers copy records out and retry if the TidWord changed.
+struct ModifyOriginal {
+    using DefaultReadPolicy = ReadByCopy;
+};
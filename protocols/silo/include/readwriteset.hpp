@@ -10,22 +10,30 @@
 
 using Rec = void;
 
-enum ReadWriteType { READ = 0, UPDATE, INSERT, DELETE };
+enum ReadWriteType { READ = 0, UPDATE, INSERT, DELETE, ADD };
 
 template <typename Value>
 struct ReadWriteElement {
-    ReadWriteElement(Rec* rec, const TidWord& tidword, ReadWriteType rwt, bool is_new, Value* val)
+    ReadWriteElement(
+        Rec* rec, const TidWord& tidword, ReadWriteType rwt, bool is_new, Value* val,
+        bool in_place = false)
         : rec(rec)
         , tw(tidword)
         , rwt(rwt)
         , is_new(is_new)
+        , in_place(in_place)
         , val(val){};
-    Rec* rec = nullptr;  // nullptr when rwt is READ or DELETE
+    Rec* rec = nullptr;  // nullptr when rwt is READ, DELETE or ADD
                          // points to local record when rwt is UPDATE or INSERT
     TidWord tw;          // tidword when the data is read first
     ReadWriteType rwt = READ;
-    bool is_new;  // if newly inserted
-    Value* val;   // pointer to index
+    bool is_new;    // if newly inserted
+    bool in_place;  // if rec is a transaction local buffer copied into the original on commit
+    Value* val;     // pointer to index
+    // READ or ADD whose reader ignores commutative fields: validated by comparing read_rec with
+    // the current record except for those fields when the tidword changed
+    bool ignores_adds = false;
+    const Rec* read_rec = nullptr;
 };
 
 template <typename Key, typename Value>
@@ -2,22 +2,42 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <set>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "indexes/index_interface.hpp"
 #include "protocols/common/epoch_manager.hpp"
+#include "protocols/common/scan_buffer.hpp"
 #include "protocols/common/schema.hpp"
+#include "protocols/common/slab_allocator.hpp"
+#include "protocols/common/transaction_arena.hpp"
+#include "protocols/silo/include/policy.hpp"
 #include "protocols/silo/include/readwriteset.hpp"
 #include "protocols/silo/include/tidword.hpp"
+#include "protocols/silo/include/value.hpp"
+#include "utils/coroutine.hpp"
+#include "utils/profiler.hpp"
 
-template <typename Index>
+template <
+    typename Index, typename UpdatePolicy = CopyOnWrite,
+    typename ReadPolicy = typename UpdatePolicy::DefaultReadPolicy>
 class Silo {
 public:
+    static_assert(is_index_v<Index>, "Index must implement indexes/index_interface.hpp");
     using Key = typename Index::Key;
     using Value = typename Index::Value;
+    using KRList = std::vector<std::pair<Key, Rec*>>;  // results of scans in scan order
+    static constexpr bool modify_original = std::is_same_v<UpdatePolicy, ModifyOriginal>;
+    static constexpr bool read_by_copy = std::is_same_v<ReadPolicy, ReadByCopy>;
+    static_assert(
+        !modify_original || read_by_copy, "records modified in place can only be read by copy");
+    static constexpr bool inlines_records = Value::INLINE_SIZE > 0;
     class NodeSet {
     public:
         typename Index::NodeMap& get_nodemap(TableID table_id) { return ns[table_id]; }
@@ -30,11 +50,44 @@ public:
         : txid(txid)
         , starting_epoch(epoch) {
         LOG_INFO("START Tx, e: %u", starting_epoch);
+        TransactionArena::reset();
     }
 
     ~Silo() { GarbageCollector::remove(starting_epoch); }
 
-    const Rec* read(TableID table_id, Key key) {
+    // Looks up keys in the index together, so that the cache misses of the lookups overlap (see
+    // MasstreeIndexes::multi_find), and stores the value of each key in vals (nullptr if it is
+    // not found). The read/write set is not modified. A value found is passed to read() or
+    // update() as found, so that its key is not looked up again. In the coroutine mode, the
+    // values and records found are then fetched as by fetch().
+    MaybeTask<void> lookup(
+        TableID table_id, const std::vector<Key>& keys, std::vector<Value*>& vals) {
+        vals.resize(keys.size());
+        Index::get_index().multi_find(table_id, keys.size(), keys.data(), vals.data());
+#if COROUTINES
+        co_await fetch_records(table_id, vals.data(), vals.size());
+#endif
+    }
+
+#if COROUTINES
+    // Looks key up for read() or update() while the transaction suspends on the misses of the
+    // index (MasstreeIndexes::find_interleaved), then prefetches the value and the record found
+    // and suspends until they are fetched, so that the access itself hits the cache. Returns
+    // the value to pass to them as found, or nullptr if key is not found or already in the
+    // read/write set.
+    Task<Value*> fetch(TableID table_id, Key key) {
+        auto& rw_table = rws.get_table(table_id);
+        if (rw_table.find(key) != rw_table.end()) co_return nullptr;
+        Value* val = nullptr;
+        typename Index::Result res =
+            co_await Index::get_index().find_interleaved(table_id, key, val);
+        if (res != Index::Result::OK) co_return nullptr;
+        co_await fetch_records(table_id, &val, 1);
+        co_return val;
+    }
+#endif
+
+    const Rec* read(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO("READ (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
 
         Index& idx = Index::get_index();
@@ -45,13 +98,14 @@ public:
 
         if (rw_iter == rw_table.end()) {
             // Abort if key is not found in index
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val, nm);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val, nm);
             if (res == Index::Result::NOT_FOUND) return nullptr;
             // Read record pointer and tidword from index
             Rec* rec = nullptr;
             TidWord tw;
-            get_record_pointer(*val, rec, tw);
+            read_record(table_id, *val, rec, tw);
             // Null check
             if (!is_readable(tw)) return nullptr;
             rw_table.emplace_hint(
@@ -60,13 +114,15 @@ public:
             return rec;
         }
 
+        if (!materialize_adds(table_id, key, rw_iter->second)) return nullptr;
         auto rwt = rw_iter->second.rwt;
         if (rwt == ReadWriteType::READ) {
             // Read record poitner and tidword from index
             Rec* rec = nullptr;
             TidWord tw;
-            get_record_pointer(*(rw_iter->second.val), rec, tw);
+            read_record(table_id, *(rw_iter->second.val), rec, tw);
             if (!is_same(tw, rw_iter->second.tw)) return nullptr;
+            rw_iter->second.ignores_adds = false;
             return rec;
         } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
             if (!is_tidword_latest(*(rw_iter->second.val), rw_iter->second.tw)) return nullptr;
@@ -81,11 +137,9 @@ public:
     Rec* insert(TableID table_id, Key key) {
         LOG_INFO("INSERT (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
 
-        const Schema& sch = Schema::get_schema();
         Index& idx = Index::get_index();
 
         tables.insert(table_id);
-        size_t record_size = sch.get_record_size(table_id);
         auto& rw_table = rws.get_table(table_id);
         auto rw_iter = rw_table.find(key);
         auto& nm = ns.get_nodemap(table_id);
@@ -108,10 +162,12 @@ public:
                 return nullptr;  // abort
             }
 
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_insert_buffer(table_id);
             auto new_iter = rw_table.emplace_hint(
                 rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
-                std::forward_as_tuple(rec, new_val->tidword, ReadWriteType::INSERT, true, new_val));
+                std::forward_as_tuple(
+                    rec, new_val->tidword, ReadWriteType::INSERT, true, new_val,
+                    is_inlined<Value>(table_id)));
 
             auto& w_table = ws.get_table(table_id);
             w_table.emplace_back(key, new_iter);
@@ -123,23 +179,24 @@ public:
 
         auto rwt = rw_iter->second.rwt;
         if (rwt == ReadWriteType::READ || rwt == ReadWriteType::UPDATE
-            || rwt == ReadWriteType::INSERT) {
+            || rwt == ReadWriteType::INSERT || rwt == ReadWriteType::ADD) {
             return nullptr;
         } else if (rwt == ReadWriteType::DELETE) {
             assert(rw_iter->second.rec == nullptr);
             // Check if tidword stored locally is the latest
             if (!is_tidword_latest(*(rw_iter->second.val), rw_iter->second.tw)) return nullptr;
             // Allocate memory for write
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             rw_iter->second.rec = rec;
             rw_iter->second.rwt = ReadWriteType::UPDATE;
+            rw_iter->second.in_place = writes_in_place(table_id);
             return rec;
         } else {
             throw std::runtime_error("invalid state");
         }
     }
 
-    Rec* update(TableID table_id, Key key) {
+    Rec* update(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO("UPDATE (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
 
         const Schema& sch = Schema::get_schema();
@@ -152,42 +209,46 @@ public:
 
         if (rw_iter == rw_table.end()) {
             // Abort if key not found in index
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) return nullptr;
             // Copy record and tidword from index
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             TidWord tw;
             copy_record(*val, rec, tw, record_size);
             // Null check
             if (!is_readable(tw)) {
-                MemoryAllocator::deallocate(rec);
+                release_write_buffer(table_id, rec);
                 return nullptr;
             }
             // Place it in readwrite set
             auto new_iter = rw_table.emplace_hint(
                 rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
-                std::forward_as_tuple(rec, tw, ReadWriteType::UPDATE, false, val));
+                std::forward_as_tuple(
+                    rec, tw, ReadWriteType::UPDATE, false, val, writes_in_place(table_id)));
             // Place it in write set
             auto& w_table = ws.get_table(table_id);
             w_table.emplace_back(key, new_iter);
             return rec;
         }
 
+        if (!materialize_adds(table_id, key, rw_iter->second)) return nullptr;
         auto rwt = rw_iter->second.rwt;
         if (rwt == ReadWriteType::READ) {
             assert(rw_iter->second.rec == nullptr);
             // Local set will point to allocated record
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             TidWord tw;
             copy_record(*rw_iter->second.val, rec, tw, record_size);
             // Check if tidword stored locally is the latest
             if (!is_same(tw, rw_iter->second.tw)) {
-                MemoryAllocator::deallocate(rec);
+                release_write_buffer(table_id, rec);
                 return nullptr;
             }
             rw_iter->second.rec = rec;
             rw_iter->second.rwt = ReadWriteType::UPDATE;
+            rw_iter->second.in_place = writes_in_place(table_id);
             // Place it in writeset
             auto& w_table = ws.get_table(table_id);
             w_table.emplace_back(key, rw_iter);
@@ -234,11 +295,12 @@ public:
                     return nullptr;  // abort
                 }
 
-                Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+                Rec* rec = allocate_insert_buffer(table_id);
                 auto new_iter = rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(
-                        rec, new_val->tidword, ReadWriteType::INSERT, true, new_val));
+                        rec, new_val->tidword, ReadWriteType::INSERT, true, new_val,
+                        is_inlined<Value>(table_id)));
 
                 auto& w_table = ws.get_table(table_id);
                 w_table.emplace_back(key, new_iter);
@@ -249,18 +311,19 @@ public:
             } else if (res == Index::Result::OK) {
                 // Update if found in index
                 // Copy record and tidword from index
-                Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+                Rec* rec = allocate_write_buffer(table_id);
                 TidWord tw;
                 copy_record(*val, rec, tw, record_size);
                 // Null check
                 if (!is_readable(tw)) {
-                    MemoryAllocator::deallocate(rec);
+                    release_write_buffer(table_id, rec);
                     return nullptr;
                 }
                 // Place it in readwrite set
                 auto new_iter = rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
-                    std::forward_as_tuple(rec, tw, ReadWriteType::INSERT, false, val));
+                    std::forward_as_tuple(
+                        rec, tw, ReadWriteType::INSERT, false, val, writes_in_place(table_id)));
                 // Place it in write set
                 auto& w_table = ws.get_table(table_id);
                 w_table.emplace_back(key, new_iter);
@@ -271,21 +334,23 @@ public:
             }
         }
 
+        if (!materialize_adds(table_id, key, rw_iter->second)) return nullptr;
         auto rwt = rw_iter->second.rwt;
         if (rwt == ReadWriteType::READ) {
             assert(rw_iter->second.rec == nullptr);
             // Local set will point to allocated record
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             TidWord tw;
             copy_record(*rw_iter->second.val, rec, tw, record_size);
 
             // Check if tidword stored locally is the latest
             if (!is_same(tw, rw_iter->second.tw)) {
-                MemoryAllocator::deallocate(rec);
+                release_write_buffer(table_id, rec);
                 return nullptr;
             }
             rw_iter->second.rec = rec;
             rw_iter->second.rwt = ReadWriteType::UPDATE;
+            rw_iter->second.in_place = writes_in_place(table_id);
 
             // Place it in writeset
             auto& w_table = ws.get_table(table_id);
@@ -301,9 +366,10 @@ public:
             // Check if tidword stored locally is the latest
             if (!is_tidword_latest(*(rw_iter->second.val), rw_iter->second.tw)) return nullptr;
             // Allocate memory for write
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             rw_iter->second.rec = rec;
             rw_iter->second.rwt = ReadWriteType::UPDATE;
+            rw_iter->second.in_place = writes_in_place(table_id);
             return rec;
         } else {
             throw std::runtime_error("invalid state");
@@ -341,11 +407,12 @@ public:
                     return nullptr;  // abort
                 }
 
-                Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+                Rec* rec = allocate_insert_buffer(table_id);
                 auto new_iter = rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(
-                        rec, new_val->tidword, ReadWriteType::INSERT, true, new_val));
+                        rec, new_val->tidword, ReadWriteType::INSERT, true, new_val,
+                        is_inlined<Value>(table_id)));
 
                 auto& w_table = ws.get_table(table_id);
                 w_table.emplace_back(key, new_iter);
@@ -356,18 +423,19 @@ public:
             } else if (res == Index::Result::OK) {
                 // Update if found in index
                 // Copy record and tidword from index
-                Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+                Rec* rec = allocate_write_buffer(table_id);
                 TidWord tw;
                 copy_record(*val, rec, tw, record_size);
                 // Null check
                 if (!is_readable(tw)) {
-                    MemoryAllocator::deallocate(rec);
+                    release_write_buffer(table_id, rec);
                     return nullptr;
                 }
                 // Place it in readwrite set
                 auto new_iter = rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
-                    std::forward_as_tuple(rec, tw, ReadWriteType::UPDATE, false, val));
+                    std::forward_as_tuple(
+                        rec, tw, ReadWriteType::UPDATE, false, val, writes_in_place(table_id)));
                 // Place it in write set
                 auto& w_table = ws.get_table(table_id);
                 w_table.emplace_back(key, new_iter);
@@ -378,21 +446,23 @@ public:
             }
         }
 
+        if (!materialize_adds(table_id, key, rw_iter->second)) return nullptr;
         auto rwt = rw_iter->second.rwt;
         if (rwt == ReadWriteType::READ) {
             assert(rw_iter->second.rec == nullptr);
             // Local set will point to allocated record
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             TidWord tw;
             copy_record(*rw_iter->second.val, rec, tw, record_size);
 
             // Check if tidword stored locally is the latest
             if (!is_same(tw, rw_iter->second.tw)) {
-                MemoryAllocator::deallocate(rec);
+                release_write_buffer(table_id, rec);
                 return nullptr;
             }
             rw_iter->second.rec = rec;
             rw_iter->second.rwt = ReadWriteType::UPDATE;
+            rw_iter->second.in_place = writes_in_place(table_id);
 
             // Place it in writeset
             auto& w_table = ws.get_table(table_id);
@@ -408,18 +478,131 @@ public:
             // Check if tidword stored locally is the latest
             if (!is_tidword_latest(*(rw_iter->second.val), rw_iter->second.tw)) return nullptr;
             // Allocate memory for write
-            Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+            Rec* rec = allocate_write_buffer(table_id);
             rw_iter->second.rec = rec;
             rw_iter->second.rwt = ReadWriteType::UPDATE;
+            rw_iter->second.in_place = writes_in_place(table_id);
             return rec;
         } else {
             throw std::runtime_error("invalid state");
         }
     }
 
+    // Like read(), but the commutative fields (Schema::add_commutative_field()) of the returned
+    // record are not validated, so that concurrent adds to them do not abort the transaction
+    const Rec* read_ignoring_adds(TableID table_id, Key key, Value* found = nullptr) {
+        LOG_INFO("READ_IGNORING_ADDS (e: %u, t: %lu, k: %lu)", starting_epoch, table_id, key);
+
+        Index& idx = Index::get_index();
+        tables.insert(table_id);
+        auto& rw_table = rws.get_table(table_id);
+        auto rw_iter = rw_table.find(key);
+        auto& nm = ns.get_nodemap(table_id);
+
+        if (rw_iter == rw_table.end()) {
+            // Abort if key is not found in index
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val, nm);
+            if (res == Index::Result::NOT_FOUND) return nullptr;
+            Rec* rec = nullptr;
+            TidWord tw;
+            read_snapshot(table_id, *val, rec, tw);
+            if (!is_readable(tw)) return nullptr;
+            auto new_iter = rw_table.emplace_hint(
+                rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(nullptr, tw, ReadWriteType::READ, false, val));
+            new_iter->second.ignores_adds = true;
+            new_iter->second.read_rec = rec;
+            return rec;
+        }
+
+        auto& rwe = rw_iter->second;
+        if (rwe.rwt == ReadWriteType::ADD || (rwe.rwt == ReadWriteType::READ && rwe.ignores_adds)) {
+            if (rwe.read_rec) return rwe.read_rec;
+            // First read of a record the transaction has only added to
+            Rec* rec = nullptr;
+            TidWord tw;
+            read_snapshot(table_id, *rwe.val, rec, tw);
+            if (!is_readable(tw)) return nullptr;
+            rwe.tw = tw;
+            rwe.ignores_adds = true;
+            rwe.read_rec = rec;
+            return rec;
+        }
+        return read(table_id, key);
+    }
+
+    // Adds delta to the field at offset of the record without reading it. The delta is applied
+    // to the latest version while the record is locked on commit, so that concurrent adds
+    // commute instead of invalidating each other. Reads of the record through anything but
+    // read_ignoring_adds() still see (and validate) the adds.
+    template <typename T>
+    bool add(TableID table_id, Key key, size_t offset, T delta) {
+        static_assert(
+            std::is_arithmetic_v<T> && sizeof(T) <= sizeof(uint64_t), "unsupported field type");
+        LOG_INFO("ADD (e: %u, t: %lu, k: %lu, o: %lu)", starting_epoch, table_id, key, offset);
+
+        if (!Schema::get_schema().is_commutative_field(table_id, offset, sizeof(T))) {
+            throw std::runtime_error("field is not commutative");
+        }
+        Index& idx = Index::get_index();
+
+        tables.insert(table_id);
+        auto& rw_table = rws.get_table(table_id);
+        auto rw_iter = rw_table.find(key);
+        Addend a{table_id, key, offset, &add_field<T>, 0};
+        memcpy(&a.delta, &delta, sizeof(T));
+
+        if (rw_iter == rw_table.end()) {
+            // Abort if key not found in index
+            Value* val;
+            typename Index::Result res = idx.find(table_id, key, val);
+            if (res == Index::Result::NOT_FOUND) return false;
+            // Only the existence of the record is checked
+            Rec* rec = nullptr;
+            TidWord tw;
+            get_record_pointer(*val, rec, tw);
+            if (!is_readable(tw)) return false;
+            auto new_iter = rw_table.emplace_hint(
+                rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple(
+                    nullptr, tw, ReadWriteType::ADD, false, val, writes_in_place(table_id)));
+            auto& w_table = ws.get_table(table_id);
+            w_table.emplace_back(key, new_iter);
+            addends.push_back(a);
+            return true;
+        }
+
+        auto rwt = rw_iter->second.rwt;
+        if (rwt == ReadWriteType::ADD) {
+            addends.push_back(a);
+            return true;
+        } else if (rwt == ReadWriteType::READ && rw_iter->second.ignores_adds) {
+            // Keeps validating the read except for the commutative fields
+            rw_iter->second.rwt = ReadWriteType::ADD;
+            rw_iter->second.in_place = writes_in_place(table_id);
+            auto& w_table = ws.get_table(table_id);
+            w_table.emplace_back(key, rw_iter);
+            addends.push_back(a);
+            return true;
+        } else if (
+            rwt == ReadWriteType::READ || rwt == ReadWriteType::UPDATE
+            || rwt == ReadWriteType::INSERT) {
+            // The transaction has seen the field, so the add goes to its local copy
+            Rec* rec = update(table_id, key);
+            if (rec == nullptr) return false;
+            a.apply(static_cast<uint8_t*>(rec) + offset, a.delta);
+            return true;
+        } else if (rwt == ReadWriteType::DELETE) {
+            return false;
+        } else {
+            throw std::runtime_error("invalid state");
+        }
+    }
+
     bool read_scan(
-        TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse,
-        std::map<Key, Rec*>& kr_map) {
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse, KRList& kr_list) {
         LOG_INFO(
             "READ_SCAN (e: %u, t: %lu, lk: %lu, rk: %lu, c: %ld)", starting_epoch, table_id, lkey,
             rkey, count);
@@ -429,44 +612,47 @@ public:
         auto& rw_table = rws.get_table(table_id);
         auto& nm = ns.get_nodemap(table_id);
 
-        std::map<Key, Value*> kv_map;
+        ScanBuffer<typename Index::KVList> kv_buf;
+        auto& kv_list = kv_buf.get();
         typename Index::Result res;
         if (reverse) {
-            res = idx.get_kv_in_rev_range(table_id, lkey, rkey, count, kv_map, nm);
+            res = idx.get_kv_in_rev_range(table_id, lkey, rkey, count, kv_list, nm);
         } else {
-            res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_map, nm);
+            res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_list, nm);
         }
         if (res == Index::Result::BAD_SCAN) return false;
 
-        for (auto& [key, val]: kv_map) {
+        for (auto& [key, val]: kv_list) {
             auto rw_iter = rw_table.find(key);
 
             if (rw_iter == rw_table.end()) {
                 // Read record pointer and tidword from index
                 Rec* rec = nullptr;
                 TidWord tw;
-                get_record_pointer(*val, rec, tw);
+                read_record(table_id, *val, rec, tw);
                 // Null check
                 if (!is_readable(tw)) return false;
                 // Place it into readwrite set
                 rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(nullptr, tw, ReadWriteType::READ, false, val));
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
                 continue;
             }
 
+            if (!materialize_adds(table_id, key, rw_iter->second)) return false;
             auto rwt = rw_iter->second.rwt;
             if (rwt == ReadWriteType::READ) {
                 // Read record poitner and tidword from index
                 Rec* rec = nullptr;
                 TidWord tw;
-                get_record_pointer(*(rw_iter->second.val), rec, tw);
+                read_record(table_id, *(rw_iter->second.val), rec, tw);
                 if (!is_same(tw, rw_iter->second.tw)) return false;
-                kr_map.emplace(key, rec);
+                rw_iter->second.ignores_adds = false;
+                kr_list.emplace_back(key, rec);
             } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
                 if (!is_tidword_latest(*(rw_iter->second.val), rw_iter->second.tw)) return false;
-                kr_map.emplace(key, rw_iter->second.rec);
+                kr_list.emplace_back(key, rw_iter->second.rec);
             } else if (rwt == ReadWriteType::DELETE) {
                 return false;
             } else {
@@ -477,8 +663,7 @@ public:
     }
 
     bool update_scan(
-        TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse,
-        std::map<Key, Rec*>& kr_map) {
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool reverse, KRList& kr_list) {
         LOG_INFO(
             "UPDATE_SCAN (e: %u, t: %lu, lk: %lu, rk: %lu, c: %ld)", starting_epoch, table_id, lkey,
             rkey, count);
@@ -491,60 +676,64 @@ public:
         auto& rw_table = rws.get_table(table_id);
         auto& nm = ns.get_nodemap(table_id);
 
-        std::map<Key, Value*> kv_map;
+        ScanBuffer<typename Index::KVList> kv_buf;
+        auto& kv_list = kv_buf.get();
         typename Index::Result res;
         if (reverse) {
-            res = idx.get_kv_in_rev_range(table_id, lkey, rkey, count, kv_map, nm);
+            res = idx.get_kv_in_rev_range(table_id, lkey, rkey, count, kv_list, nm);
         } else {
-            res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_map, nm);
+            res = idx.get_kv_in_range(table_id, lkey, rkey, count, kv_list, nm);
         }
         if (res == Index::Result::BAD_SCAN) return false;
 
-        for (auto& [key, val]: kv_map) {
+        for (auto& [key, val]: kv_list) {
             auto rw_iter = rw_table.find(key);
 
             if (rw_iter == rw_table.end()) {
                 // Copy record and tidword from index
-                Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+                Rec* rec = allocate_write_buffer(table_id);
                 TidWord tw;
                 copy_record(*val, rec, tw, record_size);
                 // Null check
                 if (!is_readable(tw)) {
-                    MemoryAllocator::deallocate(rec);
+                    release_write_buffer(table_id, rec);
                     return false;
                 }
                 // Place it in readwrite set
                 auto new_iter = rw_table.emplace_hint(
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
-                    std::forward_as_tuple(rec, tw, ReadWriteType::UPDATE, false, val));
+                    std::forward_as_tuple(
+                        rec, tw, ReadWriteType::UPDATE, false, val, writes_in_place(table_id)));
                 // Place it in write set
                 auto& w_table = ws.get_table(table_id);
                 w_table.emplace_back(key, new_iter);
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
                 continue;
             }
 
+            if (!materialize_adds(table_id, key, rw_iter->second)) return false;
             auto rwt = rw_iter->second.rwt;
             if (rwt == ReadWriteType::READ) {
                 assert(rw_iter->second.rec == nullptr);
                 // Local set will point to allocated record
-                Rec* rec = MemoryAllocator::aligned_allocate(record_size);
+                Rec* rec = allocate_write_buffer(table_id);
                 TidWord tw;
                 copy_record(*rw_iter->second.val, rec, tw, record_size);
                 // Check if tidword stored locally is the latest
                 if (!is_same(tw, rw_iter->second.tw)) {
-                    MemoryAllocator::deallocate(rec);
+                    release_write_buffer(table_id, rec);
                     return false;
                 }
                 rw_iter->second.rec = rec;
                 rw_iter->second.rwt = ReadWriteType::UPDATE;
+                rw_iter->second.in_place = writes_in_place(table_id);
                 // Place it in writeset
                 auto& w_table = ws.get_table(table_id);
                 w_table.emplace_back(key, rw_iter);
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
             } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
                 if (!is_tidword_latest(*(rw_iter->second.val), rw_iter->second.tw)) return false;
-                kr_map.emplace(key, rw_iter->second.rec);
+                kr_list.emplace_back(key, rw_iter->second.rec);
             } else if (rwt == ReadWriteType::DELETE) {
                 assert(rw_iter->second.rec == nullptr);
                 return false;
@@ -573,7 +762,7 @@ public:
             // Read record pointer and tidword from index
             Rec* rec = nullptr;
             TidWord tw;
-            get_record_pointer(*val, rec, tw);
+            read_record(table_id, *val, rec, tw);
 
             // Null check
             if (!is_readable(tw)) return nullptr;
@@ -587,13 +776,14 @@ public:
             return rec;
         }
 
+        if (!materialize_adds(table_id, key, rw_iter->second)) return nullptr;
         auto rwt = rw_iter->second.rwt;
         if (rwt == ReadWriteType::READ) {
             assert(rw_iter->second.rec == nullptr);
             // Read record pointer and tidword from index
             Rec* rec = nullptr;
             TidWord tw;
-            get_record_pointer(*(rw_iter->second.val), rec, tw);
+            read_record(table_id, *(rw_iter->second.val), rec, tw);
             // Check if tidword stored locally is the latest
             if (!is_same(tw, rw_iter->second.tw)) return nullptr;
             // Place it in writeset
@@ -605,12 +795,13 @@ public:
             // Read record pointer and tidword from index
             Rec* rec = nullptr;
             TidWord tw;
-            get_record_pointer(*(rw_iter->second.val), rec, tw);
+            read_record(table_id, *(rw_iter->second.val), rec, tw);
             // Check if tidword stored locally is the latest
             if (!is_same(tw, rw_iter->second.tw)) return nullptr;
             // Deallocate locally allocated record
-            MemoryAllocator::deallocate(rw_iter->second.rec);
+            release_local_record(table_id, rw_iter->second);
             rw_iter->second.rec = nullptr;
+            rw_iter->second.in_place = false;
             rw_iter->second.rwt = ReadWriteType::DELETE;
             return rec;
         } else if (rwt == ReadWriteType::DELETE) {
@@ -623,12 +814,14 @@ public:
     bool precommit() {
         LOG_INFO("PRECOMMIT, e: %u", starting_epoch);
 
+        const Schema& sch = Schema::get_schema();
         Index& idx = Index::get_index();
 
         TidWord commit_tw;
         commit_tw.obj = 0;
 
         LOG_INFO("  P1 (Lock WriteSet)");
+        PROFILE_PHASE(LOCK);
 
         for (TableID table_id: tables) {
             auto& w_table = ws.get_table(table_id);
@@ -650,21 +843,31 @@ public:
             }
         }
 
-        commit_tw.epoch = load_acquire(EpochManager<Silo<Index>>::get_global_epoch());
+        commit_tw.epoch = load_acquire(EpochManager<Silo>::get_global_epoch());
         LOG_INFO("  SERIAL POINT (se: %u, ce: %lu)", starting_epoch, commit_tw.epoch);
 
         // Phase 2.1 (Validate ReadSet)
         LOG_INFO("  P2.1 (Validate ReadSet)");
+        PROFILE_PHASE(VALIDATE);
         for (TableID table_id: tables) {
             auto& rw_table = rws.get_table(table_id);
             for (auto rw_iter = rw_table.begin(); rw_iter != rw_table.end(); ++rw_iter) {
                 auto rwt = rw_iter->second.rwt;
                 if (rwt == ReadWriteType::INSERT) continue;
-                // rwt is either READ or UPDATE or DELETE
+                bool ignores_adds = rw_iter->second.ignores_adds
+                    && (rwt == ReadWriteType::READ || rwt == ReadWriteType::ADD);
+                if (rwt == ReadWriteType::ADD && !ignores_adds) continue;  // not read
+                // rwt is either READ or UPDATE or DELETE, or ADD to a record that was read
                 TidWord current, expected;
                 current.obj = load_acquire(rw_iter->second.val->tidword.obj);
                 expected.obj = rw_iter->second.tw.obj;
-                if (!is_valid(current, expected) || (current.lock && rwt == ReadWriteType::READ)) {
+                if (ignores_adds) {
+                    if (!is_valid_ignoring_adds(table_id, rw_iter->second, current)) {
+                        unlock_writeset();
+                        return false;
+                    }
+                } else if (
+                    !is_valid(current, expected) || (current.lock && rwt == ReadWriteType::READ)) {
                     unlock_writeset();
                     return false;
                 }
@@ -678,6 +881,7 @@ public:
 
         // Phase 2.2 (Validate NodeSet)
         LOG_INFO("  P2.2 (Validate NodeSet) ");
+        PROFILE_PHASE(VALIDATE_NODE);
         for (TableID table_id: tables) {
             auto& nm = ns.get_nodemap(table_id);
             for (auto iter = nm.begin(); iter != nm.end(); ++iter) {
@@ -694,12 +898,37 @@ public:
 
         // Phase 3 (Write to Shared Memory)
         LOG_INFO("  P3 (Write to Shared Memory)");
+        PROFILE_PHASE(WRITE);
         for (TableID table_id: tables) {
             auto& w_table = ws.get_table(table_id);
+            size_t record_size = sch.get_record_size(table_id);
+            bool inlined = is_inlined<Value>(table_id);
             for (auto w_iter = w_table.begin(); w_iter != w_table.end(); ++w_iter) {
                 auto rw_iter = w_iter->second;
                 auto rwt = rw_iter->second.rwt;
-                Rec* old = exchange(rw_iter->second.val->rec, rw_iter->second.rec);
+                Rec* old = nullptr;
+                if (rwt == ReadWriteType::ADD) {
+                    // The record is locked, so the adds go to its latest version
+                    Value* val = rw_iter->second.val;
+                    if (rw_iter->second.in_place) {
+                        Rec* rec = inlined ? val->get_payload() : val->rec;
+                        apply_adds(table_id, w_iter->first, rec);
+                    } else {
+                        Rec* rec = SlabAllocator::allocate(table_id);
+                        memcpy(rec, val->rec, record_size);
+                        apply_adds(table_id, w_iter->first, rec);
+                        old = exchange(val->rec, rec);
+                    }
+                } else if (rw_iter->second.in_place) {
+                    // Concurrent readers see the lock and retry in copy_record()
+                    Value* val = rw_iter->second.val;
+                    Rec* dst = inlined ? val->get_payload() : val->rec;
+                    memcpy(dst, rw_iter->second.rec, record_size);
+                    if (inlined) store_release(val->rec, dst);  // newly inserted records
+                } else {
+                    old = exchange(rw_iter->second.val->rec, rw_iter->second.rec);
+                    if (inlined) old = nullptr;  // deleted, the payload goes with the value
+                }
                 TidWord new_tw;
                 new_tw.epoch = commit_tw.epoch;
                 new_tw.tid = commit_tw.tid;
@@ -707,7 +936,7 @@ public:
                 new_tw.absent = (rwt == ReadWriteType::DELETE);
                 new_tw.lock = 0;  // unlock
                 store_release(rw_iter->second.val->tidword.obj, new_tw.obj);
-                GarbageCollector::collect(commit_tw.epoch, old);
+                GarbageCollector::collect(commit_tw.epoch, table_id, old);
                 if (rwt == ReadWriteType::DELETE) {
                     idx.remove(table_id, w_iter->first);
                     GarbageCollector::collect(commit_tw.epoch, rw_iter->second.val);
@@ -715,11 +944,13 @@ public:
             }
         }
 
+        addends.clear();
         LOG_INFO("PRECOMMIT SUCCESS");
         return true;
     }
 
     void abort() {
+        PROFILE_PHASE(ABORT);
         Index& idx = Index::get_index();
 
         for (TableID table_id: tables) {
@@ -742,7 +973,7 @@ public:
 
                 auto rwt = rw_iter->second.rwt;
                 if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                    MemoryAllocator::deallocate(rw_iter->second.rec);
+                    release_local_record(table_id, rw_iter->second);
                 }
             }
             w_table.clear();
@@ -752,15 +983,141 @@ public:
             nm.clear();
         }
         tables.clear();
+        addends.clear();
+        TransactionArena::reset();
     }
 
 private:
+    // Delta of an add, applied to the record on commit
+    struct Addend {
+        TableID table_id;
+        Key key;
+        size_t offset;
+        void (*apply)(void* field, uint64_t delta);
+        uint64_t delta;  // bits of the field type of apply
+    };
+
     TxID txid;
     uint32_t starting_epoch;
     std::set<TableID> tables;
     ReadWriteSet<Key, Value> rws;
     WriteSet<Key, Value> ws;
     NodeSet ns;
+    std::vector<Addend> addends;
+
+    template <typename T>
+    static void add_field(void* field, uint64_t delta) {
+        T d, v;
+        memcpy(&d, &delta, sizeof(T));
+        memcpy(&v, field, sizeof(T));
+        v += d;
+        memcpy(field, &v, sizeof(T));
+    }
+
+    void apply_adds(TableID table_id, Key key, Rec* rec) {
+        for (const Addend& a: addends) {
+            if (a.table_id == table_id && a.key == key) {
+                a.apply(static_cast<uint8_t*>(rec) + a.offset, a.delta);
+            }
+        }
+    }
+
+    // Turns an ADD into an UPDATE of a local copy that includes the adds, for accesses that
+    // see the added fields
+    bool materialize_adds(TableID table_id, Key key, ReadWriteElement<Value>& rwe) {
+        if (rwe.rwt != ReadWriteType::ADD) return true;
+        Rec* rec = allocate_write_buffer(table_id);
+        TidWord tw;
+        copy_record(*rwe.val, rec, tw, Schema::get_schema().get_record_size(table_id));
+        if (!is_readable(tw) || (rwe.ignores_adds && !is_same(tw, rwe.tw))) {
+            release_write_buffer(table_id, rec);
+            return false;
+        }
+        apply_adds(table_id, key, rec);
+        addends.erase(
+            std::remove_if(
+                addends.begin(), addends.end(),
+                [&](const Addend& a) { return a.table_id == table_id && a.key == key; }),
+            addends.end());
+        rwe.rec = rec;
+        rwe.tw = tw;
+        rwe.rwt = ReadWriteType::UPDATE;
+        rwe.ignores_adds = false;
+        rwe.read_rec = nullptr;
+        return true;
+    }
+
+#if COROUTINES
+    // Prefetches the values of vals (nullptr ones are skipped) and then their records, and
+    // suspends the transaction while each is fetched
+    Task<void> fetch_records(TableID table_id, Value* const* vals, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            if (vals[i]) prefetch(vals[i], sizeof(Value));
+        }
+        co_await Yield();
+        if (is_inlined<Value>(table_id)) co_return;
+        size_t record_size = Schema::get_schema().get_record_size(table_id);
+        for (size_t i = 0; i < n; i++) {
+            Rec* rec = vals[i] ? load_acquire(vals[i]->rec) : nullptr;
+            if (rec) prefetch(rec, record_size);
+        }
+        co_await Yield();
+    }
+
+    static void prefetch(const void* ptr, size_t size) {
+        const char* p = static_cast<const char*>(ptr);
+        for (size_t offset = 0; offset < size; offset += 64) __builtin_prefetch(p + offset);
+    }
+#endif
+
+    // Inlined records cannot be swapped and are always modified in place
+    bool writes_in_place(TableID table_id) const {
+        return modify_original || is_inlined<Value>(table_id);
+    }
+
+    // Buffer for the local copy of an existing record that is written back on commit
+    Rec* allocate_write_buffer(TableID table_id) {
+        if (writes_in_place(table_id)) {
+            return TransactionArena::allocate(Schema::get_schema().get_record_size(table_id));
+        }
+        return SlabAllocator::allocate(table_id);
+    }
+
+    // Buffer for a new record, which is installed as is on commit unless it is inlined
+    Rec* allocate_insert_buffer(TableID table_id) {
+        if (is_inlined<Value>(table_id)) {
+            return TransactionArena::allocate(Schema::get_schema().get_record_size(table_id));
+        }
+        return SlabAllocator::allocate(table_id);
+    }
+
+    void release_write_buffer(TableID table_id, Rec* rec) {
+        // Transaction local buffers are released at once by TransactionArena::reset()
+        if (!writes_in_place(table_id)) SlabAllocator::deallocate(table_id, rec);
+    }
+
+    void release_local_record(TableID table_id, ReadWriteElement<Value>& rwe) {
+        if (!rwe.in_place) SlabAllocator::deallocate(table_id, rwe.rec);
+    }
+
+    // Shared record pointer, or a transaction local snapshot of the record when reading by copy
+    void read_record(TableID table_id, Value& val, Rec*& rec, TidWord& tw) {
+        if (read_by_copy || is_inlined<Value>(table_id)) {
+            size_t record_size = Schema::get_schema().get_record_size(table_id);
+            rec = TransactionArena::allocate(record_size);
+            copy_record(val, rec, tw, record_size);
+        } else {
+            get_record_pointer(val, rec, tw);
+        }
+    }
+
+    // Reads that ignore adds are validated by comparing the record with what was read, so they
+    // always keep a copy: a shared record may be retired and its slot reused before validation
+    void read_snapshot(TableID table_id, Value& val, Rec*& rec, TidWord& tw) {
+        size_t record_size = Schema::get_schema().get_record_size(table_id);
+        rec = TransactionArena::allocate(record_size);
+        copy_record(val, rec, tw, record_size);
+    }
 
     void get_record_pointer(Value& val, Rec*& rec, TidWord& tw) {
         TidWord expected;
@@ -793,6 +1150,7 @@ private:
             // copy record and tidword
             Rec* temp = load_acquire(val.rec);
             if (temp) memcpy(rec, temp, rec_size);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);  // the copy is not reordered after the check
             tw.obj = load_acquire(val.tidword.obj);
 
             // check if not changed
@@ -847,6 +1205,36 @@ private:
 
     bool is_same(const TidWord& lhs, const TidWord& rhs) { return lhs.obj == rhs.obj; }
 
+    // The record may have been changed since rwe.read_rec was copied, but only in its commutative
+    // fields. rwe.val is locked by this transaction if rwt is ADD.
+    bool is_valid_ignoring_adds(
+        TableID table_id, const ReadWriteElement<Value>& rwe, const TidWord& current) {
+        bool locked = rwe.rwt == ReadWriteType::ADD;
+        if (current.lock && !locked) return false;
+        if (is_valid(current, rwe.tw)) return true;
+        if (!is_readable(current)) return false;
+        Value& val = *rwe.val;
+        const Rec* rec = is_inlined<Value>(table_id) ? val.get_payload() : load_acquire(val.rec);
+        bool same = is_equal_except_commutative(table_id, rwe.read_rec, rec);
+        if (locked) return same;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);  // the comparison is not reordered after the check
+        TidWord tw;
+        tw.obj = load_acquire(val.tidword.obj);
+        return same && is_same(tw, current);
+    }
+
+    bool is_equal_except_commutative(TableID table_id, const Rec* lhs, const Rec* rhs) {
+        const Schema& sch = Schema::get_schema();
+        const uint8_t* l = static_cast<const uint8_t*>(lhs);
+        const uint8_t* r = static_cast<const uint8_t*>(rhs);
+        size_t begin = 0;
+        for (auto& [offset, size]: sch.get_commutative_fields(table_id)) {
+            if (memcmp(l + begin, r + begin, offset - begin) != 0) return false;
+            begin = offset + size;
+        }
+        return memcmp(l + begin, r + begin, sch.get_record_size(table_id) - begin) == 0;
+    }
+
     bool is_readable(const TidWord& tw) { return !tw.absent && tw.latest; }
 
     bool is_valid(const TidWord& current, const TidWord& expected) {
@@ -1,17 +1,55 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
+#include "protocols/common/schema.hpp"
 #include "protocols/common/transaction_id.hpp"
 #include "protocols/silo/include/tidword.hpp"
 
+// Silo built with -DSILO_INLINE_SIZE=N (cmake -DSILO_INLINE_SIZE=N) uses InlinedValue<N>
+#ifndef SILO_INLINE_SIZE
+#    define SILO_INLINE_SIZE 0
+#endif
+
 struct Value {
+    static constexpr size_t INLINE_SIZE = 0;
     alignas(64) TidWord tidword;
     void* rec;
+    void* get_payload() { return nullptr; }
 };
 
+/**
+ * Value that stores records of up to N bytes right after the TidWord, so that reading them does
+ * not chase a pointer into another cache line. rec points to payload while such a record exists
+ * (nullptr otherwise) and larger records are stored out of line as with Value.
+ * Inlined records cannot be swapped on update, so Silo always modifies them in place and reads
+ * them by copy regardless of its update and read policies.
+ * Every Value of the index has the size of the payload, so N is a trade-off between the tables
+ * that fit and the memory (and cache lines) wasted for those that do not.
+ */
+template <size_t N>
+struct InlinedValue {
+    static_assert(N > 0, "use Value for records that are never inlined");
+    static constexpr size_t INLINE_SIZE = N;
+    alignas(64) TidWord tidword;
+    void* rec;
+    alignas(8) uint8_t payload[N];
+    void* get_payload() { return payload; }
+};
+
+// Whether records of table_id are stored in the Value
+template <typename Value>
+bool is_inlined(TableID table_id) {
+    if constexpr (Value::INLINE_SIZE == 0) {
+        return false;
+    } else {
+        return Schema::get_schema().get_record_size(table_id) <= Value::INLINE_SIZE;
+    }
+}
+
 struct ValueTest {
     alignas(64) TidWord tidword;
     void* rec;
     TxID txid;
-};
\ No newline at end of file
+};
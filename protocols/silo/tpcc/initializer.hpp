@@ -1,11 +1,18 @@
 #pragma once
 
+#include <cstddef>
+#include <cstring>
+
 #include "benchmarks/tpcc/include/config.hpp"
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "protocols/common/memory_allocator.hpp"
 #include "protocols/common/schema.hpp"
+#include "protocols/common/slab_allocator.hpp"
+#include "protocols/silo/include/value.hpp"
+#include "protocols/tpcc_common/index_selection.hpp"
 #include "protocols/tpcc_common/record_misc.hpp"
+#include "protocols/tpcc_common/warehouse_loader.hpp"
 #include "utils/utils.hpp"
 
 template <typename Index>
@@ -14,6 +21,7 @@ private:
     using Key = typename Index::Key;
     using Value = typename Index::Value;
 
+    // rec must not be used after this call since inlined records are moved into the value
     static void insert_into_index(TableID table_id, Key key, void* rec) {
         TidWord tw;
         tw.lock = 0;
@@ -22,6 +30,12 @@ private:
         tw.tid = 0;
         tw.epoch = 0;
         Value* val = reinterpret_cast<Value*>(MemoryAllocator::aligned_allocate(sizeof(Value)));
+        if (is_inlined<Value>(table_id)) {
+            // Records are generated out of line and moved into the value
+            memcpy(val->get_payload(), rec, Schema::get_schema().get_record_size(table_id));
+            SlabAllocator::deallocate(table_id, rec);
+            rec = val->get_payload();
+        }
         val->rec = rec;
         val->tidword.obj = tw.obj;
         Index::get_index().insert(table_id, key, val);
@@ -29,30 +43,33 @@ private:
 
     static void create_and_insert_item_record(uint32_t i_id) {
         Item::Key key = Item::Key::create_key(i_id);
-        Item* i = reinterpret_cast<Item*>(MemoryAllocator::aligned_allocate(sizeof(Item)));
+        Item* i = reinterpret_cast<Item*>(SlabAllocator::allocate(get_id<Item>()));
         i->generate(i_id);
         insert_into_index(get_id<Item>(), key.get_raw_key(), reinterpret_cast<void*>(i));
     }
 
     static void create_and_insert_warehouse_record(uint16_t w_id) {
         Warehouse::Key key = Warehouse::Key::create_key(w_id);
-        Warehouse* w =
-            reinterpret_cast<Warehouse*>(MemoryAllocator::aligned_allocate(sizeof(Warehouse)));
+        Warehouse* w = reinterpret_cast<Warehouse*>(SlabAllocator::allocate(get_id<Warehouse>()));
         w->generate(w_id);
         insert_into_index(get_id<Warehouse>(), key.get_raw_key(), reinterpret_cast<void*>(w));
     }
 
     static void create_and_insert_stock_record(uint16_t s_w_id, uint32_t s_i_id) {
         Stock::Key key = Stock::Key::create_key(s_w_id, s_i_id);
-        Stock* s = reinterpret_cast<Stock*>(MemoryAllocator::aligned_allocate(sizeof(Stock)));
+        Stock* s = reinterpret_cast<Stock*>(SlabAllocator::allocate(get_id<Stock>()));
         s->generate(s_w_id, s_i_id);
         insert_into_index(get_id<Stock>(), key.get_raw_key(), reinterpret_cast<void*>(s));
+#if TPCC_HOT_COLD_SPLIT
+        StockData* sd = reinterpret_cast<StockData*>(SlabAllocator::allocate(get_id<StockData>()));
+        sd->generate(s_w_id, s_i_id);
+        insert_into_index(get_id<StockData>(), key.get_raw_key(), reinterpret_cast<void*>(sd));
+#endif
     }
 
     static void create_and_insert_district_record(uint16_t d_w_id, uint8_t d_id) {
         District::Key key = District::Key::create_key(d_w_id, d_id);
-        District* d =
-            reinterpret_cast<District*>(MemoryAllocator::aligned_allocate(sizeof(District)));
+        District* d = reinterpret_cast<District*>(SlabAllocator::allocate(get_id<District>()));
         d->generate(d_w_id, d_id);
         insert_into_index(get_id<District>(), key.get_raw_key(), reinterpret_cast<void*>(d));
     }
@@ -60,14 +77,22 @@ private:
     static void create_and_insert_customer_record(
         uint16_t c_w_id, uint8_t c_d_id, uint32_t c_id, Timestamp t) {
         Customer::Key key = Customer::Key::create_key(c_w_id, c_d_id, c_id);
-        Customer* c =
-            reinterpret_cast<Customer*>(MemoryAllocator::aligned_allocate(sizeof(Customer)));
+        Customer* c = reinterpret_cast<Customer*>(SlabAllocator::allocate(get_id<Customer>()));
         c->generate(c_w_id, c_d_id, c_id, t);
-        insert_into_index(get_id<Customer>(), key.get_raw_key(), reinterpret_cast<void*>(c));
-        CustomerSecondary cs;
-        cs.key.c_key = key.c_key;
         CustomerSecondaryKey cs_key = CustomerSecondaryKey::create_key(*c);
-        get_customer_secondary_table().emplace(cs_key, cs);
+        CustomerSecondary* cs = reinterpret_cast<CustomerSecondary*>(
+            SlabAllocator::allocate(get_id<CustomerSecondary>()));
+        *cs = CustomerSecondary(*c);
+        insert_into_index(get_id<Customer>(), key.get_raw_key(), reinterpret_cast<void*>(c));
+#if TPCC_HOT_COLD_SPLIT
+        CustomerData* cd =
+            reinterpret_cast<CustomerData*>(SlabAllocator::allocate(get_id<CustomerData>()));
+        cd->generate(c_w_id, c_d_id, c_id);
+        insert_into_index(
+            get_id<CustomerData>(), key.get_raw_key(), reinterpret_cast<void*>(cd));
+#endif
+        insert_into_index(
+            get_id<CustomerSecondary>(), cs_key.get_raw_key(), reinterpret_cast<void*>(cs));
     }
 
     static void create_and_insert_history_record(
@@ -81,23 +106,23 @@ private:
     static std::pair<Timestamp, uint8_t> create_and_insert_order_record(
         uint16_t o_w_id, uint8_t o_d_id, uint32_t o_id, uint32_t o_c_id) {
         Order::Key key = Order::Key::create_key(o_w_id, o_d_id, o_id);
-        Order* o = reinterpret_cast<Order*>(MemoryAllocator::aligned_allocate(sizeof(Order)));
+        Order* o = reinterpret_cast<Order*>(SlabAllocator::allocate(get_id<Order>()));
         o->generate(o_w_id, o_d_id, o_id, o_c_id);
+        OrderSecondaryKey os_key = OrderSecondaryKey::create_key(*o);
+        std::pair<Timestamp, uint8_t> ret = std::make_pair(o->o_entry_d, o->o_ol_cnt);
         insert_into_index(get_id<Order>(), key.get_raw_key(), reinterpret_cast<void*>(o));
-        OrderSecondary* os = reinterpret_cast<OrderSecondary*>(
-            MemoryAllocator::aligned_allocate(sizeof(OrderSecondary)));
+        OrderSecondary* os =
+            reinterpret_cast<OrderSecondary*>(SlabAllocator::allocate(get_id<OrderSecondary>()));
         os->key.o_key = key.o_key;
-        OrderSecondaryKey os_key = OrderSecondaryKey::create_key(*o);
         insert_into_index(
             get_id<OrderSecondary>(), os_key.get_raw_key(), reinterpret_cast<void*>(os));
-        return std::make_pair(o->o_entry_d, o->o_ol_cnt);
+        return ret;
     }
 
     static void create_and_insert_neworder_record(
         uint16_t no_w_id, uint8_t no_d_id, uint32_t no_o_id) {
         NewOrder::Key key = NewOrder::Key::create_key(no_w_id, no_d_id, no_o_id);
-        NewOrder* no =
-            reinterpret_cast<NewOrder*>(MemoryAllocator::aligned_allocate(sizeof(NewOrder)));
+        NewOrder* no = reinterpret_cast<NewOrder*>(SlabAllocator::allocate(get_id<NewOrder>()));
         no->generate(no_w_id, no_d_id, no_o_id);
         insert_into_index(get_id<NewOrder>(), key.get_raw_key(), reinterpret_cast<void*>(no));
     }
@@ -106,8 +131,7 @@ private:
         uint16_t ol_w_id, uint8_t ol_d_id, uint32_t ol_o_id, uint8_t ol_number,
         uint16_t ol_supply_w_id, uint32_t ol_i_id, Timestamp o_entry_d) {
         OrderLine::Key key = OrderLine::Key::create_key(ol_w_id, ol_d_id, ol_o_id, ol_number);
-        OrderLine* ol =
-            reinterpret_cast<OrderLine*>(MemoryAllocator::aligned_allocate(sizeof(OrderLine)));
+        OrderLine* ol = reinterpret_cast<OrderLine*>(SlabAllocator::allocate(get_id<OrderLine>()));
         ol->generate(ol_w_id, ol_d_id, ol_o_id, ol_number, ol_supply_w_id, ol_i_id, o_entry_d);
         insert_into_index(get_id<OrderLine>(), key.get_raw_key(), reinterpret_cast<void*>(ol));
     };
@@ -176,26 +200,33 @@ private:
     // Loading warehouses table eventually evokes loading of all the tables other than the items
     // table.
     static void load_warehouses_table() {
-        const size_t nr_w = get_config().get_num_warehouses();
-        for (size_t w_id = 1; w_id <= nr_w; w_id++) {
+        load_warehouses_on_owner_nodes<Index>([](uint16_t w_id) {
             create_and_insert_warehouse_record(w_id);
             load_stocks_table(w_id);
             load_districts_table(w_id);
-        }
+        });
     }
 
 public:
     static void load_all_tables() {
+        select_table_indexes<Index>();
         Schema& sch = Schema::get_mutable_schema();
         sch.set_record_size(get_id<Item>(), sizeof(Item));
         sch.set_record_size(get_id<Warehouse>(), sizeof(Warehouse));
         sch.set_record_size(get_id<Stock>(), sizeof(Stock));
         sch.set_record_size(get_id<District>(), sizeof(District));
         sch.set_record_size(get_id<Customer>(), sizeof(Customer));
+        sch.set_record_size(get_id<CustomerSecondary>(), sizeof(CustomerSecondary));
         sch.set_record_size(get_id<Order>(), sizeof(Order));
         sch.set_record_size(get_id<OrderSecondary>(), sizeof(OrderSecondary));
         sch.set_record_size(get_id<OrderLine>(), sizeof(OrderLine));
         sch.set_record_size(get_id<NewOrder>(), sizeof(NewOrder));
+        sch.add_commutative_field(get_id<Warehouse>(), offsetof(Warehouse, w_ytd), sizeof(double));
+        sch.add_commutative_field(get_id<District>(), offsetof(District, d_ytd), sizeof(double));
+#if TPCC_HOT_COLD_SPLIT
+        sch.set_record_size(get_id<StockData>(), sizeof(StockData));
+        sch.set_record_size(get_id<CustomerData>(), sizeof(CustomerData));
+#endif
 
         load_items_table();
         load_warehouses_table();
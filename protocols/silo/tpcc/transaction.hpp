@@ -2,14 +2,15 @@
 
 #include <stdint.h>
 
-#include <algorithm>
 #include <cassert>
-#include <deque>
+#include <vector>
 
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
 #include "protocols/common/epoch_manager.hpp"
+#include "protocols/common/scan_buffer.hpp"
 #include "protocols/tpcc_common/record_misc.hpp"
+#include "utils/coroutine.hpp"
 
 template <typename Protocol>
 class Transaction {
@@ -42,11 +43,42 @@ public:
     // Do not use this function for read-modify-write.
     // Use prepare_record_for_update() intead.
     template <typename Record>
-    Result get_record(const Record*& rec_ptr, typename Record::Key rec_key) {
+    MaybeTask<Result> get_record(const Record*& rec_ptr, typename Record::Key rec_key) {
         // We assume the write set does not hold the corresponding record.
+        typename Protocol::Value* val = CO_AWAIT(fetch<Record>(rec_key));
         rec_ptr = reinterpret_cast<const Record*>(
-            protocol->read(get_id<Record>(), rec_key.get_raw_key()));
-        return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+            protocol->read(get_id<Record>(), rec_key.get_raw_key(), val));
+        CO_RETURN rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+    }
+
+    // Same as get_record() for each of the n keys, but all keys are looked up in the index
+    // together first so that their cache misses overlap, and each record is then accessed with
+    // the value found instead of looking its key up again. Stops at the first key that does not
+    // succeed.
+    template <typename Record>
+    MaybeTask<Result> get_records_batch(
+        size_t n, const typename Record::Key* rec_keys, const Record** rec_ptrs) {
+        const auto& vals = *CO_AWAIT(lookup<Record>(n, rec_keys));
+        for (size_t i = 0; i < n; i++) {
+            rec_ptrs[i] = reinterpret_cast<const Record*>(
+                protocol->read(get_id<Record>(), rec_keys[i].get_raw_key(), vals[i]));
+            if (rec_ptrs[i] == nullptr) CO_RETURN Result::ABORT;
+        }
+        CO_RETURN Result::SUCCESS;
+    }
+
+    // Same as prepare_record_for_update() for each of the n keys, batched like
+    // get_records_batch(). A key given several times gets the same write set record each time.
+    template <typename Record>
+    MaybeTask<Result> prepare_records_for_update_batch(
+        size_t n, const typename Record::Key* rec_keys, Record** rec_ptrs) {
+        const auto& vals = *CO_AWAIT(lookup<Record>(n, rec_keys));
+        for (size_t i = 0; i < n; i++) {
+            rec_ptrs[i] = reinterpret_cast<Record*>(
+                protocol->update(get_id<Record>(), rec_keys[i].get_raw_key(), vals[i]));
+            if (rec_ptrs[i] == nullptr) CO_RETURN Result::ABORT;
+        }
+        CO_RETURN Result::SUCCESS;
     }
 
     Result prepare_record_for_insert(History*& rec_ptr) {
@@ -67,24 +99,24 @@ public:
     template <typename Record>
     Result finish_insert([[maybe_unused]] Record* rec_ptr) {
         // secondary index insert
-        if constexpr (std::is_same<Record, Order>::value) {
+        if constexpr (std::is_same<Record, Customer>::value || std::is_same<Record, Order>::value) {
             Secondary<Record>* sec = nullptr;
             auto sec_key = Secondary<Record>::Key::create_key(*rec_ptr);
             Result res = prepare_record_for_insert(sec, sec_key);
             if (res != Result::SUCCESS) return res;
-            typename Record::Key pri_key = Record::Key::create_key(*rec_ptr);
-            sec->key = pri_key;
+            *sec = Secondary<Record>(*rec_ptr);
         }
         return Result::SUCCESS;
     }
 
     // Get record and prepare for update.
     template <typename Record>
-    Result prepare_record_for_update(Record*& rec_ptr, typename Record::Key rec_key) {
+    MaybeTask<Result> prepare_record_for_update(Record*& rec_ptr, typename Record::Key rec_key) {
         // rec_ptr points to data in writeset copied from db
-        rec_ptr =
-            reinterpret_cast<Record*>(protocol->update(get_id<Record>(), rec_key.get_raw_key()));
-        return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+        typename Protocol::Value* val = CO_AWAIT(fetch<Record>(rec_key));
+        rec_ptr = reinterpret_cast<Record*>(
+            protocol->update(get_id<Record>(), rec_key.get_raw_key(), val));
+        CO_RETURN rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
     }
 
     template <typename Record>
@@ -93,6 +125,26 @@ public:
         return Result::SUCCESS;
     }
 
+    // Adds delta to the field at offset of the record without reading it. Concurrent adds to
+    // the same field do not conflict. The field must be registered with
+    // Schema::add_commutative_field().
+    template <typename Record, typename T>
+    Result add_to_field(typename Record::Key rec_key, size_t offset, T delta) {
+        bool added = protocol->add(get_id<Record>(), rec_key.get_raw_key(), offset, delta);
+        return added ? Result::SUCCESS : Result::ABORT;
+    }
+
+    // Like get_record(), but the fields updated by add_to_field() are not validated and must not
+    // be used. Reading the other fields does not conflict with concurrent adds.
+    template <typename Record>
+    MaybeTask<Result> get_record_ignoring_adds(
+        const Record*& rec_ptr, typename Record::Key rec_key) {
+        typename Protocol::Value* val = CO_AWAIT(fetch<Record>(rec_key));
+        rec_ptr = reinterpret_cast<const Record*>(
+            protocol->read_ignoring_adds(get_id<Record>(), rec_key.get_raw_key(), val));
+        CO_RETURN rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
+    }
+
     template <typename Record>
     Result prepare_record_for_delete(const Record*& rec_ptr, typename Record::Key rec_key) {
         rec_ptr =
@@ -106,82 +158,70 @@ public:
         return Result::SUCCESS;
     }
 
-    Result get_customer_by_last_name(
+    MaybeTask<Result> get_customer_by_last_name(
         const Customer*& c, uint16_t w_id, uint8_t d_id, const char* c_last) {
-        CustomerSecondary::Key c_sec_key = CustomerSecondary::Key::create_key(w_id, d_id, c_last);
-        auto& t = get_customer_secondary_table();
-        auto it = t.lower_bound(c_sec_key);
-        std::deque<Customer::Key> keys;
-        std::deque<const Customer*> recs;
-
-        while (it != t.end() && it->first == c_sec_key) {
-            keys.push_back(it->second.key);
-            ++it;
-        }
-
-        if (keys.empty()) {
-            c = nullptr;
-            return Result::FAIL;
-        }
-
-        for (auto iter = keys.begin(); iter != keys.end(); ++iter) {
-            recs.emplace_back();
-            Result res = get_record(recs.back(), *iter);
-            if (res != Result::SUCCESS) return res;
-        }
+        uint32_t c_last_num = get_clast_number(c_last);
+        CustomerSecondary::Key c_sec_low_key =
+            CustomerSecondary::Key::create_key(w_id, d_id, c_last_num);
+        CustomerSecondary::Key c_sec_high_key =
+            CustomerSecondary::Key::create_key(w_id, d_id, c_last_num + 1);
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+        bool scanned = protocol->read_scan(
+            get_id<CustomerSecondary>(), c_sec_low_key.get_raw_key(),
+            c_sec_high_key.get_raw_key(), -1, false, kr_list);
+        if (!scanned) CO_RETURN Result::ABORT;
 
-        if (recs.empty()) {
+        if (kr_list.empty()) {
             c = nullptr;
-            return Result::FAIL;
+            CO_RETURN Result::FAIL;
         }
 
-        std::sort(recs.begin(), recs.end(), [](const Customer* lhs, const Customer* rhs) {
-            return ::strncmp(lhs->c_first, rhs->c_first, Customer::MAX_FIRST) < 0;
-        });
-
-        c = recs[(recs.size() + 1) / 2 - 1];
-        assert(c != nullptr);
-        return Result::SUCCESS;
+        const CustomerSecondary* c_sec = get_middle_customer(kr_list);
+        CO_RETURN CO_AWAIT(get_record(c, c_sec->key));
     }
 
-    Result get_customer_by_last_name_and_prepare_for_update(
+    MaybeTask<Result> get_customer_by_last_name_and_prepare_for_update(
         Customer*& c, uint16_t w_id, uint8_t d_id, const char* c_last) {
         const Customer* c_temp = nullptr;
-        Result res = get_customer_by_last_name(c_temp, w_id, d_id, c_last);
-        if (res != Result::SUCCESS) return res;
+        Result res = CO_AWAIT(get_customer_by_last_name(c_temp, w_id, d_id, c_last));
+        if (res != Result::SUCCESS) CO_RETURN res;
 
         // create update record in writeset
         Customer::Key c_key = Customer::Key::create_key(*c_temp);
-        return prepare_record_for_update(c, c_key);
+        CO_RETURN CO_AWAIT(prepare_record_for_update(c, c_key));
     }
 
-    Result get_order_by_customer_id(const Order*& o, uint16_t w_id, uint8_t d_id, uint32_t c_id) {
+    MaybeTask<Result> get_order_by_customer_id(
+        const Order*& o, uint16_t w_id, uint8_t d_id, uint32_t c_id) {
         OrderSecondary::Key o_sec_low_key = OrderSecondary::Key::create_key(w_id, d_id, c_id, 0);
         OrderSecondary::Key o_sec_high_key =
             OrderSecondary::Key::create_key(w_id, d_id, c_id + 1, 0);
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->read_scan(
             get_id<OrderSecondary>(), o_sec_low_key.get_raw_key(), o_sec_high_key.get_raw_key(), 1,
-            true, kr_map);
+            true, kr_list);
 
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 auto o_sec = reinterpret_cast<OrderSecondary*>(r);
                 Order::Key o_key = o_sec->key;
-                return get_record(o, o_key);
+                CO_RETURN CO_AWAIT(get_record(o, o_key));
             }
             assert(false);
         }
-        return Result::ABORT;
+        CO_RETURN Result::ABORT;
     }
 
     Result get_neworder_with_smallest_key_no_less_than(const NewOrder*& no, NewOrder::Key low) {
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->read_scan(
-            get_id<NewOrder>(), low.get_raw_key(), UINT64_MAX, 1, false, kr_map);
+            get_id<NewOrder>(), low.get_raw_key(), UINT64_MAX, 1, false, kr_list);
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 NewOrder::Key nk(k);
                 if (nk.w_id == low.w_id && nk.d_id == low.d_id) {
@@ -200,11 +240,12 @@ public:
     // [low ,up)
     template <typename Record, typename Func>
     Result range_query(typename Record::Key low, typename Record::Key up, Func&& func) {
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->read_scan(
-            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_map);
+            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_list);
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 Record* rec = reinterpret_cast<Record*>(r);
                 func(*rec);
@@ -218,12 +259,13 @@ public:
     // [low ,up)
     template <typename Record, typename Func>
     Result range_update(typename Record::Key low, typename Record::Key up, Func&& func) {
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->update_scan(
-            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_map);
+            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_list);
         Result res;
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 Record* rec = reinterpret_cast<Record*>(r);
                 func(*rec);
@@ -238,4 +280,33 @@ public:
 
 private:
     std::unique_ptr<Protocol> protocol = nullptr;
+
+    // Buffers of lookup(), kept per TxSlot since the lookup may suspend in the coroutine mode
+    struct LookupBuffers {
+        std::vector<typename Protocol::Key> keys;
+        std::vector<typename Protocol::Value*> vals;
+    };
+
+    // Values of the n keys found by one Protocol::lookup(), to be passed to read() and update()
+    template <typename Record>
+    MaybeTask<const std::vector<typename Protocol::Value*>*> lookup(
+        size_t n, const typename Record::Key* rec_keys) {
+        thread_local LookupBuffers buffers[TxSlot::MAX];
+        LookupBuffers& b = buffers[TxSlot::get()];
+        b.keys.clear();
+        for (size_t i = 0; i < n; i++) b.keys.push_back(rec_keys[i].get_raw_key());
+        CO_AWAIT(protocol->lookup(get_id<Record>(), b.keys, b.vals));
+        CO_RETURN &b.vals;
+    }
+
+    // Value of rec_key fetched by Protocol::fetch() in the coroutine mode, to be passed to
+    // read() and update(). Without it, nullptr is returned and they look rec_key up themselves.
+    template <typename Record>
+    MaybeTask<typename Protocol::Value*> fetch([[maybe_unused]] typename Record::Key rec_key) {
+#if COROUTINES
+        co_return co_await protocol->fetch(get_id<Record>(), rec_key.get_raw_key());
+#else
+        return nullptr;
+#endif
+    }
 };
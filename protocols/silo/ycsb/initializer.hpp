@@ -1,11 +1,15 @@
 #pragma once
 
+#include <cstring>
+
 #include "benchmarks/ycsb/include/config.hpp"
 #include "benchmarks/ycsb/include/record_key.hpp"
 #include "benchmarks/ycsb/include/record_layout.hpp"
 #include "protocols/common/memory_allocator.hpp"
 #include "protocols/common/schema.hpp"
+#include "protocols/common/slab_allocator.hpp"
 #include "protocols/silo/include/tidword.hpp"
+#include "protocols/silo/include/value.hpp"
 #include "protocols/ycsb_common/record_misc.hpp"
 #include "utils/utils.hpp"
 
@@ -23,6 +27,12 @@ private:
         tw.tid = 0;
         tw.epoch = 0;
         Value* val = reinterpret_cast<Value*>(MemoryAllocator::aligned_allocate(sizeof(Value)));
+        if (is_inlined<Value>(table_id)) {
+            // Records are generated out of line and moved into the value
+            memcpy(val->get_payload(), rec, Schema::get_schema().get_record_size(table_id));
+            SlabAllocator::deallocate(table_id, rec);
+            rec = val->get_payload();
+        }
         val->rec = rec;
         val->tidword.obj = tw.obj;
         Index::get_index().insert(table_id, key, val);
@@ -37,7 +47,7 @@ public:
         const Config& c = get_config();
 
         for (uint64_t key = 0; key < c.get_num_records(); key++) {
-            void* rec = new (MemoryAllocator::allocate(sizeof(Record))) Record();
+            void* rec = new (SlabAllocator::allocate(get_id<Record>())) Record();
             insert_into_index(get_id<Record>(), key, rec);
         }
     }
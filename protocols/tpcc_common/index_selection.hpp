@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+#include "benchmarks/tpcc/include/config.hpp"
+#include "benchmarks/tpcc/include/record_layout.hpp"
+#include "indexes/index_interface.hpp"
+#include "protocols/common/schema.hpp"
+#include "protocols/tpcc_common/record_misc.hpp"
+
+/**
+ * Selects the index backend of each table (see MasstreeIndexes::use_backend()): point_index for
+ * the tables that TPC-C only accesses by exact key (Item, Warehouse, District, Customer and
+ * Stock, and their cold parts) and range_index for the others (orders, order lines, new orders
+ * and the secondary indexes), both Masstree by default.
+ * Must be called by the initializer before the tables are loaded.
+ */
+template <typename Index>
+inline void select_table_indexes() {
+    const Config& c = get_config();
+    const size_t nr_w = c.get_num_warehouses();
+    const size_t nr_d = nr_w * District::DISTS_PER_WARE;
+    const size_t nr_c = nr_d * Customer::CUSTS_PER_DIST;
+    const size_t nr_s = nr_w * Stock::STOCKS_PER_WARE;
+    Index& idx = Index::get_index();
+
+    const IndexBackend point = c.get_point_index();
+    idx.use_backend(get_id<Item>(), point, Item::ITEMS);
+    idx.use_backend(get_id<Warehouse>(), point, nr_w);
+    idx.use_backend(get_id<District>(), point, nr_d);
+    idx.use_backend(get_id<Customer>(), point, nr_c);
+    idx.use_backend(get_id<Stock>(), point, nr_s);
+#if TPCC_HOT_COLD_SPLIT
+    idx.use_backend(get_id<CustomerData>(), point, nr_c);
+    idx.use_backend(get_id<StockData>(), point, nr_s);
+#endif
+
+    const IndexBackend range = c.get_range_index();
+    idx.use_backend(get_id<CustomerSecondary>(), range);
+    idx.use_backend(get_id<Order>(), range);
+    idx.use_backend(get_id<OrderSecondary>(), range);
+    idx.use_backend(get_id<NewOrder>(), range);
+    idx.use_backend(get_id<OrderLine>(), range);
+}
@@ -1,7 +1,8 @@
 #pragma once
 
+#include <cstring>
 #include <deque>
-#include <map>
+#include <utility>
 
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
@@ -12,59 +13,82 @@ struct OrderSecondaryKey;
 struct CustomerSecondary {
     using Key = CustomerSecondaryKey;
     Customer::Key key;
+    char c_first[Customer::MAX_FIRST + 1];
     CustomerSecondary() {}
-    CustomerSecondary(Customer::Key key)
-        : key(key.get_raw_key()) {}
+    CustomerSecondary(const Customer& c)
+        : key(Customer::Key::create_key(c)) {
+        copy_cstr(c_first, c.c_first, sizeof(c_first));
+    }
     bool operator==(const CustomerSecondary& rhs) const noexcept { return key == rhs.key; };
 };
 
+/**
+ * Customers of a district ordered by (c_last, c_first). c_last is encoded by the number it was
+ * made from (see make_clast()) and c_first by its first FIRST_PREFIX characters, so customers
+ * with the same last name are found with one range scan, in c_first order except among those
+ * whose first names share the prefix (see get_middle_customer()). c_id makes keys unique.
+ */
 struct CustomerSecondaryKey {
+    static constexpr int FIRST_PREFIX = 3;
     union {
         struct {
-            uint32_t d_id : 8;
-            uint32_t w_id : 16;
-            uint32_t not_used : 8;
+            uint64_t c_id : 12;     // up to 4095 (actual: 3000)
+            uint64_t c_first : 18;  // 6 bits per character
+            uint64_t c_last : 10;   // up to 1023 (actual: 999)
+            uint64_t d_id : 4;      // up to 15 (actual: 10)
+            uint64_t w_id : 16;
+            uint64_t not_used : 4;
         };
-        uint32_t num;
+        uint64_t c_sec_key;
     };
-    char c_last[Customer::MAX_LAST + 1];
     CustomerSecondaryKey()
-        : num(0){};
-    CustomerSecondaryKey(uint32_t num)
-        : num(num) {}
-    CustomerSecondaryKey(const CustomerSecondaryKey& c) {
-        d_id = c.d_id;
-        w_id = c.w_id;
-        not_used = 0;
-        copy_cstr(c_last, c.c_last, sizeof(c_last));
-    }
-
-    int cmp_c_last(const CustomerSecondaryKey& rhs) const {
-        return ::strncmp(c_last, rhs.c_last, Customer::MAX_LAST);
-    }
-
+        : c_sec_key(0){};
+    CustomerSecondaryKey(uint64_t c_sec_key)
+        : c_sec_key(c_sec_key) {}
+    uint64_t get_raw_key() const { return c_sec_key; }
     bool operator<(const CustomerSecondaryKey& rhs) const noexcept {
-        if (num == rhs.num)
-            return cmp_c_last(rhs) < 0;
-        else
-            return num < rhs.num;
+        return c_sec_key < rhs.c_sec_key;
     }
     bool operator==(const CustomerSecondaryKey& rhs) const noexcept {
-        return num == rhs.num && cmp_c_last(rhs) == 0;
+        return c_sec_key == rhs.c_sec_key;
     }
-    static CustomerSecondaryKey create_key(uint16_t w_id, uint8_t d_id, const char* c_last_in) {
+    static CustomerSecondaryKey create_key(
+        uint16_t w_id, uint8_t d_id, uint32_t c_last_num, const char* c_first_in, uint32_t c_id) {
         CustomerSecondaryKey k;
         k.w_id = w_id;
         k.d_id = d_id;
-        copy_cstr(k.c_last, c_last_in, sizeof(k.c_last));
+        k.c_last = c_last_num;
+        k.c_first = encode_first(c_first_in);
+        k.c_id = c_id;
         return k;
     }
+    // Smallest key of the customers of the district with the c_last made from c_last_num
+    static CustomerSecondaryKey create_key(uint16_t w_id, uint8_t d_id, uint32_t c_last_num) {
+        return create_key(w_id, d_id, c_last_num, "", 0);
+    }
     static CustomerSecondaryKey create_key(const Customer& c) {
-        CustomerSecondaryKey k{0};
-        k.w_id = c.c_w_id;
-        k.d_id = c.c_d_id;
-        copy_cstr(k.c_last, c.c_last, sizeof(k.c_last));
-        return k;
+        return create_key(c.c_w_id, c.c_d_id, get_clast_number(c.c_last), c.c_first, c.c_id);
+    }
+
+private:
+    // Order preserving for the characters of make_random_astring(), '\0' sorts first
+    static uint64_t encode_char(char ch) {
+        unsigned char u = static_cast<unsigned char>(ch);
+        if (u == 0) return 0;
+        if (u <= '9') return u < '0' ? 1 : u - '0' + 1;
+        if (u <= 'Z') return u < 'A' ? 11 : u - 'A' + 11;
+        if (u <= 'z') return u < 'a' ? 37 : u - 'a' + 37;
+        return 63;
+    }
+
+    static uint64_t encode_first(const char* c_first) {
+        uint64_t code = 0;
+        bool ended = false;
+        for (int i = 0; i < FIRST_PREFIX; i++) {
+            ended = ended || c_first[i] == '\0';
+            code = (code << 6) | (ended ? 0 : encode_char(c_first[i]));
+        }
+        return code;
     }
 };
 
@@ -74,6 +98,8 @@ struct OrderSecondary {
     OrderSecondary() {}
     OrderSecondary(Order::Key key)
         : key(key.get_raw_key()) {}
+    OrderSecondary(const Order& o)
+        : key(Order::Key::create_key(o)) {}
     bool operator==(const OrderSecondary& rhs) const noexcept { return key == rhs.key; }
 };
 
@@ -81,9 +107,9 @@ struct OrderSecondaryKey {
     union {
         struct {
             uint64_t o_id : 32;
-            uint64_t c_id : 16;  // up to 65535 (actual: 3000)
+            uint64_t c_id : 12;  // up to 4095 (actual: 3000)
             uint64_t d_id : 4;   // up to 15 (actual: 10)
-            uint64_t w_id : 12;  // up to 4095
+            uint64_t w_id : 16;
         };
         uint64_t o_sec_key;
     };
@@ -128,7 +154,9 @@ enum RecordID {
     ORDER = 8,
     ORDER_SECONDARY = 9,
     NEWORDER = 10,
-    ORDERLINE = 11
+    ORDERLINE = 11,
+    STOCK_DATA = 12,     // TPCC_HOT_COLD_SPLIT
+    CUSTOMER_DATA = 13,  // TPCC_HOT_COLD_SPLIT
 };
 
 template <typename Record>
@@ -144,7 +172,6 @@ inline TableID get_id() {
     } else if constexpr (std::is_same<Record, Customer>::value) {
         return CUSTOMER;
     } else if constexpr (std::is_same<Record, CustomerSecondary>::value) {
-        assert(false);
         return CUSTOMER_SECONDARY;
     } else if constexpr (std::is_same<Record, History>::value) {
         return HISTORY;
@@ -156,6 +183,10 @@ inline TableID get_id() {
         return NEWORDER;
     } else if constexpr (std::is_same<Record, OrderLine>::value) {
         return ORDERLINE;
+    } else if constexpr (std::is_same<Record, StockData>::value) {
+        return STOCK_DATA;
+    } else if constexpr (std::is_same<Record, CustomerData>::value) {
+        return CUSTOMER_DATA;
     } else {
         assert(false);
     }
@@ -165,6 +196,11 @@ inline TableID get_id() {
 template <typename T>
 struct Traits;
 
+template <>
+struct Traits<Customer> {
+    using SecondaryIndexType = CustomerSecondary;
+};
+
 template <>
 struct Traits<Order> {
     using SecondaryIndexType = OrderSecondary;
@@ -179,8 +215,27 @@ inline std::deque<History>& get_history_table() {
     return history_table;
 }
 
-// Read only secondary table
-inline std::multimap<CustomerSecondary::Key, CustomerSecondary>& get_customer_secondary_table() {
-    static std::multimap<CustomerSecondary::Key, CustomerSecondary> customer_secondary_table;
-    return customer_secondary_table;
-}
\ No newline at end of file
+/**
+ * kr_list holds the secondary records of the customers of a district with the same last name,
+ * in key order. Customers whose first names share the encoded prefix are moved into c_first
+ * order (keys order them by c_id), which leaves the list as it is unless such customers exist.
+ * Returns the customer at position ceil(n / 2) in c_first order, as TPC-C requires.
+ */
+template <typename KRList>
+inline const CustomerSecondary* get_middle_customer(KRList& kr_list) {
+    auto first = [&](size_t i) {
+        return reinterpret_cast<const CustomerSecondary*>(kr_list[i].second)->c_first;
+    };
+    auto same_prefix = [&](size_t i, size_t j) {
+        return CustomerSecondaryKey(kr_list[i].first).c_first ==
+               CustomerSecondaryKey(kr_list[j].first).c_first;
+    };
+    for (size_t i = 1; i < kr_list.size(); i++) {
+        for (size_t j = i; j > 0 && same_prefix(j - 1, j) &&
+                           ::strncmp(first(j), first(j - 1), Customer::MAX_FIRST) < 0;
+             j--) {
+            std::swap(kr_list[j], kr_list[j - 1]);
+        }
+    }
+    return reinterpret_cast<const CustomerSecondary*>(kr_list[(kr_list.size() + 1) / 2 - 1].second);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+
+#include "benchmarks/tpcc/include/config.hpp"
+#include "benchmarks/tpcc/include/placement.hpp"
+#include "benchmarks/tpcc/include/record_layout.hpp"
+#include "protocols/tpcc_common/record_misc.hpp"
+#include "utils/numa.hpp"
+
+/**
+ * Calls load(w_id) for every warehouse.
+ * If warehouse placement is enabled (see placement.hpp), each loader thread is pinned to the cpu
+ * of its worker and loads the warehouses assigned to it. mimalloc serves each thread from its
+ * own heap and takes memory from the arena of the local node if one is reserved
+ * (MemoryAllocator::reserve_node_arenas()), otherwise pages are placed on first touch. Either
+ * way the records of a warehouse end up on the node of the worker that accesses them most.
+ * Otherwise warehouses are loaded by the calling thread one by one.
+ * The indexes of the tables of a warehouse are created by the calling thread before the loaders
+ * start, as creating them is not thread-safe (see MasstreeIndexes::create_table()).
+ */
+template <typename Index, typename F>
+inline void load_warehouses_on_owner_nodes(F&& load) {
+    const size_t nr_w = get_config().get_num_warehouses();
+
+    Index& idx = Index::get_index();
+    idx.create_table(get_id<Warehouse>());
+    idx.create_table(get_id<Stock>());
+    idx.create_table(get_id<District>());
+    idx.create_table(get_id<Customer>());
+    idx.create_table(get_id<CustomerSecondary>());
+    idx.create_table(get_id<Order>());
+    idx.create_table(get_id<OrderSecondary>());
+    idx.create_table(get_id<NewOrder>());
+    idx.create_table(get_id<OrderLine>());
+#if TPCC_HOT_COLD_SPLIT
+    idx.create_table(get_id<StockData>());
+    idx.create_table(get_id<CustomerData>());
+#endif
+
+    if (!is_warehouse_placement_enabled()) {
+        for (size_t w_id = 1; w_id <= nr_w; w_id++) load(w_id);
+        return;
+    }
+
+    const size_t num_loaders = get_num_warehouse_loaders();
+    std::vector<std::thread> loaders;
+    loaders.reserve(num_loaders);
+    for (size_t t = 0; t < num_loaders; t++) {
+        loaders.emplace_back([&, t] {
+            get_thread_pinning().pin(t);
+            for (size_t w_id = 1; w_id <= nr_w; w_id++) {
+                if (get_warehouse_loader(w_id) == t) load(w_id);
+            }
+        });
+    }
+    for (auto& loader: loaders) loader.join();
+}
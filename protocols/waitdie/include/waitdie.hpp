@@ -4,18 +4,24 @@
 #include <cstring>
 #include <set>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
+#include "indexes/index_interface.hpp"
 #include "protocols/common/timestamp_manager.hpp"
 #include "protocols/common/transaction_id.hpp"
 #include "protocols/waitdie/include/readwriteset.hpp"
 #include "utils/logger.hpp"
+#include "utils/profiler.hpp"
 #include "utils/utils.hpp"
 
 template <typename Index>
 class WaitDie {
 public:
+    static_assert(is_index_v<Index>, "Index must implement indexes/index_interface.hpp");
     using Key = typename Index::Key;
     using Value = typename Index::Value;
+    using KRList = std::vector<std::pair<Key, Rec*>>;  // results of scans in scan order
     using LeafNode = typename Index::LeafNode;
 
     WaitDie(TxID txid, uint64_t ts, uint64_t smallest_ts, uint64_t largest_ts)
@@ -26,7 +32,7 @@ public:
         LOG_INFO("START Tx, ts: %lu, s_ts: %lu, l_ts: %lu", start_ts, smallest_ts, largest_ts);
     }
 
-    ~WaitDie() { GarbageCollector::remove(smallest_ts, largest_ts); }
+    ~WaitDie() { GarbageCollector::remove(smallest_ts); }
 
     void set_new_ts(uint64_t start_ts_, uint64_t smallest_ts_, uint64_t largest_ts_) {
         start_ts = start_ts_;
@@ -34,7 +40,16 @@ public:
         largest_ts = largest_ts_;
     }
 
-    const Rec* read(TableID table_id, Key key) {
+    // Looks up keys in the index together, so that the cache misses of the lookups overlap (see
+    // MasstreeIndexes::multi_find), and stores the value of each key in vals (nullptr if it is
+    // not found). The read/write set is not modified. A value found is passed to read() or
+    // update() as found, so that its key is not looked up again.
+    void lookup(TableID table_id, const std::vector<Key>& keys, std::vector<Value*>& vals) {
+        vals.resize(keys.size());
+        Index::get_index().multi_find(table_id, keys.size(), keys.data(), vals.data());
+    }
+
+    const Rec* read(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO(
             "READ (ts: %lu, s_ts: %lu, l_ts: %lu, t: %lu, k: %lu)", start_ts, smallest_ts,
             largest_ts, table_id, key);
@@ -45,8 +60,9 @@ public:
 
         if (rw_iter == rw_table.end()) {
             // Abort if key is not found in table
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) {
                 return nullptr;  // abort
             }
@@ -100,9 +116,15 @@ public:
             typename Index::Result res = idx.find(table_id, key, val);
             if (res == Index::Result::OK) return nullptr;
 
-            // Get next key write lock
+            // Get next key write lock. Hash index tables have no next key to protect the missing
+            // key with, so they only take inserts while loading (see
+            // MasstreeIndexes::use_backend())
             Key next_key = 0;
             Value* next_value = nullptr;
+            if (!idx.is_ordered(table_id)) {
+                throw std::runtime_error(
+                    "hash index tables do not take inserts under concurrency control");
+            }
             res = idx.get_next_kv(table_id, key, next_key, next_value);
             assert(next_key != 0);
             assert(next_value != nullptr);
@@ -125,7 +147,7 @@ public:
             }
 
             // Unlock next key
-            next_value->wdl.unlock(start_ts);
+            if (next_value) next_value->wdl.unlock(start_ts);
 
             // Place record to modify into localset
             Rec* rec = MemoryAllocator::aligned_allocate(record_size);
@@ -149,7 +171,7 @@ public:
         }
     }
 
-    Rec* update(TableID table_id, Key key) {
+    Rec* update(TableID table_id, Key key, Value* found = nullptr) {
         LOG_INFO(
             "UPDATE (ts: %lu, s_ts: %lu, l_ts: %lu, t: %lu, k: %lu)", start_ts, smallest_ts,
             largest_ts, table_id, key);
@@ -162,8 +184,9 @@ public:
         auto rw_iter = rw_table.find(key);
 
         if (rw_iter == rw_table.end()) {
-            Value* val;
-            typename Index::Result res = idx.find(table_id, key, val);
+            Value* val = found;
+            typename Index::Result res =
+                val ? Index::Result::OK : idx.find(table_id, key, val);
             if (res == Index::Result::NOT_FOUND) return nullptr;
 
             // Get write lock
@@ -231,7 +254,11 @@ public:
             if (res == Index::Result::NOT_FOUND) {
                 // Get next key write lock
                 Key next_key;
-                Value* next_value;
+                Value* next_value = nullptr;
+                if (!idx.is_ordered(table_id)) {
+                    throw std::runtime_error(
+                        "hash index tables do not take inserts under concurrency control");
+                }
                 res = idx.get_next_kv(table_id, key, next_key, next_value);
                 if (res != Index::Result::OK) return nullptr;
                 auto next_iter = rw_table.find(next_key);
@@ -252,7 +279,7 @@ public:
                 }
 
                 // Unlock next key
-                next_value->wdl.unlock(start_ts);
+                if (next_value) next_value->wdl.unlock(start_ts);
 
                 // Place record to modify into localset
                 Rec* rec = MemoryAllocator::aligned_allocate(record_size);
@@ -307,7 +334,7 @@ public:
 
     bool read_scan(
         TableID table_id, Key lkey, Key rkey, int64_t count, [[maybe_unused]] bool rev,
-        std::map<Key, Rec*>& kr_map) {
+        KRList& kr_list) {
         // no reverse scan in waitdie
         if (rev == true) throw std::runtime_error("reverse scan not supported in waitdie");
         LOG_INFO(
@@ -343,13 +370,13 @@ public:
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(nullptr, ReadWriteType::READ, false, val));
 
-                kr_map.emplace(key, val->rec);
+                kr_list.emplace_back(key, val->rec);
             } else {
                 auto rwt = rw_iter->second.rwt;
                 if (rwt == ReadWriteType::READ) {
-                    kr_map.emplace(key, rw_iter->second.val->rec);
+                    kr_list.emplace_back(key, rw_iter->second.val->rec);
                 } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                    kr_map.emplace(key, rw_iter->second.rec);
+                    kr_list.emplace_back(key, rw_iter->second.rec);
                 } else if (rwt == ReadWriteType::DELETE) {
                     throw std::runtime_error("deleted value");
                 } else {
@@ -357,7 +384,7 @@ public:
                 }
             }
 
-            if (count != -1 && static_cast<int64_t>(kr_map.size()) >= count) continue_flag = false;
+            if (count != -1 && static_cast<int64_t>(kr_list.size()) >= count) continue_flag = false;
         };
 
         [[maybe_unused]] typename Index::Result res =
@@ -372,8 +399,7 @@ public:
 
 
     bool update_scan(
-        TableID table_id, Key lkey, Key rkey, int64_t count, bool rev,
-        std::map<Key, Rec*>& kr_map) {
+        TableID table_id, Key lkey, Key rkey, int64_t count, bool rev, KRList& kr_list) {
         // no reverse scan in waitdie
         if (rev == true) throw std::runtime_error("reverse scan not supported in waitdie");
         LOG_INFO(
@@ -415,7 +441,7 @@ public:
                     rw_iter, std::piecewise_construct, std::forward_as_tuple(key),
                     std::forward_as_tuple(rec, ReadWriteType::UPDATE, false, val));
 
-                kr_map.emplace(key, rec);
+                kr_list.emplace_back(key, rec);
             } else {
                 auto rwt = rw_iter->second.rwt;
                 if (rwt == ReadWriteType::READ) {
@@ -431,9 +457,9 @@ public:
                     memcpy(rec, rw_iter->second.val->rec, record_size);
                     rw_iter->second.rec = rec;
                     rw_iter->second.rwt = ReadWriteType::UPDATE;
-                    kr_map.emplace(key, rec);
+                    kr_list.emplace_back(key, rec);
                 } else if (rwt == ReadWriteType::UPDATE || rwt == ReadWriteType::INSERT) {
-                    kr_map.emplace(key, rw_iter->second.rec);
+                    kr_list.emplace_back(key, rw_iter->second.rec);
                 } else if (rwt == ReadWriteType::DELETE) {
                     throw std::runtime_error("deleted value");
                 } else {
@@ -441,7 +467,7 @@ public:
                 }
             }
 
-            if (count != -1 && static_cast<int64_t>(kr_map.size()) >= count) continue_flag = false;
+            if (count != -1 && static_cast<int64_t>(kr_list.size()) >= count) continue_flag = false;
         };
 
         [[maybe_unused]] typename Index::Result res =
@@ -505,6 +531,7 @@ public:
 
     bool precommit() {
         LOG_INFO("PRECOMMIT, ts: %lu, s_ts: %lu, l_ts: %lu", start_ts, smallest_ts, largest_ts);
+        PROFILE_PHASE(WRITE);
         Index& idx = Index::get_index();
 
         // unlock read lock
@@ -544,6 +571,7 @@ public:
     }
 
     void abort() {
+        PROFILE_PHASE(ABORT);
         Index& idx = Index::get_index();
 
         for (TableID table_id: tables) {
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <algorithm>
 #include <cassert>
-#include <deque>
+#include <vector>
 
 #include "benchmarks/tpcc/include/record_key.hpp"
 #include "benchmarks/tpcc/include/record_layout.hpp"
+#include "protocols/common/scan_buffer.hpp"
 #include "protocols/common/timestamp_manager.hpp"
 #include "protocols/tpcc_common/record_misc.hpp"
 
@@ -53,6 +53,36 @@ public:
         return rec_ptr == nullptr ? Result::ABORT : Result::SUCCESS;
     }
 
+    // Same as get_record() for each of the n keys, but all keys are looked up in the index
+    // together first so that their cache misses overlap, and each record is then accessed with
+    // the value found instead of looking its key up again. Stops at the first key that does not
+    // succeed.
+    template <typename Record>
+    Result get_records_batch(
+        size_t n, const typename Record::Key* rec_keys, const Record** rec_ptrs) {
+        const auto& vals = lookup<Record>(n, rec_keys);
+        for (size_t i = 0; i < n; i++) {
+            rec_ptrs[i] = reinterpret_cast<const Record*>(
+                protocol->read(get_id<Record>(), rec_keys[i].get_raw_key(), vals[i]));
+            if (rec_ptrs[i] == nullptr) return Result::ABORT;
+        }
+        return Result::SUCCESS;
+    }
+
+    // Same as prepare_record_for_update() for each of the n keys, batched like
+    // get_records_batch(). A key given several times gets the same write set record each time.
+    template <typename Record>
+    Result prepare_records_for_update_batch(
+        size_t n, const typename Record::Key* rec_keys, Record** rec_ptrs) {
+        const auto& vals = lookup<Record>(n, rec_keys);
+        for (size_t i = 0; i < n; i++) {
+            rec_ptrs[i] = reinterpret_cast<Record*>(
+                protocol->update(get_id<Record>(), rec_keys[i].get_raw_key(), vals[i]));
+            if (rec_ptrs[i] == nullptr) return Result::ABORT;
+        }
+        return Result::SUCCESS;
+    }
+
     Result prepare_record_for_insert(History*& rec_ptr) {
         auto& t = get_history_table();
         t.emplace_back();
@@ -71,13 +101,12 @@ public:
     template <typename Record>
     Result finish_insert([[maybe_unused]] Record* rec_ptr) {
         // secondary index insert
-        if constexpr (std::is_same<Record, Order>::value) {
+        if constexpr (std::is_same<Record, Customer>::value || std::is_same<Record, Order>::value) {
             Secondary<Record>* sec = nullptr;
             auto sec_key = Secondary<Record>::Key::create_key(*rec_ptr);
             Result res = prepare_record_for_insert(sec, sec_key);
             if (res != Result::SUCCESS) return res;
-            typename Record::Key pri_key = Record::Key::create_key(*rec_ptr);
-            sec->key = pri_key;
+            *sec = Secondary<Record>(*rec_ptr);
         }
         return Result::SUCCESS;
     }
@@ -97,6 +126,21 @@ public:
         return Result::SUCCESS;
     }
 
+    // No commutative writes: an add is a read-modify-write of the record
+    template <typename Record, typename T>
+    Result add_to_field(typename Record::Key rec_key, size_t offset, T delta) {
+        Record* rec_ptr = nullptr;
+        Result res = prepare_record_for_update(rec_ptr, rec_key);
+        if (res != Result::SUCCESS) return res;
+        *reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(rec_ptr) + offset) += delta;
+        return finish_update(rec_ptr);
+    }
+
+    template <typename Record>
+    Result get_record_ignoring_adds(const Record*& rec_ptr, typename Record::Key rec_key) {
+        return get_record(rec_ptr, rec_key);
+    }
+
     template <typename Record>
     Result prepare_record_for_delete(const Record*& rec_ptr, typename Record::Key rec_key) {
         rec_ptr = reinterpret_cast<const Record*>(
@@ -112,40 +156,25 @@ public:
 
     Result get_customer_by_last_name(
         const Customer*& c, uint16_t w_id, uint8_t d_id, const char* c_last) {
-        CustomerSecondary::Key c_sec_key = CustomerSecondary::Key::create_key(w_id, d_id, c_last);
-        auto& t = get_customer_secondary_table();
-        auto it = t.lower_bound(c_sec_key);
-        std::deque<Customer::Key> keys;
-        std::deque<const Customer*> recs;
-
-        while (it != t.end() && it->first == c_sec_key) {
-            keys.push_back(it->second.key);
-            ++it;
-        }
-
-        if (keys.empty()) {
-            c = nullptr;
-            return Result::FAIL;
-        }
-
-        for (auto iter = keys.begin(); iter != keys.end(); ++iter) {
-            recs.emplace_back();
-            Result res = get_record(recs.back(), *iter);
-            if (res != Result::SUCCESS) return res;
-        }
+        uint32_t c_last_num = get_clast_number(c_last);
+        CustomerSecondary::Key c_sec_low_key =
+            CustomerSecondary::Key::create_key(w_id, d_id, c_last_num);
+        CustomerSecondary::Key c_sec_high_key =
+            CustomerSecondary::Key::create_key(w_id, d_id, c_last_num + 1);
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
+        bool scanned = protocol->read_scan(
+            get_id<CustomerSecondary>(), c_sec_low_key.get_raw_key(),
+            c_sec_high_key.get_raw_key(), -1, false, kr_list);
+        if (!scanned) return Result::ABORT;
 
-        if (recs.empty()) {
+        if (kr_list.empty()) {
             c = nullptr;
             return Result::FAIL;
         }
 
-        std::sort(recs.begin(), recs.end(), [](const Customer* lhs, const Customer* rhs) {
-            return ::strncmp(lhs->c_first, rhs->c_first, Customer::MAX_FIRST) < 0;
-        });
-
-        c = recs[(recs.size() + 1) / 2 - 1];
-        assert(c != nullptr);
-        return Result::SUCCESS;
+        const CustomerSecondary* c_sec = get_middle_customer(kr_list);
+        return get_record(c, c_sec->key);
     }
 
     Result get_customer_by_last_name_and_prepare_for_update(
@@ -163,14 +192,15 @@ public:
         OrderSecondary::Key o_sec_low_key = OrderSecondary::Key::create_key(w_id, d_id, c_id, 0);
         OrderSecondary::Key o_sec_high_key =
             OrderSecondary::Key::create_key(w_id, d_id, c_id + 1, 0);
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
 
         bool scanned = protocol->read_scan(
             get_id<OrderSecondary>(), o_sec_low_key.get_raw_key(), o_sec_high_key.get_raw_key(), -1,
-            false, kr_map);
+            false, kr_list);
 
         if (scanned) {
-            auto iter = kr_map.rbegin();
+            auto iter = kr_list.rbegin();
             assert(iter->second);
             auto o_sec = reinterpret_cast<OrderSecondary*>(iter->second);
             Order::Key o_key = o_sec->key;
@@ -181,11 +211,12 @@ public:
     }
 
     Result get_neworder_with_smallest_key_no_less_than(const NewOrder*& no, NewOrder::Key low) {
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->read_scan(
-            get_id<NewOrder>(), low.get_raw_key(), UINT64_MAX, 1, false, kr_map);
+            get_id<NewOrder>(), low.get_raw_key(), UINT64_MAX, 1, false, kr_list);
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 NewOrder::Key nk(k);
                 if (nk.w_id == low.w_id && nk.d_id == low.d_id) {
@@ -204,11 +235,12 @@ public:
     // [low ,up)
     template <typename Record, typename Func>
     Result range_query(typename Record::Key low, typename Record::Key up, Func&& func) {
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->read_scan(
-            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_map);
+            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_list);
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 Record* rec = reinterpret_cast<Record*>(r);
                 func(*rec);
@@ -222,12 +254,13 @@ public:
     // [low ,up)
     template <typename Record, typename Func>
     Result range_update(typename Record::Key low, typename Record::Key up, Func&& func) {
-        std::map<uint64_t, void*> kr_map;
+        ScanBuffer<typename Protocol::KRList> kr_buf;
+        auto& kr_list = kr_buf.get();
         bool scanned = protocol->update_scan(
-            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_map);
+            get_id<Record>(), low.get_raw_key(), up.get_raw_key(), -1, false, kr_list);
         Result res;
         if (scanned) {
-            for (auto& [k, r]: kr_map) {
+            for (auto& [k, r]: kr_list) {
                 assert(r);
                 Record* rec = reinterpret_cast<Record*>(r);
                 func(*rec);
@@ -242,4 +275,16 @@ public:
 
 private:
     std::unique_ptr<Protocol> protocol = nullptr;
+
+    // Values of the n keys found by one Protocol::lookup(), to be passed to read() and update()
+    template <typename Record>
+    const std::vector<typename Protocol::Value*>& lookup(
+        size_t n, const typename Record::Key* rec_keys) {
+        thread_local std::vector<typename Protocol::Key> keys;
+        thread_local std::vector<typename Protocol::Value*> vals;
+        keys.clear();
+        for (size_t i = 0; i < n; i++) keys.push_back(rec_keys[i].get_raw_key());
+        protocol->lookup(get_id<Record>(), keys, vals);
+        return vals;
+    }
 };
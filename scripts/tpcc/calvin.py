@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+
+import os
+import numpy as np
+import matplotlib.pyplot as plt
+
+# EXECUTE THIS SCRIPT IN BASE DIRECTORY!!!
+# Compares CALVIN (deterministic, abort-free) with SILO and NOWAIT as contention grows: the
+# workers share fewer and fewer home warehouses.
+
+NUM_EXPERIMENTS_PER_SETUP = 3
+NUM_SECONDS = 10
+NUM_THREADS = 16
+PIN = "compact"
+
+
+def get_filename(protocol, warehouses, i):
+    return "TPCC" + protocol + "T" + str(NUM_THREADS) + "W" + str(warehouses) + "S" + \
+        str(NUM_SECONDS) + ".log" + str(i)
+
+
+def gen_setups():
+    protocols = ["silo", "nowait", "calvin"]
+    warehouses = [1, 2, 4, 8, 16]
+    return [[protocol, warehouse] for protocol in protocols for warehouse in warehouses]
+
+
+def build():
+    if not os.path.exists("./build"):
+        os.mkdir("./build")  # create build
+    os.chdir("./build")
+    if not os.path.exists("./log"):
+        os.mkdir("./log")  # compile logs
+    compiled_protocol = []
+    for setup in gen_setups():
+        protocol = setup[0]
+        if (protocol not in compiled_protocol):
+            compiled_protocol.append(protocol)
+        else:
+            continue
+        print("Compiling " + protocol)
+        os.system(
+            "cmake .. -DLOG_LEVEL=0 -DCMAKE_BUILD_TYPE=Release -DBENCHMARK=TPCC -DCC_ALG=" + protocol.upper())
+        logfile = protocol + ".compile_log"
+        ret = os.system("make -j > ./log/" + logfile + " 2>&1")
+        if ret != 0:
+            print("Error. Stopping")
+            exit(0)
+    os.chdir("../")  # go back to base directory
+
+
+def run_all():
+    os.chdir("./build/bin")  # move to bin
+    if not os.path.exists("./res"):
+        os.mkdir("./res")  # create result directory inside bin
+    for setup in gen_setups():
+        protocol = setup[0]
+        warehouses = setup[1]
+        args = " " + str(warehouses) + " " + str(NUM_THREADS) + " " + str(NUM_SECONDS) + \
+            " pin=" + PIN
+        print("[" + protocol + "]" + " warehouses:" + str(warehouses))
+        for i in range(NUM_EXPERIMENTS_PER_SETUP):
+            result_file = get_filename(protocol, warehouses, i)
+            print(" Trial:" + str(i))
+            ret = os.system("./tpcc_" + protocol + args +
+                            " > ./res/" + result_file + " 2>&1")
+            if ret != 0:
+                print("Error. Stopping")
+                exit(0)
+    os.chdir("../../")  # back to base directory
+
+
+# returns (throughput, abort rate)
+def parse(result_file):
+    commits = 0
+    aborts = 0
+    throughput = 0
+    for line in open(result_file):
+        line = line.strip().split()
+        if not line:
+            continue
+        if line[0] == "commits:":
+            commits = float(line[1])
+        if line[0] == "sys_aborts:":
+            aborts = float(line[1])
+        if line[0] == "Throughput:":
+            throughput = float(line[1])
+    return throughput, aborts / (aborts + commits) if commits else 0
+
+
+def plot_all():
+    os.chdir("./build/bin/res")  # move to result file
+    if not os.path.exists("./plots"):
+        os.mkdir("./plots")  # create plot directory inside res
+    throughputs = {}
+    abort_rates = {}
+    for setup in gen_setups():
+        protocol = setup[0]
+        warehouses = setup[1]
+        average_throughput = 0
+        average_abort_rate = 0
+        for i in range(NUM_EXPERIMENTS_PER_SETUP):
+            throughput, abort_rate = parse(get_filename(protocol, warehouses, i))
+            average_throughput += throughput
+            average_abort_rate += abort_rate
+        throughputs.setdefault(protocol, []).append(
+            [warehouses, average_throughput / NUM_EXPERIMENTS_PER_SETUP])
+        abort_rates.setdefault(protocol, []).append(
+            [warehouses, average_abort_rate / NUM_EXPERIMENTS_PER_SETUP])
+
+    fig, (ax1, ax2) = plt.subplots(1, 2, figsize=(15, 4))
+    markers = ['o', 'v', 's', 'p', 'P', '*', 'X', 'D', 'd', '|', '_']
+    for j, protocol in enumerate(throughputs.keys()):
+        res = np.array(throughputs[protocol]).T
+        ax1.plot(res[0], res[1] / (10**6), markers[j] + '-', label=protocol)
+        res = np.array(abort_rates[protocol]).T
+        ax2.plot(res[0], res[1], markers[j] + '-')
+
+    for ax in (ax1, ax2):
+        ax.set_xlabel("Number of Warehouses ({} threads, {} seconds)".format(
+            NUM_THREADS, NUM_SECONDS))
+        ax.set_xscale("log", base=2)
+        ax.grid()
+    ax1.set_ylabel("Throughput (Million txns/s)")
+    ax2.set_ylabel("Abort Rate")
+    fig.legend(loc="upper center", ncol=len(throughputs.keys()))
+    fig.savefig("./plots/calvin.png")
+    print("calvin.png is saved in ./build/bin/res/plots/")
+    os.chdir("../../../")  # go back to base directory
+
+
+if __name__ == "__main__":
+    build()
+    run_all()
+    plot_all()
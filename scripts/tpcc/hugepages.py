@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+
+import os
+import numpy as np
+import matplotlib.pyplot as plt
+
+# EXECUTE THIS SCRIPT IN BASE DIRECTORY!!!
+# Compares dTLB misses and throughput of TPC-C with 4KiB, 2MiB and 1GiB pages.
+# Needs a PMU accessible by perf_event_open (perf_event_paranoid <= 2) and, for 1g,
+# free 1GiB pages (e.g. hugepagesz=1G hugepages=N on the kernel command line).
+
+NUM_EXPERIMENTS_PER_SETUP = 3
+NUM_SECONDS = 10
+NUM_THREADS = 16
+NUM_WAREHOUSES = 16
+NUM_1G_PAGES = 16
+PIN = "compact"
+
+
+def get_filename(protocol, mode, i):
+    return "TPCC" + protocol + "P" + mode + "T" + str(NUM_THREADS) + "W" + str(NUM_WAREHOUSES) + \
+        "S" + str(NUM_SECONDS) + ".log" + str(i)
+
+
+def gen_setups():
+    protocols = ["silo", "nowait", "mvto"]
+    modes = ["none", "2m", "1g"]
+    return [[protocol, mode] for protocol in protocols for mode in modes]
+
+
+def build():
+    if not os.path.exists("./build"):
+        os.mkdir("./build")  # create build
+    os.chdir("./build")
+    if not os.path.exists("./log"):
+        os.mkdir("./log")  # compile logs
+    compiled_protocol = []
+    for setup in gen_setups():
+        protocol = setup[0]
+        if (protocol not in compiled_protocol):
+            compiled_protocol.append(protocol)
+        else:
+            continue
+        print("Compiling " + protocol)
+        os.system(
+            "cmake .. -DLOG_LEVEL=0 -DCMAKE_BUILD_TYPE=Release -DBENCHMARK=TPCC -DPERF_COUNTERS=ON -DCC_ALG=" + protocol.upper())
+        logfile = protocol + ".compile_log"
+        ret = os.system("make -j > ./log/" + logfile + " 2>&1")
+        if ret != 0:
+            print("Error. Stopping")
+            exit(0)
+    os.chdir("../")  # go back to base directory
+
+
+def run_all():
+    os.chdir("./build/bin")  # move to bin
+    if not os.path.exists("./res"):
+        os.mkdir("./res")  # create result directory inside bin
+    for setup in gen_setups():
+        protocol = setup[0]
+        mode = setup[1]
+        args = " " + str(NUM_WAREHOUSES) + " " + str(NUM_THREADS) + " " + str(NUM_SECONDS) + \
+            " pin=" + PIN + " hugepages=" + mode + " huge_gib=" + str(NUM_1G_PAGES)
+        print("[" + protocol + "]" + " pages:" + mode)
+        for i in range(NUM_EXPERIMENTS_PER_SETUP):
+            result_file = get_filename(protocol, mode, i)
+            print(" Trial:" + str(i))
+            ret = os.system("./tpcc_" + protocol + args +
+                            " > ./res/" + result_file + " 2>&1")
+            if ret != 0:
+                print("Error. Stopping")
+                exit(0)
+    os.chdir("../../")  # back to base directory
+
+
+# returns (throughput, dtlb misses per commit over all transaction types)
+def parse(result_file):
+    throughput = 0
+    commits = 0
+    dtlb_misses = 0
+    in_perf = False
+    tx_commits = 0
+    dtlb_column = -1
+    for line in open(result_file):
+        line = line.strip().split()
+        if not line:
+            continue
+        if line[0] == "Throughput:":
+            throughput = float(line[1])
+        if line[0] == "Perf":
+            in_perf = True
+        if not in_perf:
+            continue
+        if line[0] == "unavailable:":
+            print("perf counters are unavailable in " + result_file)
+            exit(0)
+        if len(line) > 1 and line[1] == "commits:":
+            tx_commits = float(line[2])
+        if line[0] == "phase":
+            dtlb_column = line.index("dtlb_misses")
+        if line[0] == "total" and dtlb_column >= 0 and line[dtlb_column] != "n/a":
+            commits += tx_commits
+            dtlb_misses += float(line[dtlb_column]) * tx_commits
+    return throughput, dtlb_misses / commits if commits else 0
+
+
+def plot_all():
+    os.chdir("./build/bin/res")  # move to result file
+    if not os.path.exists("./plots"):
+        os.mkdir("./plots")  # create plot directory inside res
+    throughputs = {}
+    misses = {}
+    modes = []
+    for setup in gen_setups():
+        protocol = setup[0]
+        mode = setup[1]
+        if mode not in modes:
+            modes.append(mode)
+        average_throughput = 0
+        average_misses = 0
+        for i in range(NUM_EXPERIMENTS_PER_SETUP):
+            throughput, dtlb_misses = parse(get_filename(protocol, mode, i))
+            average_throughput += throughput
+            average_misses += dtlb_misses
+        throughputs.setdefault(protocol, []).append(average_throughput / NUM_EXPERIMENTS_PER_SETUP)
+        misses.setdefault(protocol, []).append(average_misses / NUM_EXPERIMENTS_PER_SETUP)
+        print("{:8s} {:5s} throughput: {:12.0f} dtlb_misses/commit: {:10.1f}".format(
+            protocol, mode, throughputs[protocol][-1], misses[protocol][-1]))
+
+    fig, (ax1, ax2) = plt.subplots(1, 2, figsize=(15, 4))
+    x = np.arange(len(modes))
+    width = 0.8 / len(throughputs)
+    for j, protocol in enumerate(throughputs.keys()):
+        ax1.bar(x + j * width, np.array(throughputs[protocol]) / (10**6), width, label=protocol)
+        ax2.bar(x + j * width, misses[protocol], width)
+
+    for ax in (ax1, ax2):
+        ax.set_xticks(x + width * (len(throughputs) - 1) / 2)
+        ax.set_xticklabels(modes)
+        ax.set_xlabel("Page Size ({} threads, {} warehouses, {} seconds)".format(
+            NUM_THREADS, NUM_WAREHOUSES, NUM_SECONDS))
+        ax.grid(axis="y")
+    ax1.set_ylabel("Throughput (Million txns/s)")
+    ax2.set_ylabel("dTLB Load Misses per Commit")
+    fig.legend(loc="upper center", bbox_to_anchor=(0.5, 0.94), ncol=len(throughputs.keys()))
+    fig.suptitle("(full) TPC-C with huge pages")
+    fig.tight_layout(rect=[0, 0, 1, 0.96])
+    fig.savefig("./plots/hugepages.png")
+    print("hugepages.png is saved in ./build/bin/res/plots/")
+    os.chdir("../../../")  # go back to base directory
+
+
+if __name__ == "__main__":
+    build()
+    run_all()
+    plot_all()
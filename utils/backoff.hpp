@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "utils/tsc.hpp"
+#include "utils/utils.hpp"
+
+/**
+ * Delay before retrying a transaction aborted by the concurrency control, so that workers
+ * conflicting on hot records do not hit them again right away. Delays are busy waits measured
+ * in TSC cycles, after the n-th abort in a row of the same transaction:
+ *   none:   no delay (default)
+ *   exp:    base * 2^(n-1)
+ *   random: uniformly random in [0, base * 2^(n-1)] (randomized exponential backoff)
+ *   count:  base * (n + average number of retries of the recent transactions of the worker),
+ *           so that workers that abort often wait longer even on the first retry
+ * All delays are capped at max.
+ */
+class Backoff {
+public:
+    enum Policy { NONE, EXPONENTIAL, RANDOM, ABORT_COUNT };
+
+    static void configure(const std::string& policy, uint64_t base, uint64_t max) {
+        Settings& c = get_backoff_config();
+        if (policy == "none") {
+            c.policy = NONE;
+        } else if (policy == "exp") {
+            c.policy = EXPONENTIAL;
+        } else if (policy == "random") {
+            c.policy = RANDOM;
+        } else if (policy == "count") {
+            c.policy = ABORT_COUNT;
+        } else {
+            throw std::runtime_error("unknown backoff policy: " + policy);
+        }
+        if (base == 0 || max < base) throw std::runtime_error("invalid backoff delays");
+        c.name = policy;
+        c.base = base;
+        c.max = max;
+    }
+
+    static const std::string& get_policy_name() { return get_backoff_config().name; }
+
+    // Waits before the retry following the n-th abort in a row. Returns the cycles waited.
+    static uint64_t wait(uint32_t n) {
+        const Settings& c = get_backoff_config();
+        uint64_t delay = 0;
+        switch (c.policy) {
+        case NONE: return 0;
+        case EXPONENTIAL: delay = exponential(c, n); break;
+        case RANDOM: delay = get_rand()() % (exponential(c, n) + 1); break;
+        case ABORT_COUNT:
+            delay = std::min(c.max, static_cast<uint64_t>(c.base * (n + get_avg_retries())));
+            break;
+        }
+        uint64_t start = rdtscp();
+        uint64_t now = start;
+        while (now - start < delay) now = rdtscp();
+        return now - start;
+    }
+
+    // Records the number of retries of a transaction that committed or was aborted by the user
+    static void finish(uint32_t retries) {
+        double& avg = get_avg_retries();
+        avg += (retries - avg) / 16;
+    }
+
+private:
+    struct Settings {
+        Policy policy = NONE;
+        std::string name = "none";
+        uint64_t base = 1;
+        uint64_t max = 1;
+    };
+
+    static Settings& get_backoff_config() {
+        static Settings c;
+        return c;
+    }
+
+    // Exponential moving average over the last transactions of the thread
+    static double& get_avg_retries() {
+        thread_local double avg = 0;
+        return avg;
+    }
+
+    static uint64_t exponential(const Settings& c, uint32_t n) {
+        uint32_t shift = n - 1;
+        if (shift >= 63 || c.base > (c.max >> shift)) return c.max;
+        return c.base << shift;
+    }
+};
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if COROUTINES
+#    include <array>
+#    include <coroutine>
+#    include <exception>
+#    include <stdexcept>
+#    include <utility>
+#    include <vector>
+#endif
+
+/**
+ * Coroutine mode (cmake -DCOROUTINES=ON, C++20, SILO and TPC-C only): each worker multiplexes
+ * several transactions, which suspend (co_await Yield()) after prefetching memory they need
+ * next, so that the worker runs another transaction while the memory is fetched instead of
+ * stalling. Functions on the way from a transaction to a suspension point return MaybeTask<T>,
+ * call each other with CO_AWAIT(...) and return with CO_RETURN, so that without the coroutine
+ * mode they are plain functions returning T.
+ */
+
+/**
+ * Slot of the transaction that runs on this thread among those multiplexed on it by
+ * Scheduler::run() (always 0 outside of it). Thread-local state that a transaction keeps
+ * across a suspension point is kept per slot.
+ */
+class TxSlot {
+public:
+    static constexpr uint32_t MAX = 32;
+
+    static uint32_t get() { return get_slot(); }
+
+    static void set(uint32_t slot) { get_slot() = slot; }
+
+private:
+    static uint32_t& get_slot() {
+        thread_local uint32_t slot = 0;
+        return slot;
+    }
+};
+
+#if COROUTINES
+
+/**
+ * Frames of the coroutines of a thread, recycled by size in cache lines so that running each
+ * transaction as a coroutine does not call the allocator in steady state.
+ */
+class CoroutineFrames {
+public:
+    static void* allocate(size_t size) {
+        size_t lines = get_lines(size);
+        if (lines >= MAX_LINES) return ::operator new(size);
+        std::vector<void*>& list = get_free_lists().lists[lines];
+        if (list.empty()) return ::operator new(lines * LINE_SIZE);
+        void* frame = list.back();
+        list.pop_back();
+        return frame;
+    }
+
+    static void deallocate(void* frame, size_t size) {
+        size_t lines = get_lines(size);
+        if (lines >= MAX_LINES) {
+            ::operator delete(frame);
+        } else {
+            get_free_lists().lists[lines].push_back(frame);
+        }
+    }
+
+private:
+    static constexpr size_t LINE_SIZE = 64;
+    static constexpr size_t MAX_LINES = 128;
+
+    struct FreeLists {
+        std::array<std::vector<void*>, MAX_LINES> lists;
+
+        ~FreeLists() {
+            for (auto& list: lists) {
+                for (void* frame: list) ::operator delete(frame);
+            }
+        }
+    };
+
+    static size_t get_lines(size_t size) { return (size + LINE_SIZE - 1) / LINE_SIZE; }
+
+    static FreeLists& get_free_lists() {
+        thread_local FreeLists f;
+        return f;
+    }
+};
+
+class TaskPromiseBase {
+public:
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    bool running_in_caller = false;  // resumed by the awaiting coroutine, see Task::await_suspend
+
+    // Tasks start when they are awaited
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    // and, if they suspended in between, resume the awaiting coroutine when they complete
+    // (symmetric transfer). A task that completes without suspending returns to
+    // Task::await_suspend instead.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            TaskPromiseBase& p = h.promise();
+            if (p.running_in_caller || !p.continuation) return std::noop_coroutine();
+            return p.continuation;
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+
+    static void* operator new(size_t size) { return CoroutineFrames::allocate(size); }
+
+    static void operator delete(void* frame, size_t size) {
+        CoroutineFrames::deallocate(frame, size);
+    }
+
+protected:
+    void rethrow() {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    void return_value(T v) { value = std::move(v); }
+
+    T get_result() {
+        this->rethrow();
+        return std::move(value);
+    }
+
+private:
+    T value{};
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    void return_void() {}
+
+    void get_result() { rethrow(); }
+};
+
+/**
+ * Coroutine returning T. It starts when it is awaited (co_await) and runs on the stack of the
+ * awaiting coroutine until it suspends or completes, so that nested calls cost no scheduling.
+ */
+template <typename T>
+class Task {
+public:
+    struct promise_type : public TaskPromise<T> {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    Task(Task&& other) noexcept
+        : handle(std::exchange(other.handle, nullptr)) {}
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task& operator=(Task&&) = delete;
+
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    // Runs the task until it suspends or completes and only suspends the caller in the former
+    // case, so that tasks completing without suspending (all of them outside of
+    // Scheduler::run()) do not rely on the compiler turning symmetric transfers into tail calls
+    // to keep the stack bounded
+    bool await_suspend(std::coroutine_handle<> caller) {
+        promise_type& p = handle.promise();
+        p.continuation = caller;
+        p.running_in_caller = true;
+        handle.resume();
+        p.running_in_caller = false;
+        return !handle.done();
+    }
+
+    T await_resume() { return handle.promise().get_result(); }
+
+private:
+    friend class Scheduler;
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : handle(handle) {}
+};
+
+/**
+ * Runs the transactions of a worker as coroutines on its thread. A transaction that suspends
+ * (co_await Yield()) gives the thread to the next one, in round-robin order, and is resumed
+ * where it suspended once the others have had their turn.
+ */
+class Scheduler {
+public:
+    // Runs make_task(slot) for each slot in [0, n) until all of them complete. The TxSlot of a
+    // task is set whenever it runs.
+    template <typename MakeTask>
+    static void run(uint32_t n, MakeTask&& make_task) {
+        if (n == 0 || n > TxSlot::MAX) {
+            throw std::runtime_error("unsupported number of transactions in flight");
+        }
+        State& s = get_state();
+        std::vector<Task<void>> tasks;
+        tasks.reserve(n);
+        s.resume_points.assign(n, nullptr);
+        for (uint32_t slot = 0; slot < n; slot++) {
+            tasks.push_back(make_task(slot));
+            s.resume_points[slot] = tasks[slot].handle;
+        }
+        s.interleaving = n > 1;
+
+        uint32_t running = n;
+        while (running > 0) {
+            for (uint32_t slot = 0; slot < n; slot++) {
+                std::coroutine_handle<> h = std::exchange(s.resume_points[slot], nullptr);
+                if (!h) continue;
+                TxSlot::set(slot);
+                h.resume();  // returns when the task suspends again or completes
+                if (s.resume_points[slot]) continue;
+                running--;
+                tasks[slot].handle.promise().get_result();  // rethrows what the task threw
+            }
+        }
+        s.interleaving = false;
+        TxSlot::set(0);
+    }
+
+    // Whether the running transaction shares the thread with others, so that it has to
+    // suspend to let them run
+    static bool is_interleaving() { return get_state().interleaving; }
+
+    // Called by Yield with the innermost suspended coroutine of the running transaction
+    static void suspend(std::coroutine_handle<> h) { get_state().resume_points[TxSlot::get()] = h; }
+
+private:
+    struct State {
+        std::vector<std::coroutine_handle<>> resume_points;  // per slot, nullptr once done
+        bool interleaving = false;
+    };
+
+    static State& get_state() {
+        thread_local State s;
+        return s;
+    }
+};
+
+// Suspends the running transaction, which should have prefetched the memory it needs next,
+// unless it is the only one on its thread
+class Yield {
+public:
+    bool await_ready() const noexcept { return !Scheduler::is_interleaving(); }
+
+    void await_suspend(std::coroutine_handle<> h) const noexcept { Scheduler::suspend(h); }
+
+    void await_resume() const noexcept {}
+};
+
+template <typename T>
+using MaybeTask = Task<T>;
+
+#    define CO_AWAIT(expr) (co_await (expr))
+#    define CO_RETURN co_return
+
+#else
+
+template <typename T>
+using MaybeTask = T;
+
+#    define CO_AWAIT(expr) (expr)
+#    define CO_RETURN return
+
+#endif
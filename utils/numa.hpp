@@ -0,0 +1,188 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Parses cpu lists of the form "0-3,8,10-11" (the format of sysfs cpulist files).
+inline std::vector<int> parse_cpu_list(const std::string& str) {
+    std::vector<int> cpus;
+    std::stringstream ss(str);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") continue;
+        size_t dash = range.find('-');
+        int first, last;
+        try {
+            first = std::stoi(range.substr(0, dash));
+            last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("invalid cpu list: " + str);
+        }
+        if (first < 0 || last < first) throw std::runtime_error("invalid cpu list: " + str);
+        for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/**
+ * NUMA nodes and their cpus as exposed in /sys/devices/system/node.
+ * Falls back to a single node holding all online cpus when sysfs is not available.
+ */
+class CpuTopology {
+public:
+    static const CpuTopology& get() {
+        static CpuTopology t;
+        return t;
+    }
+
+    // Nodes are numbered 0 .. get_num_nodes() - 1 here; get_node_id() gives the id of the OS.
+    size_t get_num_nodes() const { return node_cpus.size(); }
+    const std::vector<int>& get_cpus(size_t node) const { return node_cpus[node]; }
+    int get_node_id(size_t node) const { return node_ids[node]; }
+    size_t get_num_cpus() const { return num_cpus; }
+
+    // OS node id of cpu, -1 if it is not online
+    int get_node(int cpu) const {
+        if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_node.size()) return -1;
+        return cpu_node[cpu];
+    }
+
+private:
+    std::vector<std::vector<int>> node_cpus;
+    std::vector<int> node_ids;
+    std::vector<int> cpu_node;  // index: cpu id, value: node id (-1 if offline)
+    size_t num_cpus = 0;
+
+    CpuTopology() {
+        for (int node: parse_cpu_list(read_line("/sys/devices/system/node/online"))) {
+            std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+            std::vector<int> cpus = parse_cpu_list(read_line(path));
+            if (cpus.empty()) continue;  // memory-only node
+            node_cpus.emplace_back(std::move(cpus));
+            node_ids.push_back(node);
+        }
+        if (node_cpus.empty()) {
+            std::vector<int> cpus;
+            for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); i++) {
+                cpus.push_back(i);
+            }
+            node_cpus.emplace_back(std::move(cpus));
+            node_ids.push_back(0);
+        }
+        for (size_t node = 0; node < node_cpus.size(); node++) {
+            for (int cpu: node_cpus[node]) {
+                if (cpu_node.size() <= static_cast<size_t>(cpu)) cpu_node.resize(cpu + 1, -1);
+                cpu_node[cpu] = node_ids[node];
+                num_cpus++;
+            }
+        }
+    }
+
+    static std::string read_line(const std::string& path) {
+        std::ifstream f(path);
+        std::string line;
+        if (f) std::getline(f, line);
+        return line;
+    }
+};
+
+/**
+ * Assignment of worker threads to cpus.
+ *   none:    threads are not pinned
+ *   compact: fill the cpus of node 0 first, then node 1, ...
+ *   scatter: round-robin over nodes (worker i runs on node i % num_nodes)
+ *   list:    explicit cpu list such as "0,2,4-7", worker i runs on the i-th cpu
+ * If there are more workers than cpus, the assignment wraps around.
+ */
+class ThreadPinning {
+public:
+    enum Policy { NONE, COMPACT, SCATTER, EXPLICIT };
+
+    void configure(const std::string& spec, size_t num_threads) {
+        const CpuTopology& topo = CpuTopology::get();
+        std::vector<int> order;
+        if (spec.empty() || spec == "none") {
+            policy = NONE;
+        } else if (spec == "compact") {
+            policy = COMPACT;
+            for (size_t node = 0; node < topo.get_num_nodes(); node++) {
+                const auto& cpus = topo.get_cpus(node);
+                order.insert(order.end(), cpus.begin(), cpus.end());
+            }
+        } else if (spec == "scatter") {
+            policy = SCATTER;
+            for (size_t i = 0; order.size() < topo.get_num_cpus(); i++) {
+                for (size_t node = 0; node < topo.get_num_nodes(); node++) {
+                    const auto& cpus = topo.get_cpus(node);
+                    if (i < cpus.size()) order.push_back(cpus[i]);
+                }
+            }
+        } else {
+            policy = EXPLICIT;
+            order = parse_cpu_list(spec);
+            if (order.empty()) throw std::runtime_error("empty cpu list");
+            for (int cpu: order) {
+                if (topo.get_node(cpu) < 0) {
+                    throw std::runtime_error("cpu " + std::to_string(cpu) + " is not online");
+                }
+            }
+        }
+
+        worker_cpus.assign(num_threads, -1);
+        if (policy == NONE) return;
+        for (size_t i = 0; i < num_threads; i++) worker_cpus[i] = order[i % order.size()];
+    }
+
+    Policy get_policy() const { return policy; }
+    bool is_enabled() const { return policy != NONE; }
+
+    // -1 if not pinned
+    int get_cpu(size_t worker_id) const {
+        return worker_id < worker_cpus.size() ? worker_cpus[worker_id] : -1;
+    }
+
+    // -1 if not pinned
+    int get_node(size_t worker_id) const {
+        return CpuTopology::get().get_node(get_cpu(worker_id));
+    }
+
+    // Pins the calling thread to the cpu of worker_id. Returns false if it is not pinned.
+    bool pin(size_t worker_id) const {
+        int cpu = get_cpu(worker_id);
+        if (cpu < 0) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            throw std::runtime_error("failed to pin thread to cpu " + std::to_string(cpu));
+        }
+        return true;
+    }
+
+    void print() const {
+        if (policy == NONE) return;
+        printf("Pinning (%zu node(s)):", CpuTopology::get().get_num_nodes());
+        for (size_t i = 0; i < worker_cpus.size(); i++) {
+            printf(" %d:%d", worker_cpus[i], get_node(i));
+        }
+        printf("\n");
+    }
+
+private:
+    Policy policy = NONE;
+    std::vector<int> worker_cpus;
+};
+
+inline ThreadPinning& get_thread_pinning() {
+    static ThreadPinning p;
+    return p;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Optional "key=value" arguments following the positional arguments of the executables,
+ * e.g. `./tpcc_silo 2 5 20 pin=compact`.
+ */
+class Options {
+public:
+    Options(int argc, const char* argv[], int first) {
+        for (int i = first; i < argc; i++) {
+            std::string arg = argv[i];
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos || eq == 0) {
+                throw std::runtime_error("option must be key=value: " + arg);
+            }
+            values[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
+    }
+
+    bool has(const std::string& key) const { return values.count(key) > 0; }
+
+    std::string get(const std::string& key, const std::string& default_value) const {
+        auto it = values.find(key);
+        return it == values.end() ? default_value : it->second;
+    }
+
+    long get_int(const std::string& key, long default_value) const {
+        auto it = values.find(key);
+        return it == values.end() ? default_value : std::stol(it->second);
+    }
+
+    double get_double(const std::string& key, double default_value) const {
+        auto it = values.find(key);
+        return it == values.end() ? default_value : std::stod(it->second);
+    }
+
+private:
+    std::map<std::string, std::string> values;
+};
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * Thin wrapper of a perf_event_open(2) group counting user-space events of the calling thread.
+ * Nothing is opened until open() is called. If the leader (cycles) cannot be opened (no PMU,
+ * perf_event_paranoid, seccomp, ...), the group is marked unavailable and every read returns
+ * zeros. Members that cannot be opened are skipped individually and reported as unavailable.
+ */
+class PerfCounters {
+public:
+    enum Event : uint8_t {
+        CYCLES = 0,
+        INSTRUCTIONS,
+        LLC_MISSES,
+        BRANCH_MISSES,
+        L1D_READ_MISSES,
+        DTLB_READ_MISSES,
+        MAX_EVENTS,
+    };
+
+    struct Values {
+        uint64_t v[MAX_EVENTS] = {};
+
+        Values& operator+=(const Values& rhs) {
+            for (size_t i = 0; i < MAX_EVENTS; i++) v[i] += rhs.v[i];
+            return *this;
+        }
+        uint64_t operator[](size_t i) const { return v[i]; }
+    };
+
+    static constexpr const char* event_name(size_t e) {
+        constexpr const char* names[MAX_EVENTS] = {
+            "cycles", "instructions", "llc_misses", "branch_misses", "l1d_misses", "dtlb_misses"};
+        return names[e];
+    }
+
+    PerfCounters() = default;
+
+    void open() {
+        for (size_t e = 0; e < MAX_EVENTS; e++) {
+            perf_event_attr attr;
+            fill_attr(attr, static_cast<Event>(e));
+            int fd = open_event(attr, leader_fd);
+            if (e == CYCLES) {
+                if (fd < 0) {
+                    open_errno = errno;
+                    return;
+                }
+                leader_fd = fd;
+            }
+            if (fd >= 0) {
+                fds[e] = fd;
+                slot[e] = num_opened++;
+            }
+        }
+        ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    ~PerfCounters() {
+        for (int fd: fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool is_available() const { return leader_fd >= 0; }
+    bool is_available(size_t e) const { return slot[e] >= 0; }
+    int get_errno() const { return open_errno; }
+
+    void read(Values& out) {
+        if (leader_fd < 0) return;
+        // layout with PERF_FORMAT_GROUP: nr, time_enabled, time_running, values[nr]
+        uint64_t buf[3 + MAX_EVENTS];
+        ssize_t n = ::read(leader_fd, buf, sizeof(buf));
+        if (n < static_cast<ssize_t>(3 * sizeof(uint64_t))) return;
+        time_enabled = buf[1];
+        time_running = buf[2];
+        for (size_t e = 0; e < MAX_EVENTS; e++) {
+            if (slot[e] >= 0) out.v[e] = buf[3 + slot[e]];
+        }
+    }
+
+    // false if the PMU had to multiplex the group (values are then underestimated)
+    bool was_always_running() const { return time_enabled == time_running; }
+
+private:
+    int leader_fd = -1;
+    int open_errno = 0;
+    int num_opened = 0;
+    int fds[MAX_EVENTS] = {-1, -1, -1, -1, -1, -1};   // every event opened, leader included
+    int slot[MAX_EVENTS] = {-1, -1, -1, -1, -1, -1};  // position in the values read
+    uint64_t time_enabled = 0;
+    uint64_t time_running = 0;
+
+    static int open_event(perf_event_attr& attr, int group_fd) {
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+
+    static void fill_attr(perf_event_attr& attr, Event e) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.disabled = (e == CYCLES);  // only the leader starts disabled
+        attr.read_format =
+            PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        auto cache_event = [](uint64_t cache, uint64_t op, uint64_t result) {
+            return cache | (op << 8) | (result << 16);
+        };
+        switch (e) {
+        case CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case L1D_READ_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_event(
+                PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case DTLB_READ_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_event(
+                PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        default: break;
+        }
+    }
+};
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <cassert>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "utils/perf_counter.hpp"
+#include "utils/tsc.hpp"
+
+#ifndef PERF_COUNTERS
+#    define PERF_COUNTERS 0
+#endif
+
+#ifndef PHASE_TIMER
+#    define PHASE_TIMER 0
+#endif
+
+// Phases of a transaction attempt. Protocols mark the boundaries with PROFILE_PHASE(), and
+// everything from PROFILE_TX_BEGIN() to the first boundary is accounted to READ (execution).
+enum class ProfilePhase : uint8_t {
+    READ = 0,       // execution phase (reads, local writes, locking in pessimistic protocols)
+    LOCK,           // lock write set
+    VALIDATE,       // validate read set
+    VALIDATE_NODE,  // validate node set (phantom protection)
+    WRITE,          // write to shared memory and release locks
+    ABORT,          // rollback
+    MAX,
+};
+
+/**
+ * Per-thread accumulation of per-phase costs of each transaction type.
+ * Two independent sources can be compiled in (see CMakeLists.txt):
+ *   -DPERF_COUNTERS=1: hardware performance counters, summed over all attempts.
+ *   -DPHASE_TIMER=1: rdtscp cycles, split by whether the attempt committed or aborted.
+ * Each thread accumulates into its own profile without synchronization; profiles are merged
+ * when printed. With both switches off, the PROFILE_* macros expand to nothing.
+ */
+class PhaseProfiler {
+public:
+    static constexpr size_t MAX_TX_TYPES = 8;
+    static constexpr size_t NUM_PHASES = static_cast<size_t>(ProfilePhase::MAX);
+
+    static constexpr const char* phase_name(size_t p) {
+        constexpr const char* names[NUM_PHASES] = {"read",          "lock",  "validate",
+                                                   "validate_node", "write", "abort"};
+        return names[p];
+    }
+
+    static void begin_tx(uint8_t tx_type, const char* tx_name) {
+        ThreadProfile& t = get_thread_profile();
+        assert(tx_type < MAX_TX_TYPES);
+        t.names[tx_type] = tx_name;
+        t.cur_type = tx_type;
+        t.cur_phase = static_cast<uint8_t>(ProfilePhase::READ);
+        if constexpr (PERF_COUNTERS) t.counters.read(t.last);
+        if constexpr (PHASE_TIMER) {
+            memset(t.attempt, 0, sizeof(t.attempt));
+            t.last_tsc = rdtscp();
+        }
+    }
+
+    static void switch_phase(ProfilePhase phase) {
+        ThreadProfile& t = get_thread_profile();
+        t.account();
+        t.cur_phase = static_cast<uint8_t>(phase);
+    }
+
+    static void end_tx(bool committed) {
+        ThreadProfile& t = get_thread_profile();
+        t.account();
+        PerType& pt = t.per_type[t.cur_type];
+        pt.num_attempts++;
+        if (committed) pt.num_commits++;
+        if constexpr (PHASE_TIMER) {
+            uint64_t* cycles = committed ? pt.committed_cycles : pt.aborted_cycles;
+            for (size_t p = 0; p < NUM_PHASES; p++) cycles[p] += t.attempt[p];
+        }
+    }
+
+    static void print() {
+        std::lock_guard<std::mutex> lg(get_mutex());
+        auto& profiles = get_profiles();
+        if (profiles.empty()) return;
+        if constexpr (PHASE_TIMER) print_phase_timer(profiles);
+        if constexpr (PERF_COUNTERS) print_perf_counters(profiles);
+    }
+
+private:
+    struct PerType {
+        uint64_t num_attempts = 0;
+        uint64_t num_commits = 0;
+        PerfCounters::Values phases[NUM_PHASES];
+        uint64_t committed_cycles[NUM_PHASES] = {};
+        uint64_t aborted_cycles[NUM_PHASES] = {};
+    };
+
+    struct ThreadProfile {
+        PerfCounters counters;
+        PerfCounters::Values last;
+        uint64_t last_tsc = 0;
+        uint64_t attempt[NUM_PHASES] = {};  // cycles of the ongoing attempt
+        uint8_t cur_type = 0;
+        uint8_t cur_phase = 0;
+        const char* names[MAX_TX_TYPES] = {};
+        PerType per_type[MAX_TX_TYPES];
+
+        void account() {
+            if constexpr (PHASE_TIMER) {
+                uint64_t now = rdtscp();
+                attempt[cur_phase] += now - last_tsc;
+                last_tsc = now;
+            }
+            if constexpr (PERF_COUNTERS) {
+                if (!counters.is_available()) return;
+                PerfCounters::Values now;
+                counters.read(now);
+                PerfCounters::Values& acc = per_type[cur_type].phases[cur_phase];
+                for (size_t e = 0; e < PerfCounters::MAX_EVENTS; e++) {
+                    acc.v[e] += now.v[e] - last.v[e];
+                }
+                last = now;
+            }
+        }
+
+        void merge(const ThreadProfile& rhs) {
+            for (size_t tt = 0; tt < MAX_TX_TYPES; tt++) {
+                if (rhs.names[tt]) names[tt] = rhs.names[tt];
+                PerType& l = per_type[tt];
+                const PerType& r = rhs.per_type[tt];
+                l.num_attempts += r.num_attempts;
+                l.num_commits += r.num_commits;
+                for (size_t p = 0; p < NUM_PHASES; p++) {
+                    l.phases[p] += r.phases[p];
+                    l.committed_cycles[p] += r.committed_cycles[p];
+                    l.aborted_cycles[p] += r.aborted_cycles[p];
+                }
+            }
+        }
+    };
+
+    using Profiles = std::vector<std::unique_ptr<ThreadProfile>>;
+
+    static void print_phase_timer(const Profiles& profiles) {
+        ThreadProfile total;
+        for (auto& t: profiles) total.merge(*t);
+
+        printf("\nPhase Breakdown (avg cycles per attempt):\n");
+        printf("    %-11s %-9s %10s", "", "", "attempts");
+        for (size_t p = 0; p < NUM_PHASES; p++) printf("%14s", phase_name(p));
+        printf("%14s\n", "total");
+        for (size_t tt = 0; tt < MAX_TX_TYPES; tt++) {
+            const PerType& pt = total.per_type[tt];
+            if (pt.num_attempts == 0) continue;
+            uint64_t num_aborts = pt.num_attempts - pt.num_commits;
+            auto print_row = [&](const char* label, uint64_t n, const uint64_t* cycles) {
+                printf("    %-11s %-9s %10" PRIu64, total.names[tt], label, n);
+                uint64_t sum = 0;
+                for (size_t p = 0; p < NUM_PHASES; p++) {
+                    printf("%14.0lf", n ? cycles[p] / static_cast<double>(n) : 0.0);
+                    sum += cycles[p];
+                }
+                printf("%14.0lf\n", n ? sum / static_cast<double>(n) : 0.0);
+            };
+            print_row("committed", pt.num_commits, pt.committed_cycles);
+            print_row("aborted", num_aborts, pt.aborted_cycles);
+        }
+    }
+
+    static void print_perf_counters(const Profiles& profiles) {
+        ThreadProfile total;
+        const PerfCounters* c = nullptr;
+        size_t unavailable = 0;
+        int err = 0;
+        bool multiplexed = false;
+        for (auto& t: profiles) {
+            if (!t->counters.is_available()) {
+                unavailable++;
+                err = t->counters.get_errno();
+                continue;
+            }
+            if (!c) c = &t->counters;
+            multiplexed |= !t->counters.was_always_running();
+            total.merge(*t);
+        }
+
+        printf("\nPerf Counters (per commit):\n");
+        if (unavailable == profiles.size()) {
+            printf("    unavailable: %s\n", strerror(err));
+            return;
+        }
+        if (unavailable > 0) printf("    unavailable on %zu thread(s)\n", unavailable);
+        if (multiplexed) {
+            printf("    WARNING: counters were multiplexed, values are underestimated\n");
+        }
+
+        for (size_t tt = 0; tt < MAX_TX_TYPES; tt++) {
+            const PerType& pt = total.per_type[tt];
+            if (pt.num_attempts == 0) continue;
+            double commits = pt.num_commits ? pt.num_commits : 1;
+            printf(
+                "    %-11s commits:%10" PRIu64 "  attempts:%10" PRIu64 "\n", total.names[tt],
+                pt.num_commits, pt.num_attempts);
+            printf("        %-14s", "phase");
+            for (size_t e = 0; e < PerfCounters::MAX_EVENTS; e++) {
+                printf("%15s", PerfCounters::event_name(e));
+            }
+            printf("%8s\n", "ipc");
+            PerfCounters::Values sum;
+            for (size_t p = 0; p < NUM_PHASES + 1; p++) {
+                const PerfCounters::Values& v = (p < NUM_PHASES) ? pt.phases[p] : sum;
+                printf("        %-14s", (p < NUM_PHASES) ? phase_name(p) : "total");
+                for (size_t e = 0; e < PerfCounters::MAX_EVENTS; e++) {
+                    if (c->is_available(e)) {
+                        printf("%15.1lf", v[e] / commits);
+                    } else {
+                        printf("%15s", "n/a");
+                    }
+                }
+                double cycles = v[PerfCounters::CYCLES];
+                printf("%8.2lf\n", cycles ? v[PerfCounters::INSTRUCTIONS] / cycles : 0.0);
+                if (p < NUM_PHASES) sum += v;
+            }
+        }
+    }
+
+    static ThreadProfile& get_thread_profile() {
+        thread_local ThreadProfile* t = register_thread();
+        return *t;
+    }
+
+    // Profiles outlive worker threads so that they can be printed after join().
+    static ThreadProfile* register_thread() {
+        std::lock_guard<std::mutex> lg(get_mutex());
+        get_profiles().emplace_back(std::make_unique<ThreadProfile>());
+        ThreadProfile* t = get_profiles().back().get();
+        if constexpr (PERF_COUNTERS) t->counters.open();
+        return t;
+    }
+
+    static Profiles& get_profiles() {
+        static Profiles profiles;
+        return profiles;
+    }
+
+    static std::mutex& get_mutex() {
+        static std::mutex m;
+        return m;
+    }
+};
+
+#if PERF_COUNTERS || PHASE_TIMER
+#    define PROFILE_TX_BEGIN(tx_type, tx_name) PhaseProfiler::begin_tx(tx_type, tx_name)
+#    define PROFILE_PHASE(phase) PhaseProfiler::switch_phase(ProfilePhase::phase)
+#    define PROFILE_TX_END(committed) PhaseProfiler::end_tx(committed)
+#    define PROFILE_PRINT() PhaseProfiler::print()
+#else
+#    define PROFILE_TX_BEGIN(tx_type, tx_name) ((void)0)
+#    define PROFILE_PHASE(phase) ((void)0)
+#    define PROFILE_TX_END(committed) ((void)0)
+#    define PROFILE_PRINT() ((void)0)
+#endif